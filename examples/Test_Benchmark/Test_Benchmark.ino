@@ -0,0 +1,261 @@
+//*****************************************************************************************************
+//
+// File:      Test_Benchmark.ino
+// Author:    Aiko Pras
+// History:   2025/07/01
+//
+// Measures, in CPU clock cycles, the time needed by the most important parts of the library:
+// - the ISR (ServoHandler), per slot, for 1 to 3 servos on TCA0 and (if available) on TCA1, and
+//   the ISR of TCA0 while TCA1 follows it (followTCA0()), thus handling the slots of both timers
+// - writeMicroseconds()
+// - initCurveFromPROGMEM() for every predefined curve, and initCurveFromEEPROM()
+// - ServoMoba::checkServo() in each state (idle, start, moving and finish), and between frames.
+//   The moving state includes the time needed by fillSegment(), if a new segment starts.
+//
+// A TCB timer, clocked by the CPU clock, is used as cycle counter. Functions are measured with
+// interrupts disabled, so other interrupts (such as millis) do not disturb the results. The ISR is
+// measured by waiting, with interrupts disabled, till the TCA overflow flag gets set. The time
+// between enabling the interrupts and the first instruction after the ISR is measured; the time
+// needed for that same sequence without pending interrupt is subtracted.
+//
+// The results are printed on Serial1 in CSV format, one line per item:
+//   item,timer,servos,label,min,max,avg,count
+// To compare two runs, see extras/Python/compare-benchmark.py. To measure at other clock
+// frequencies, select another clock speed in the Arduino IDE and upload again; F_CPU is part of
+// the output.
+//
+// Make sure you connect the servo's to supported pins:
+// See: extras/ProcessorsAndPins.md
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Servo_TCA0_MoBa.h>
+#if defined(TCA1)
+#include <Servo_TCA1_MoBa.h>
+#endif
+
+#define CYCLE_COUNTER TCB0   // Should not be the timer used for millis()
+#define REPEAT 30            // Number of measurements per item
+
+ServoMoba  servo0;           // Instantiate the three servo's on TCA0
+ServoMoba  servo1;
+ServoMoba  servo2;
+#if defined(TCA1)
+ServoMoba1 servo3;           // Instantiate the three servo's on TCA1
+ServoMoba1 servo4;
+ServoMoba1 servo5;
+#endif
+
+typedef struct {
+  uint16_t min;
+  uint16_t max;
+  uint32_t sum;
+  uint16_t count;
+} result_t;
+
+uint16_t overhead;           // Cycles needed by measure() itself
+uint16_t isrOverhead;        // Cycles needed by measureISR() itself, without ISR
+
+
+//******************************************************************************************************
+// Measurement functions
+//******************************************************************************************************
+void startCycleCounter() {
+  CYCLE_COUNTER.CTRLA = 0;
+  CYCLE_COUNTER.CTRLB = TCB_CNTMODE_INT_gc;      // Periodic interrupt mode, but without interrupt
+  CYCLE_COUNTER.CCMP = 0xFFFF;
+  CYCLE_COUNTER.CNT = 0;
+  CYCLE_COUNTER.CTRLA = TCB_ENABLE_bm;           // CLKSEL = 0: the CPU (peripheral) clock
+}
+
+template <typename F> uint16_t measure(F function) {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t start = CYCLE_COUNTER.CNT;
+  function();
+  uint16_t stop = CYCLE_COUNTER.CNT;
+  SREG = oldSREG;
+  uint16_t cycles = stop - start;
+  return (cycles > overhead) ? cycles - overhead : 0;
+}
+
+uint16_t measureISR(TCA_SINGLE_t &timer, bool waitForOverflow) {
+  cli();
+  if (waitForOverflow) {
+    while (!(timer.INTFLAGS & TCA_SINGLE_OVF_bm)) delayMicroseconds(1);
+  }
+  uint16_t start = CYCLE_COUNTER.CNT;
+  sei();                                         // The ISR starts after the next instruction
+  uint16_t stop = CYCLE_COUNTER.CNT;
+  uint16_t cycles = stop - start;
+  return (cycles > isrOverhead) ? cycles - isrOverhead : 0;
+}
+
+void clearResult(result_t &result) {
+  result.min = 0xFFFF;
+  result.max = 0;
+  result.sum = 0;
+  result.count = 0;
+}
+
+void addResult(result_t &result, uint16_t cycles) {
+  if (cycles < result.min) result.min = cycles;
+  if (cycles > result.max) result.max = cycles;
+  result.sum += cycles;
+  result.count++;
+}
+
+void printResult(const char *item, const char *timer, uint8_t servos, const char *label, result_t &result) {
+  if (result.count == 0) return;
+  Serial1.printf("%s,%s,%u,%s,%u,%u,%lu,%u\n", item, timer, servos, label, result.min, result.max,
+    (unsigned long)(result.sum / result.count), result.count);
+}
+
+
+//******************************************************************************************************
+// The individual benchmarks
+//******************************************************************************************************
+// The ISR, per slot. The slot is identified by the servo that received its pulse in that ISR.
+// readyServos() is called with interrupts disabled, to clear the bits of earlier ISR calls.
+void benchmarkISR_TCA0(uint8_t servos, const char *timer = "TCA0") {
+  result_t slot[4];                              // servo 0, 1, 2, or a slot without servo
+  for (uint8_t i = 0; i < 4; i++) clearResult(slot[i]);
+  for (uint8_t i = 0; i < 3 * REPEAT; i++) {
+    cli();
+    Servo::readyServos();
+    uint16_t cycles = measureISR(TCA0.SINGLE, true);
+    uint8_t ready = Servo::readyServos();
+    uint8_t index = 3;
+    for (uint8_t servo = 0; servo < 3; servo++) if (ready & (1 << servo)) index = servo;
+    addResult(slot[index], cycles);
+  }
+  const char *labels[4] = {"servo0", "servo1", "servo2", "free"};
+  for (uint8_t i = 0; i < 4; i++) printResult("isr", timer, servos, labels[i], slot[i]);
+}
+
+#if defined(TCA1)
+void benchmarkISR_TCA1(uint8_t servos) {
+  result_t slot[4];                              // servo 3, 4, 5, or a slot without servo
+  for (uint8_t i = 0; i < 4; i++) clearResult(slot[i]);
+  for (uint8_t i = 0; i < 3 * REPEAT; i++) {
+    cli();
+    Servo1::readyServos();
+    uint16_t cycles = measureISR(TCA1.SINGLE, true);
+    uint8_t ready = Servo1::readyServos();
+    uint8_t index = 3;
+    for (uint8_t servo = 0; servo < 3; servo++) if (ready & (1 << servo)) index = servo;
+    addResult(slot[index], cycles);
+  }
+  const char *labels[4] = {"servo3", "servo4", "servo5", "free"};
+  for (uint8_t i = 0; i < 4; i++) printResult("isr", "TCA1", servos, labels[i], slot[i]);
+}
+#endif
+
+void benchmarkWrite() {
+  result_t result;
+  clearResult(result);
+  for (uint8_t i = 0; i < REPEAT; i++) {
+    addResult(result, measure([]() {servo0.writeMicroseconds(1500);}));
+  }
+  printResult("writeMicroseconds", "TCA0", 1, "1500us", result);
+}
+
+void benchmarkInitCurve() {
+  char label[12];
+  for (uint8_t curve = 0; curve <= NUMBER_OF_LAST_CURVE; curve++) {
+    result_t result;
+    clearResult(result);
+    for (uint8_t i = 0; i < REPEAT; i++) {
+      addResult(result, measure([=]() {servo0.initCurveFromPROGMEM(curve, 1);}));
+    }
+    snprintf(label, sizeof(label), "curve%u", curve);
+    printResult("initCurveFromPROGMEM", "TCA0", 1, label, result);
+  }
+  EEPROM.update(100,   0);                       // The same curve as in Test_Servo_Moba
+  EEPROM.update(101,  40);
+  EEPROM.update(102,   2);
+  EEPROM.update(103, 100);
+  EEPROM.update(104,   4);
+  EEPROM.update(105, 200);
+  EEPROM.update(106,   0);
+  EEPROM.update(107,   0);
+  result_t result;
+  clearResult(result);
+  for (uint8_t i = 0; i < REPEAT; i++) {
+    addResult(result, measure([]() {servo0.initCurveFromEEPROM(0, 1, 100);}));
+  }
+  printResult("initCurveFromEEPROM", "TCA0", 1, "3points", result);
+}
+
+// checkServo() in each of the states. A single movement along move_A, with two pulses before and
+// after moving, is used. Between frames, checkServo() only checks if a new pulse has started.
+void benchmarkCheckServo() {
+  result_t state[5];                             // idle, start, moving, finish, between frames
+  for (uint8_t i = 0; i < 5; i++) clearResult(state[i]);
+  servo0.initPulse(ServoMoba::low, 2, 2, 1500);
+  servo0.initCurveFromPROGMEM(2, 1);
+  for (uint8_t run = 0; run < 3; run++) {
+    servo0.moveServoAlongCurve(run & 1);
+    uint8_t idleFrames = 0;
+    while (idleFrames < 3) {
+      while (!servo0.acceptsNewValue()) {
+        addResult(state[4], measure([]() {servo0.checkServo();}));
+        delayMicroseconds(50);
+      }
+      uint8_t current = servo0.getServoState();
+      addResult(state[current], measure([]() {servo0.checkServo();}));
+      if (servo0.movementCompleted) idleFrames++;
+    }
+  }
+  const char *labels[5] = {"idle", "start", "moving", "finish", "noFrame"};
+  for (uint8_t i = 0; i < 5; i++) printResult("checkServo", "TCA0", 1, labels[i], state[i]);
+}
+
+
+//******************************************************************************************************
+void setup() {
+  Serial1.begin(115200);
+  delay(1000);
+  startCycleCounter();
+  overhead = 0;                                  // The minimum of a couple of empty measurements
+  isrOverhead = 0;
+  uint16_t emptyFunction = 0xFFFF;
+  uint16_t emptyISR = 0xFFFF;
+  for (uint8_t i = 0; i < 8; i++) {
+    uint16_t cycles = measure([]() {});
+    if (cycles < emptyFunction) emptyFunction = cycles;
+    cycles = measureISR(TCA0.SINGLE, false);
+    if (cycles < emptyISR) emptyISR = cycles;
+  }
+  overhead = emptyFunction;
+  isrOverhead = emptyISR;
+  Serial1.printf("# F_CPU=%lu\n", (unsigned long)F_CPU);
+  Serial1.printf("item,timer,servos,label,min,max,avg,count\n");
+  // The ISR with 1, 2 and 3 servos on TCA0. Then 3 servos on TCA1 (thus 4, 5 and 6 in total)
+  servo0.attach(PIN_PB0);
+  benchmarkISR_TCA0(1);
+  servo1.attach(PIN_PB1);
+  benchmarkISR_TCA0(2);
+  servo2.attach(PIN_PB2);
+  benchmarkISR_TCA0(3);
+  #if defined(TCA1)
+  servo3.attach(PIN_PC4);
+  benchmarkISR_TCA1(4);
+  servo4.attach(PIN_PC5);
+  benchmarkISR_TCA1(5);
+  servo5.attach(PIN_PC6);
+  benchmarkISR_TCA1(6);
+  Servo1::followTCA0(2400);                      // The ISR of TCA0 also handles the slots of TCA1
+  benchmarkISR_TCA0(6, "TCA0+TCA1");
+  Servo1::followTCA0(FOLLOW_OFF);
+  #endif
+  benchmarkWrite();
+  benchmarkInitCurve();
+  benchmarkCheckServo();
+  Serial1.printf("# done\n");
+}
+
+
+void loop() {
+}
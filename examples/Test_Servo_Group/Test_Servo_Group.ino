@@ -0,0 +1,72 @@
+//*****************************************************************************************************
+//
+// File:      Test_Servo_Group.ino
+// Author:    Aiko Pras
+// History:   2025/07/01 
+//
+// Skeleton sketch of how to use a ServoGroup. Instead of calling checkServo() for every servo, the 
+// main loop calls checkServos() once for the entire group. Only the servos whose 20ms frame has just
+// started are serviced.
+//
+// This sketch uses the TCA0, as well as the TCA1 class, thus supporting 6 servos in total.
+// It therefore requires a DxCore processor that has TCA1: thus a processor with 48 or 64 pins
+//
+// Make sure you connect the servo's to supported pins: 
+// See: extras/ProcessorsAndPins.md
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA_Group.h>
+
+ServoMoba  servo0;           // Instantiate the three servo's on TCA0
+ServoMoba  servo1;
+ServoMoba  servo2;
+ServoMoba1 servo3;           // Instantiate the three servo's on TCA1
+ServoMoba1 servo4;
+ServoMoba1 servo5;
+
+ServoGroup servos;           // The group that will service all six servos
+
+
+void setup() {
+  servo0.attach(PIN_PB0);
+  servo1.attach(PIN_PB1);
+  servo2.attach(PIN_PB2);
+  servo3.attach(PIN_PC4);
+  servo4.attach(PIN_PC5);
+  servo5.attach(PIN_PC6);
+
+  servos.add(servo0);
+  servos.add(servo1);
+  servos.add(servo2);
+  servos.add(servo3);
+  servos.add(servo4);
+  servos.add(servo5);
+
+  servo0.initCurveFromPROGMEM(2, 4);
+  servo1.initCurveFromPROGMEM(4, 4);
+  servo2.initCurveFromPROGMEM(6, 4);
+  servo3.initCurveFromPROGMEM(2, 8);
+  servo4.initCurveFromPROGMEM(4, 8);
+  servo5.initCurveFromPROGMEM(6, 8);
+}
+
+
+// Parameters for the main loop
+unsigned long lastMillis;
+uint8_t dir;
+
+void loop() { 
+  if ((millis() - lastMillis) > 2500) {
+    lastMillis = millis();
+    servo0.queueMove(KEEP_CURVE, dir, 0, 0);
+    servo1.queueMove(KEEP_CURVE, dir, 0, 0);
+    servo2.queueMove(KEEP_CURVE, dir, 0, 0);
+    servo3.queueMove(KEEP_CURVE, dir, 0, 0);
+    servo4.queueMove(KEEP_CURVE, dir, 0, 0);
+    servo5.queueMove(KEEP_CURVE, dir, 0, 0);
+    if (dir > 0) dir = 0; 
+      else dir = 1;
+  }
+  servos.checkServos();
+}
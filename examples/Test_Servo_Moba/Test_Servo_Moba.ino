@@ -57,11 +57,6 @@ void setup() {
   pinMode(PIN_PE1, OUTPUT);
   pinMode(PIN_PE2, OUTPUT);
 
-  pinMode(PIN_PD4, OUTPUT);
-  pinMode(PIN_PD5, OUTPUT);
-  pinMode(PIN_PD6, OUTPUT);
-  pinMode(PIN_PD7, OUTPUT);
-
   // ==========================================================
   // We may initialise the pulse width before we do the attach.
   servo0.constantOutput(0);
@@ -74,9 +69,15 @@ void setup() {
   // If the servo should not receive pulses while idle, how many pulses must 
   // still be generated before and after the servo movement?
   // The first parameter may take the values continuous, high or low.
-  servo0.initPulse(ServoMoba::low, 1, 1);
-  // servo1.initPulse(ServoMoba::continuous, 1, 1);
-  // servo2.initPulse(ServoMoba::low, 1, 1);
+  // The last parameter is the pulse width (in us) for the pulses after startup.
+  servo0.initPulse(ServoMoba::low, 1, 1, 1500);
+  // servo1.initPulse(ServoMoba::continuous, 1, 1, 1500);
+  // servo2.initPulse(ServoMoba::low, 1, 1, 1500);
+
+  // ==========================================================================
+  // Optionally, the position at the end of each movement can be stored in EEPROM.
+  // After power-up the servo then starts at that position, instead of initialPulseWidth.
+  // servo0.initJournal(200, 8);
 
   // ==========================================================================
   // If present, initialise the hardware that controls the servo's 5V power pin
@@ -128,4 +129,6 @@ void loop() {
   servo0.checkServo();
   // servo1.checkServo();
   // servo2.checkServo();
+  // If SERVO_TRACE is defined (see TCA_Trace/trace.h), print the ISR and state machine events
+  ServoTrace::dump(Serial1);
 }
@@ -0,0 +1,46 @@
+//*****************************************************************************************************
+//
+// File:      Test_Servo_Pool.ino
+// Author:    Aiko Pras
+// History:   2025/07/01 
+//
+// Skeleton sketch of how to use a ServoMobaPool. The sketch doesn't decide which timer drives a
+// servo: the pool tries TCA0 first, and TCA1 if TCA0 can't drive the pin. Servos are addressed by
+// their pool index, which follows the order of the attach() calls.
+//
+// With the pins below, PB0..PB2 end up at TCA0, and PC4..PC6 (which TCA0 can't drive once it uses
+// PORTB) at TCA1. It therefore requires a DxCore processor that has TCA1: thus a processor with 48 
+// or 64 pins
+//
+// Make sure you connect the servo's to supported pins: 
+// See: extras/ProcessorsAndPins.md
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA_Pool.h>
+
+ServoMobaPool servos;        // Holds the ServoMoba and ServoMoba1 objects; don't declare any others
+
+const uint8_t pins[] = {PIN_PB0, PIN_PC4, PIN_PB1, PIN_PC5, PIN_PB2, PIN_PC6};
+
+
+void setup() {
+  for (uint8_t i = 0; i < sizeof(pins); i++) servos.attach(pins[i]);
+  servos.forEach([](auto &servo) {servo.initCurveFromPROGMEM(2, 4);});
+  servos.with(1, [](auto &servo) {servo.initCurveFromPROGMEM(4, 8);});
+}
+
+
+// Parameters for the main loop
+unsigned long lastMillis;
+uint8_t dir;
+
+void loop() { 
+  if ((millis() - lastMillis) > 2500) {
+    lastMillis = millis();
+    servos.forEach([](auto &servo) {servo.queueMove(KEEP_CURVE, dir, 0, 0);});
+    if (dir > 0) dir = 0; 
+      else dir = 1;
+  }
+  servos.checkServos();
+}
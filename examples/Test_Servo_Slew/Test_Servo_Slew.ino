@@ -0,0 +1,40 @@
+//*****************************************************************************************************
+//
+// File:      Test_Servo_Slew.ino
+// Author:    Aiko Pras
+// History:   2025/07/01
+//
+// Slow sweeps without ServoMoba and without intermediate writes from the main loop. Each servo gets
+// a maximum speed; after a write the ISR moves the servo towards the new position, one step per
+// 20 ms frame. The main loop only writes the next end position once isMoving() returns false.
+//
+// Make sure you connect the servo's to supported pins:
+// See: extras/ProcessorsAndPins.md
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA0.h>      // For objects of the servo class (TCA0)
+
+Servo  servo0;
+Servo  servo1;
+
+
+void setup() {
+  servo0.writeMicroseconds(1000);    // Before attach(): the start position, not limited
+  servo1.writeMicroseconds(1500);
+  servo0.attach(PIN_PA0);
+  servo1.attach(PIN_PA1);
+  servo0.setMaxSlew(500);            // 500 us per second: 1000 to 2000 us in 2 seconds
+}
+
+
+void loop() {
+  if (!servo0.isMoving()) {
+    if (servo0.readMicroseconds() < 1500) servo0.writeMicroseconds(2000);
+      else servo0.writeMicroseconds(1000);
+  }
+  if (!servo1.isMoving()) {          // Sets the limit and writes in one call
+    if (servo1.readMicroseconds() < 1500) servo1.writeMicroseconds(2000, 2000);
+      else servo1.writeMicroseconds(1000, 100);
+  }
+}
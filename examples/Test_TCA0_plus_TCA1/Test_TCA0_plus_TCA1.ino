@@ -46,9 +46,10 @@ void setup() {
   servo1.attach(PIN_PB1);
   servo2.attach(PIN_PB2);
 
-  // Wait 2ms, to ensure there is a time difference between the pulses for servos 0..2,
-  // and servos 3..5. This difference may be useful to limit the maximum current draw.
-  delay(2);
+  // Let TCA1 follow TCA0, such that the pulses of servos 3..5 start 2.5 ms after those of
+  // servos 0..2. The pulses never overlap, which limits the maximum current draw.
+  // The ISR of TCA0 now handles both timers.
+  Servo1::followTCA0(2500);
 
   // Attach the second 3 servo's (connected to TCA1)
   servo3.attach(PIN_PC4);
@@ -0,0 +1,80 @@
+//******************************************************************************************************
+//
+// file:      calibrationRead.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Test of setCalibration() on the host model. The program checks:
+//            - that a calibrated servo outputs the calibrated pulse width
+//            - that readMicroseconds() and read() of a calibrated servo return the value as written,
+//              for TCA0 and TCA1
+//            - that the calibration is not part of the servo objects
+//            Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA0.h>
+#include <Servo_TCA1.h>
+#include "host_model.h"
+
+Servo  servo0;
+Servo  servo1;
+Servo1 servo3;
+
+ServoCalibration calibration;
+const calibrationPoint_t measurements[] = {{1000, 1040}, {1500, 1500}, {2000, 1950}};
+
+
+//******************************************************************************************************
+// Pulses of the calibrated width on CMP0 of each timer, via the onUpdate hook
+//******************************************************************************************************
+static uint32_t pulses[2];
+
+static void onUpdate(uint8_t timer, TCA_SINGLE_t *r) {
+  if (r->CMP0 == calibration.toTicks(1000)) pulses[timer]++;
+}
+
+
+//******************************************************************************************************
+static void testOutput() {
+  CHECK(calibration.fromPoints(measurements, 3));
+  CHECK(calibration.toTicks(1000) != hostTicks(1000));
+  servo0.attach(PIN_PD0);
+  servo1.attach(PIN_PD1);
+  servo3.attach(PIN_PC4);
+  servo0.setCalibration(&calibration);
+  servo3.setCalibration(&calibration);
+  servo0.writeMicroseconds(1000);
+  servo1.writeMicroseconds(1000);
+  servo3.writeMicroseconds(1000);
+  hostAdvance(100000);
+  pulses[0] = pulses[1] = 0;
+  hostAdvance(1000000);
+  printf("calibrated pulses: TCA0 %u, TCA1 %u\n", pulses[0], pulses[1]);
+  CHECK((pulses[0] >= 49) && (pulses[0] <= 51));
+  CHECK((pulses[1] >= 49) && (pulses[1] <= 51));
+}
+
+static void testRead() {
+  CHECK(servo0.readMicroseconds() == 1000);                            // Not the calibrated width
+  CHECK(servo1.readMicroseconds() == 1000);                            // Not calibrated
+  CHECK(servo3.readMicroseconds() == 1000);
+  servo0.write(45);
+  servo3.write(135);
+  printf("read: %d %d\n", servo0.read(), servo3.read());
+  CHECK((servo0.read() == 45) && (servo3.read() == 135));
+  servo0.constantOutput(HIGH);                                         // No pulses: as before
+  CHECK(servo0.readMicroseconds() != 1000);
+}
+
+
+int main() {
+  hostReset();
+  hostModel.onUpdate = onUpdate;
+  testOutput();
+  testRead();
+  printf("sizeof(Servo) on this host: %u bytes\n", (unsigned)sizeof(Servo));
+  CHECK(sizeof(Servo) == 3);                                           // servoIndex, min and max
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
@@ -0,0 +1,122 @@
+//******************************************************************************************************
+//
+// file:      sharedConfig.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Test of the storage of ServoMoba outside the objects, on the host model. The program checks:
+//            - that six servos, on TCA0 and TCA1, can each have settings and a power rail of their
+//              own, and that each rail is switched on
+//            - that servos with the same settings share an entry of the ServoConfig table, and that
+//              an entry that is not shared is changed in place
+//            - that the move queue and the feedback state exist per servo, although they are not
+//              part of the servo objects
+//            - that a position journal of less than two records is rejected
+//            Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA0_MoBa.h>
+#include <Servo_TCA1_MoBa.h>
+#include <EEPROM.h>
+#include "host_model.h"
+
+ServoMoba  servoA;
+ServoMoba  servoB;
+ServoMoba  servoC;
+ServoMoba1 servoD;
+ServoMoba1 servoE;
+ServoMoba1 servoF;
+
+const uint8_t rails[6] = {PIN_PD4, PIN_PD5, PIN_PD6, PIN_PD7, PIN_PE0, PIN_PE1};
+
+
+//******************************************************************************************************
+// Servo i gets pulseBeforeMoving i + 1, power enable pin rails[i] and a current of 100 * (i + 1) mA
+template <class T> static void initServo(T &servo, uint8_t i) {
+  servo.initPulse(0, i + 1, 1, 1500);
+  servo.initPower(false, rails[i], HIGH, 0, 0);
+  servo.setMoveCurrent(100 * (i + 1));
+}
+
+static void checkSettings() {
+  for (uint8_t i = 1; i < MAX_SERVO_CONFIGS; i++) CHECK(ServoConfig::users(i) == 0);
+  CHECK(servoA.getStartDuration() == 0);                               // Entry 0: the defaults
+  initServo(servoA, 0);
+  initServo(servoB, 1);
+  initServo(servoC, 2);
+  initServo(servoD, 3);
+  initServo(servoE, 4);
+  initServo(servoF, 5);
+  CHECK(servoA.getStartDuration() == 1);
+  CHECK(servoB.getStartDuration() == 2);
+  CHECK(servoC.getStartDuration() == 3);
+  CHECK(servoD.getStartDuration() == 4);
+  CHECK(servoE.getStartDuration() == 5);
+  CHECK(servoF.getStartDuration() == 6);
+  for (uint8_t i = 1; i < MAX_SERVO_CONFIGS; i++) CHECK(ServoConfig::users(i) == 1);
+  for (uint8_t i = 0; i < 6; i++) {
+    printf("rail %u: %s\n", i, (digitalRead(rails[i]) == HIGH) ? "on" : "off");
+    CHECK(digitalRead(rails[i]) == HIGH);
+  }
+}
+
+static void checkSharing() {
+  servoB.initPulse(0, 1, 1, 1500);                                     // Not shared: in place
+  CHECK((ServoConfig::users(2) == 1) && (servoB.getStartDuration() == 1));
+  servoB.setMoveCurrent(100);                                          // Now equal to servoA
+  CHECK((ServoConfig::users(1) == 2) && (ServoConfig::users(2) == 0));
+  servoE.initPulse(0, 1, 1, 1500);
+  servoE.setMoveCurrent(100);                                          // Shared by TCA0 and TCA1
+  CHECK((ServoConfig::users(1) == 3) && (ServoConfig::users(5) == 0));
+  servoA.initPulse(0, 7, 1, 1500);                                     // Leaves the shared entry
+  CHECK((ServoConfig::users(1) == 2) && (servoA.getStartDuration() == 7));
+  CHECK(servoB.getStartDuration() == 1);
+  CHECK((digitalRead(rails[1]) == HIGH) && (digitalRead(rails[4]) == HIGH));  // Rails are per servo
+  printf("config users:");
+  for (uint8_t i = 0; i < MAX_SERVO_CONFIGS; i++) printf(" %u", ServoConfig::users(i));
+  printf("\n");
+}
+
+static void checkStorage() {
+  CHECK(servoA.movesQueued() == 0);
+  CHECK(servoA.queueMove(KEEP_CURVE, 1, 1, 0));
+  CHECK(servoA.queueMove(KEEP_CURVE, 0, 1, 0));
+  CHECK(servoB.queueMove(KEEP_CURVE, 1, 1, 0));
+  CHECK(servoD.queueMove(KEEP_CURVE, 1, 1, 0));
+  CHECK((servoA.movesQueued() == 2) && (servoB.movesQueued() == 1) && (servoC.movesQueued() == 0));
+  CHECK(servoD.movesQueued() == 1);
+  servoA.clearQueue();
+  CHECK((servoA.movesQueued() == 0) && (servoB.movesQueued() == 1));
+  CHECK(servoA.getFeedback() == 0);                                    // No feedback state yet
+  servoA.setStall(700, 3);
+  servoA.setStall(0, 1);
+  CHECK(servoA.getFeedback() == 0);
+}
+
+static void checkJournal() {
+  const uint8_t record[7] = {1, 0xDC, 0x05, 0x20, 0x03, 0x40, 0x06};   // 1500 us, 800, 1600
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < 7; i++) {
+    EEPROM.write(200 + i, record[i]);
+    sum += record[i];
+  }
+  EEPROM.write(207, ~sum);
+  CHECK(!servoC.initJournal(200, 0));                                  // Less than 2 records: no journal
+  CHECK(!servoC.initJournal(200, 1));
+  CHECK(servoC.getTreshold1() != 800);
+  CHECK(servoC.initJournal(200, 2));                                   // The valid record is restored
+  CHECK((servoC.getTreshold1() == 800) && (servoC.getTreshold2() == 1600));
+}
+
+
+int main() {
+  hostReset();
+  checkSettings();
+  checkSharing();
+  checkStorage();
+  checkJournal();
+  printf("sizeof(ServoMoba) on this host: %u bytes\n", (unsigned)sizeof(ServoMoba));
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
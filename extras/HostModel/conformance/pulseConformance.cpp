@@ -0,0 +1,357 @@
+//******************************************************************************************************
+//
+// file:      pulseConformance.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Pulse conformance test on the host model. Three servos on TCA0 and three on TCA1 go
+//            through attach(), writes, constantOutput() transitions, a suspended ISR and detach(),
+//            while synthetic UART and DCC interrupts delay the ISR of the library. Every edge of the
+//            six waveform outputs is checked at the exact cycle:
+//            - each pulse has the width of a written value (no runts, no stretched pulses)
+//            - each rising edge is on a slot boundary, and Compare Unit n + 1 rises one slot after
+//              Compare Unit n
+//            - the rising edges of an output are a whole number of 20 ms frames apart, and exactly
+//              one frame while the output keeps pulsing
+//            - constant levels hold, and after detach() no pulses follow
+//            - while TCA1 follows TCA0, its pulses are offset us after those of TCA0
+//
+// Usage: pulseConformance [-u baud] [-d] [-f offset] [-w file.vcd]
+//   -u: UART receive interrupts, one per character at the given baudrate
+//   -d: DCC decoder interrupts, on each edge of a (pseudo random) DCC signal
+//   -f: TCA1 follows TCA0, offset us later (see Servo1::followTCA0())
+//   -w: write the waveform outputs to a VCD file
+// The load interrupts have the same level as the servo ISR, so the servo ISR waits until the CPU is
+// free. Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA0.h>
+#include <Servo_TCA1.h>
+#include "host_model.h"
+
+#define UART_ISR_US       5                        // Duration of the load ISRs
+#define DCC_ISR_US        8
+#define DCC_ONE_US       58                        // Half bit of the DCC signal
+#define DCC_ZERO_US     100
+
+Servo  servo0;
+Servo  servo1;
+Servo  servo2;
+Servo1 servo3;
+Servo1 servo4;
+Servo1 servo5;
+
+
+//******************************************************************************************************
+// Interrupt load: the arrivals of the UART and DCC interrupts are generated in time order. An ISR
+// that arrives while the CPU is busy runs after the running one.
+//******************************************************************************************************
+static uint32_t uartPeriod = 0;                    // cycles between characters; 0 = no UART load
+static bool dccLoad = false;
+static uint64_t uartAt;                            // cycle of the next arrival
+static uint64_t dccAt;
+static uint64_t cpuFreeAt = 0;                     // cycle at which the running load ISR is done
+static uint32_t random32 = 12345;
+static uint32_t maxLatency = 0;                    // cycles
+
+static uint32_t nextRandom() {
+  random32 = random32 * 1103515245UL + 12345;
+  return random32 >> 16;
+}
+
+static uint32_t isrLatency(uint8_t timer) {       // cycles
+  uint64_t now = hostModel.cycles;
+  for (;;) {
+    uint64_t at = UINT64_MAX;
+    uint32_t duration = 0;
+    if (uartPeriod && (uartAt <= now) && (uartAt < at)) {at = uartAt; duration = UART_ISR_US;}
+    if (dccLoad && (dccAt <= now) && (dccAt < at)) {at = dccAt; duration = DCC_ISR_US;}
+    if (at == UINT64_MAX) break;
+    if (at == uartAt) uartAt += uartPeriod;
+    else dccAt += (uint64_t)((nextRandom() & 1) ? DCC_ONE_US : DCC_ZERO_US) * clockCyclesPerMicrosecond();
+    if (cpuFreeAt < at) cpuFreeAt = at;
+    cpuFreeAt += duration * clockCyclesPerMicrosecond();
+  }
+  uint32_t latency = (cpuFreeAt > now) ? cpuFreeAt - now : 0;
+  if (latency > maxLatency) maxLatency = latency;
+  return latency;
+}
+
+
+//******************************************************************************************************
+// The expected behaviour of each output, and the checks at each edge (onWaveform hook)
+//******************************************************************************************************
+typedef struct {
+  uint64_t width[2];                               // cycles: the previous and the latest written value
+  int8_t extraRises;                               // -1: pulsing; otherwise the rises still allowed
+  bool allowGap;                                   // the next rise may come more than one frame later
+  bool allowHigh;                                  // a constant high level may end
+  bool hasRise;
+  uint64_t lastRise;                               // cycle of the latest rising edge
+  uint32_t pulses;
+} output_t;
+
+static output_t outputs[2][3];
+static bool following = false;
+static uint64_t offsetCycles;
+static bool hasRise[2];                            // per timer: the latest rise of any output
+static uint64_t lastRise[2];
+static uint8_t lastUnit[2];
+static uint32_t edges[2];
+static uint32_t badWidth = 0;
+static uint32_t badPeriod = 0;
+static uint32_t badSlot = 0;
+static uint32_t badOffset = 0;
+static uint32_t badRise = 0;
+
+static TCA_SINGLE_t *registers(uint8_t timer) {
+  return (timer == 0) ? &hostTCA0.SINGLE : &hostTCA1.SINGLE;
+}
+
+static uint64_t cyclesPerTick(uint8_t timer) {
+  return F_CPU / hostTimerClock(registers(timer));
+}
+
+static uint64_t slotCycles(uint8_t timer) {
+  return (uint64_t)(registers(timer)->PER + 1) * cyclesPerTick(timer);
+}
+
+static uint64_t widthCycles(uint8_t timer, uint16_t us) {
+  return (uint64_t)us * hostTimerClock(registers(timer)) / 1000000UL * cyclesPerTick(timer);
+}
+
+static bool isWritten(const output_t *o, uint64_t width) {
+  return (width == o->width[0]) || (width == o->width[1]);
+}
+
+static void checkRise(uint8_t timer, uint8_t unit, output_t *o) {
+  uint64_t now = hostModel.cycles;
+  uint64_t slot = slotCycles(timer);
+  bool gap = o->allowGap;
+  if (o->extraRises == 0) badRise++;               // Constant low or detached
+  else if (o->extraRises > 0) o->extraRises--;
+  else if (o->hasRise) {
+    uint64_t distance = now - o->lastRise;
+    if (gap) {if ((distance % slot) || (distance < 3 * slot)) badPeriod++;}
+    else if (distance != 3 * slot) badPeriod++;
+    o->allowGap = false;
+  }
+  // Slot boundaries: unit n + 1 rises one slot after unit n. While the ISR was suspended, the slots
+  // passed without it, so the first pulse after a constant level may come in another slot.
+  if (hasRise[timer]) {
+    uint64_t distance = now - lastRise[timer];
+    if (distance % slot) badSlot++;
+    else if (!gap && ((uint64_t)(unit + 3 - lastUnit[timer]) % 3 != (distance / slot) % 3)) badSlot++;
+  }
+  if (following && (timer == 1) && hasRise[0] && ((now - lastRise[0]) % slot != offsetCycles % slot)) badOffset++;
+  hasRise[timer] = true;
+  lastRise[timer] = now;
+  lastUnit[timer] = unit;
+  o->hasRise = true;
+  o->lastRise = now;
+}
+
+static void checkFall(uint8_t timer, output_t *o) {
+  uint64_t length = hostModel.cycles - o->lastRise;
+  uint64_t slot = slotCycles(timer);
+  if (isWritten(o, length)) o->pulses++;
+  else if (o->allowHigh && (length > slot) && ((length % slot == 0) || isWritten(o, length % slot))) {
+    o->allowHigh = false;                          // The end of a constant high level
+  }
+  else badWidth++;
+}
+
+static void onWaveform(uint8_t timer, uint8_t unit, uint8_t level) {
+  edges[timer]++;
+  if (level) checkRise(timer, unit, &outputs[timer][unit]);
+  else checkFall(timer, &outputs[timer][unit]);
+}
+
+
+//******************************************************************************************************
+// The library calls of the scenario, which also tell what the outputs should do
+//******************************************************************************************************
+static Servo *servos0[3] = {&servo0, &servo1, &servo2};
+static Servo1 *servos1[3] = {&servo3, &servo4, &servo5};
+
+static output_t *outputOf(uint8_t servo) {
+  return &outputs[servo / 3][servo % 3];
+}
+
+static void write(uint8_t servo, uint16_t us) {
+  output_t *o = outputOf(servo);
+  o->width[0] = o->width[1];
+  o->width[1] = widthCycles(servo / 3, us);
+  if (o->extraRises >= 0) o->allowGap = true;     // Pulses again, after a constant level
+  o->extraRises = -1;
+  if (servo < 3) servos0[servo]->writeMicroseconds(us);
+  else servos1[servo - 3]->writeMicroseconds(us);
+}
+
+static void attach(uint8_t servo, uint16_t us) {
+  output_t *o = outputOf(servo);
+  o->width[0] = o->width[1] = widthCycles(servo / 3, us);
+  o->extraRises = -1;
+  o->allowGap = true;
+  if (servo < 3) {servos0[servo]->writeMicroseconds(us); servos0[servo]->attach(PIN_PA0 + servo);}
+  else {servos1[servo - 3]->writeMicroseconds(us); servos1[servo - 3]->attach(PIN_PB0 + servo - 3);}
+}
+
+static void constantOutput(uint8_t servo, uint8_t level) {
+  output_t *o = outputOf(servo);
+  o->extraRises = level ? 2 : 1;                   // A pulse may have been loaded already, then high
+  o->allowGap = true;
+  if (level) o->allowHigh = true;
+  if (servo < 3) servos0[servo]->constantOutput(level);
+  else servos1[servo - 3]->constantOutput(level);
+}
+
+static void detach(uint8_t servo) {
+  outputOf(servo)->extraRises = 1;
+  if (servo < 3) servos0[servo]->detach();
+  else servos1[servo - 3]->detach();
+}
+
+static uint8_t level(uint8_t servo) {
+  return (hostTimers[servo / 3].wo >> (servo % 3)) & 1;
+}
+
+// Runs for ms, and checks the number of pulses of each output: one per frame, or none
+static void checkPulses(const char *name, uint32_t ms, uint8_t pulsing) {   // pulsing: bit per servo
+  for (uint8_t i = 0; i < 6; i++) outputOf(i)->pulses = 0;
+  hostAdvance(ms * 1000UL);
+  uint32_t expected = ms / 20;
+  printf("%s:", name);
+  for (uint8_t i = 0; i < 6; i++) {
+    uint32_t pulses = outputOf(i)->pulses;
+    printf(" %u", pulses);
+    if (pulsing & (1 << i)) CHECK((pulses >= expected - 1) && (pulses <= expected + 1));
+    else CHECK(pulses == 0);
+  }
+  printf("\n");
+}
+
+
+//******************************************************************************************************
+int main(int argc, char *argv[]) {
+  uint16_t offset = 0;
+  const char *vcd = 0;
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "-u") == 0) && (i + 1 < argc)) uartPeriod = F_CPU * 10UL / atol(argv[++i]);
+    else if (strcmp(argv[i], "-d") == 0) dccLoad = true;
+    else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc)) offset = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-w") == 0) && (i + 1 < argc)) vcd = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [-u baud] [-d] [-f offset] [-w file.vcd]\n", argv[0]);
+      return 1;
+    }
+  }
+  hostReset();
+  if (vcd && !hostVcdOpen(vcd)) {
+    fprintf(stderr, "cannot write %s\n", vcd);
+    return 1;
+  }
+  hostModel.onWaveform = onWaveform;
+  hostModel.isrLatency = isrLatency;
+  uartAt = 1234;                                   // Not in step with the slots
+  dccAt = 777;
+  printf("load: uart %s, dcc %s, follow %u us\n", uartPeriod ? "on" : "off", dccLoad ? "on" : "off", offset);
+
+  // Written before attach(), and attached halfway the slots
+  attach(0, 1000);
+  hostAdvance(1234);
+  attach(1, 1500);
+  hostAdvance(2345);
+  attach(2, 2000);
+  if (offset) {
+    following = Servo1::followTCA0(offset);
+    CHECK(following);
+    uint16_t isrPeriod = REFRESH_INTERVAL / SERVOS_PER_TIMER;
+    if (offset < FOLLOW_MIN_OFFSET) offset = FOLLOW_MIN_OFFSET;
+    if (offset > isrPeriod - FOLLOW_MIN_OFFSET) offset = isrPeriod - FOLLOW_MIN_OFFSET;
+    offsetCycles = widthCycles(0, offset);
+  }
+  hostAdvance(4567);
+  attach(3, 1200);
+  hostAdvance(5678);
+  attach(4, 1700);
+  hostAdvance(777);
+  attach(5, 2200);
+  checkPulses("attached", 1000, 0x3F);
+
+  // Sweeps, with the next value as soon as the previous one is in the buffer
+  uint16_t us[6] = {1000, 1500, 2000, 1200, 1700, 2200};
+  int16_t step[6] = {7, -11, -13, 17, 19, -23};
+  uint64_t until = hostModel.cycles + 2000000ULL * clockCyclesPerMicrosecond();
+  while (hostModel.cycles < until) {
+    for (uint8_t i = 0; i < 6; i++) {
+      bool accepts = (i < 3) ? servos0[i]->acceptsNewValue() : servos1[i - 3]->acceptsNewValue();
+      if (!accepts) continue;
+      if ((us[i] + step[i] < 800) || (us[i] + step[i] > 2300)) step[i] = -step[i];
+      us[i] += step[i];
+      write(i, us[i]);
+    }
+    hostAdvance(97);
+  }
+  checkPulses("sweep done", 200, 0x3F);
+
+  // constantOutput() low and high, and back to pulses
+  constantOutput(1, 0);
+  constantOutput(4, 1);
+  hostAdvance(3333);
+  constantOutput(5, 0);
+  hostAdvance(40000);
+  checkPulses("constant", 1000, 0x0D);
+  CHECK((level(1) == 0) && (level(4) == 1) && (level(5) == 0));
+  write(1, 1300);
+  write(4, 1800);
+  hostAdvance(5555);
+  write(5, 900);
+  hostAdvance(40000);
+  checkPulses("written again", 1000, 0x3F);
+
+  // All outputs constant: the ISR may be suspended, the levels hold
+  for (uint8_t i = 0; i < 6; i++) {
+    constantOutput(i, i & 1);
+    hostAdvance(1111);
+  }
+  hostAdvance(100000);
+  uint32_t before[2] = {edges[0], edges[1]};
+  checkPulses("all constant", 1000, 0);
+  printf("all constant: edges %u %u, suspended %u %u\n", edges[0] - before[0], edges[1] - before[1],
+    Servo::isSuspended(), Servo1::isSuspended());
+  CHECK((edges[0] == before[0]) && (edges[1] == before[1]));
+  for (uint8_t i = 0; i < 6; i++) CHECK(level(i) == (i & 1));
+  if (!following) CHECK(Servo::isSuspended() && Servo1::isSuspended());
+  for (uint8_t i = 0; i < 6; i++) write(i, 1100 + 150 * i);
+  hostAdvance(40000);
+  checkPulses("resumed", 1000, 0x3F);
+
+  // detach(): no pulses after the one that may have been loaded already
+  detach(2);
+  hostAdvance(2222);
+  detach(3);
+  hostAdvance(40000);
+  checkPulses("detached 2", 1000, 0x33);
+  CHECK((level(2) == 0) && (level(3) == 0));
+  for (uint8_t i = 0; i < 6; i++) {
+    if ((i == 2) || (i == 3)) continue;
+    detach(i);
+    hostAdvance(3456);
+  }
+  hostAdvance(40000);
+  checkPulses("all detached", 1000, 0);
+  for (uint8_t i = 0; i < 6; i++) CHECK(level(i) == 0);
+
+  printf("max ISR latency %.2f us; errors: width %u, period %u, slot %u, offset %u, rise %u\n",
+    (double)maxLatency / clockCyclesPerMicrosecond(), badWidth, badPeriod, badSlot, badOffset, badRise);
+  CHECK(badWidth == 0);
+  CHECK(badPeriod == 0);
+  CHECK(badSlot == 0);
+  CHECK(badOffset == 0);
+  CHECK(badRise == 0);
+  hostVcdClose();
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
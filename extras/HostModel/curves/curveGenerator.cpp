@@ -0,0 +1,158 @@
+//******************************************************************************************************
+//
+// file:      curveGenerator.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Test of makeCurve() (curveGenerator.h) and SKETCH_CURVES() (curves.h) on the host model.
+//            Each shape is instantiated with several durations, positions and error bounds. The
+//            program checks:
+//            - that the table has the number of points that curvePointsNeeded() calculated, with
+//              increasing times from 0 to the duration, followed by the {0, 0} end marker
+//            - that the first and last positions are those of the exact curve
+//            - that the straight lines between the points stay within maxError of the exact curve
+//            - that makeCurveAt() places the points at the given times, and that mirrorCurve()
+//              mirrors the positions
+//            - that the curves of SKETCH_CURVES() get the indices after the predefined curves, and
+//              that such index works with queueMove(), as a predefined curve does
+//            Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <math.h>
+#include <Servo_TCA0_MoBa.h>
+#include "host_model.h"
+
+ServoMoba servo;
+
+constexpr auto linear FLASH_MEMORY     = makeCurve<curveLinear, 10, 0, 255>();
+constexpr auto ease FLASH_MEMORY       = makeCurve<curveEase, 24, 0, 255>();
+constexpr auto easeBack FLASH_MEMORY   = makeCurve<curveEase, 200, 230, 20, 1>();
+constexpr auto parabola FLASH_MEMORY   = makeCurve<curveParabola, 40, 0, 255, 3>();
+constexpr auto dampedSine FLASH_MEMORY = makeCurve<curveDampedSine, 60, 0, 200>();
+constexpr auto dampedDown FLASH_MEMORY = makeCurve<curveDampedSine, 100, 255, 50, 4>();
+constexpr auto sine FLASH_MEMORY       = makeCurve<curveSine, 30, 100, 200>();
+constexpr auto sineWave FLASH_MEMORY   = makeCurve<curveSineWave, 60, 128, 228, 1>();
+constexpr auto sineAt FLASH_MEMORY     = makeCurveAt<curveSine, 128, 255, 0, 5, 10, 15, 20>();
+constexpr auto mirrored FLASH_MEMORY   = mirrorCurve(sineAt.points, 256);
+
+SKETCH_CURVES(ease.points, parabola.points, dampedSine.points);
+static_assert(sketchCurve(0) == NUMBER_OF_PREDEFINED_CURVES, "The sketch curves follow the predefined ones");
+
+
+//******************************************************************************************************
+// The table of a generated curve
+//******************************************************************************************************
+template <curveShape_t shape, uint8_t duration, uint8_t from, uint8_t to, uint8_t maxError, uint16_t N>
+static void checkCurve(const char *name, const curveTable_t<N> &table) {
+  const curvePoint_t *points = table.points;
+  uint16_t needed = curvePointsNeeded(shape, duration, from, to, maxError);
+  printf("%-12s %2u points:", name, N);
+  for (uint16_t i = 0; i < N; i++) printf(" %u/%u", points[i].time, points[i].position);
+  printf("\n");
+  CHECK(N == needed);
+  CHECK(N < SIZE_SERVO_CURVE);
+  CHECK((points[N].time == 0) && (points[N].position == 0));            // End marker
+  CHECK(points[0].time == 0);
+  CHECK(points[N - 1].time == duration);
+  for (uint16_t i = 1; i < N; i++) CHECK(points[i].time > points[i - 1].time);
+  CHECK(points[0].position == curvePosition(shape, 0, from, to));
+  CHECK(points[N - 1].position == curvePosition(shape, 1, from, to));
+  // The straight lines between the points, against the exact curve
+  double maxDeviation = 0;
+  for (uint16_t i = 1; i < N; i++) {
+    uint8_t t0 = points[i - 1].time;
+    uint8_t t1 = points[i].time;
+    for (uint16_t j = 0; j <= (t1 - t0) * CURVE_SAMPLES; j++) {
+      double t = t0 + (double)j / CURVE_SAMPLES;
+      double line = points[i - 1].position + (points[i].position - points[i - 1].position) * (t - t0) / (t1 - t0);
+      double deviation = fabs(line - curveClamped(shape, t / duration, from, to));
+      if (deviation > maxDeviation) maxDeviation = deviation;
+    }
+  }
+  printf("%-12s max deviation %.2f (maxError %u)\n", name, maxDeviation, maxError);
+  CHECK(maxDeviation <= maxError);
+}
+
+
+static void checkCurveAt() {
+  const uint8_t positions[] = {128, 218, 255, 218, 128};               // 128 + 127 * sin(pi * t / 20)
+  for (uint8_t i = 0; i < 5; i++) {
+    CHECK((sineAt.points[i].time == 5 * i) && (sineAt.points[i].position == positions[i]));
+    CHECK((mirrored.points[i].time == 5 * i) && (mirrored.points[i].position == 256 - positions[i]));
+  }
+  CHECK((sineAt.points[5].time == 0) && (sineAt.points[5].position == 0));  // End marker
+  CHECK((mirrored.points[5].time == 0) && (mirrored.points[5].position == 0));
+}
+
+
+//******************************************************************************************************
+// A curve of SKETCH_CURVES(), selected by index, should give the same movement as its table
+//******************************************************************************************************
+// Returns the frames of the movement; trace[] gets the pulse width per frame
+static uint16_t trace[600];
+
+static uint16_t movement(uint8_t curve, uint8_t direction) {
+  if (curve == USER_CURVE) {
+    servo.initCurveFromTable(ease.points, 2);
+    servo.moveServoAlongCurve(direction);
+  }
+  else CHECK(servo.queueMove(curve, direction, 2, 0));
+  uint16_t frames = 0;
+  uint16_t frame = Servo::getFrame();
+  uint32_t limit = millis() + 20000;
+  do {
+    servo.checkServo();
+    hostAdvance(100);
+    if ((Servo::getFrame() != frame) && !servo.movementCompleted && (frames < 600)) {
+      frame = Servo::getFrame();
+      trace[frames++] = servo.readMicroseconds();
+    }
+  } while ((frames == 0 || !servo.movementCompleted) && (millis() < limit));
+  CHECK(servo.movementCompleted);
+  hostAdvance(200000);
+  return frames;
+}
+
+static void checkSketchCurves() {
+  uint8_t first = sketchCurve(0);
+  printf("sketch curves at index %u, predefined curves %u\n", first, NUMBER_OF_PREDEFINED_CURVES);
+  CHECK(numberOfSketchCurves == 3);
+  CHECK(curveByIndex(first) == ease.points);
+  CHECK(curveByIndex(0) == PredefinedCurves[0]);
+  CHECK(curveByIndex(sketchCurve(1)) == parabola.points);
+  CHECK(curveByIndex(sketchCurve(2)) == dampedSine.points);
+  CHECK(curveByIndex(sketchCurve(3)) == 0);                             // Not in the list
+
+  servo.initPulse(1, 2, 2, 1500);
+  servo.attach(PIN_PA0);
+  hostAdvance(100000);
+  uint16_t reference[600];
+  movement(USER_CURVE, 0);                                              // Both start at the same position
+  uint16_t frames = movement(USER_CURVE, 1);                            // Via the table
+  memcpy(reference, trace, sizeof(reference));
+  movement(USER_CURVE, 0);
+  uint16_t indexed = movement(first, 1);                                // Via the index
+  printf("movement of %u frames via the table, %u via index %u\n", frames, indexed, first);
+  CHECK(frames >= 48);                                                  // Duration 24, stretch 2
+  CHECK(indexed == frames);
+  CHECK(memcmp(reference, trace, frames * sizeof(uint16_t)) == 0);
+}
+
+
+//******************************************************************************************************
+int main() {
+  hostReset();
+  checkCurve<curveLinear, 10, 0, 255, 2>("linear", linear);
+  checkCurve<curveEase, 24, 0, 255, 2>("ease", ease);
+  checkCurve<curveEase, 200, 230, 20, 1>("easeBack", easeBack);
+  checkCurve<curveParabola, 40, 0, 255, 3>("parabola", parabola);
+  checkCurve<curveDampedSine, 60, 0, 200, 2>("dampedSine", dampedSine);
+  checkCurve<curveDampedSine, 100, 255, 50, 4>("dampedDown", dampedDown);
+  checkCurve<curveSine, 30, 100, 200, 2>("sine", sine);
+  checkCurve<curveSineWave, 60, 128, 228, 1>("sineWave", sineWave);
+  checkCurveAt();
+  checkSketchCurves();
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
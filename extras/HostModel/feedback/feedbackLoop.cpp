@@ -0,0 +1,197 @@
+//******************************************************************************************************
+//
+// file:      feedbackLoop.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Test of the frame-synchronised feedback sampling (TCA_MobaFeedback/feedback.h) on the
+//            host model. The program plays the servos: hostModel.adcValue() returns the voltage of a
+//            simulated potentiometer (servo 0), that follows the pulse width with a limited speed,
+//            or the voltage over a simulated shunt resistor (servo 1), that is high while the
+//            servo is blocked. It checks:
+//            - that each servo is sampled once per frame, at the configured offset within its slot
+//            - that settling ends the finish state once the potentiometer has reached the target
+//            - that stall detection cuts pulses and power, and clears the queue
+//            Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA0_MoBa.h>
+#include <Servo_TCA1_MoBa.h>
+#include "host_model.h"
+
+#define POT_PIN       PIN_PD0                      // AIN0
+#define SHUNT_PIN     PIN_PD1                      // AIN1
+#define POWER_PIN     PIN_PC0
+#define SPEED_US_PER_MS   2                        // Speed of the simulated servo
+#define OFFSET_US      3000
+#define CONVERSION_US    12                        // ADC_CONVERSION_US of the host model
+#define NO_SERVO        255
+
+ServoMoba servo0;                                  // Position feedback
+ServoMoba servo1;                                  // Current feedback
+ServoMoba servo2;                                  // No feedback
+ServoMoba1 servo3;
+
+
+//******************************************************************************************************
+// The simulated servos
+//******************************************************************************************************
+static double potPosition = 1000;                  // us
+static uint64_t potUpdated = 0;                    // cycles
+static bool blocked = false;
+
+static uint16_t potToAdc(double us) {              // 10 bit; 500 us = 0, 2546 us = 1023
+  return (uint16_t)((us - 500) / 2);
+}
+
+static uint16_t adcValue(uint8_t muxpos) {
+  if (muxpos == 0) {
+    double elapsedMs = (double)(hostModel.cycles - potUpdated) / clockCyclesPerMicrosecond() / 1000;
+    double wanted = servo0.readMicroseconds();
+    double step = elapsedMs * SPEED_US_PER_MS;
+    if (potPosition < wanted) potPosition = (wanted - potPosition < step) ? wanted : potPosition + step;
+      else potPosition = (potPosition - wanted < step) ? wanted : potPosition - step;
+    potUpdated = hostModel.cycles;
+    return potToAdc(potPosition);
+  }
+  if (muxpos == 1) return (blocked) ? 800 : 100;
+  return 0;
+}
+
+
+//******************************************************************************************************
+// Timing of the samples: the time since the start of the slot, per sample
+//******************************************************************************************************
+static uint64_t slotStart = 0;
+static uint32_t samples[FEEDBACK_SERVOS];
+static uint32_t badTiming = 0;
+static uint8_t expectedServo = NO_SERVO;
+static uint32_t badOrder = 0;
+
+static void onUpdate(uint8_t timer, TCA_SINGLE_t *registers) {
+  if (timer == 0) slotStart = hostModel.cycles;
+}
+
+static void onSample(uint8_t servo, uint16_t value) {
+  uint64_t delay = (hostModel.cycles - slotStart) / clockCyclesPerMicrosecond();
+  if ((delay < OFFSET_US + CONVERSION_US - 1) || (delay > OFFSET_US + CONVERSION_US + 1)) badTiming++;
+  if ((expectedServo != NO_SERVO) && (servo != expectedServo)) badOrder++;
+  expectedServo = (servo == 0) ? 1 : 0;              // servo2 has no feedback input
+  samples[servo]++;
+}
+
+static void runFor(uint32_t ms) {
+  uint64_t until = (uint64_t)micros() + ms * 1000UL;
+  while (micros() < until) {
+    servo0.checkServo();
+    servo1.checkServo();
+    servo2.checkServo();
+    hostAdvance(100);
+  }
+}
+
+// Frames from the start of a movement till movementCompleted
+static uint16_t moveFrames(ServoMoba &servo, uint8_t direction) {
+  uint16_t frames = 0;
+  servo.moveServoAlongCurve(direction);
+  while (!servo.movementCompleted && (frames < 1000)) {
+    runFor(20);
+    frames++;
+  }
+  return frames;
+}
+
+
+//******************************************************************************************************
+static void testSampling() {
+  ServoFeedback::onSample(onSample);
+  runFor(1000);
+  ServoFeedback::onSample(0);
+  printf("samples: %u %u %u, timing errors %u, order errors %u\n", samples[0], samples[1], samples[2],
+    badTiming, badOrder);
+  CHECK((samples[0] >= 49) && (samples[0] <= 50));   // One per frame
+  CHECK((samples[1] >= 49) && (samples[1] <= 50));
+  CHECK(samples[2] == 0);
+  CHECK(badTiming == 0);
+  CHECK(badOrder == 0);
+  // The ring buffer holds the oldest samples; the rest has been counted as lost
+  feedbackSample_t sample;
+  uint8_t count = 0;
+  uint8_t previous = NO_SERVO;
+  while (ServoFeedback::read(sample)) {
+    CHECK(sample.servo != previous);
+    previous = sample.servo;
+    count++;
+  }
+  CHECK(count == FEEDBACK_BUFFER_SIZE);
+  CHECK(ServoFeedback::lost() > 0);
+  uint16_t value;
+  CHECK(servo0.getFeedback() == potToAdc(1000));   // checkServo() has taken the latest sample
+  CHECK(!ServoFeedback::get(0, value));
+  CHECK(!ServoFeedback::get(2, value));
+}
+
+static void testSettle() {
+  uint16_t withoutSettle = moveFrames(servo0, 0);
+  CHECK(servo0.getFeedback() == potToAdc(2000));
+  servo0.setSettle(potToAdc(1000), potToAdc(2000), 4);
+  uint16_t withSettle = moveFrames(servo0, 1);
+  printf("settle: %u frames without, %u frames with settling\n", withoutSettle, withSettle);
+  CHECK(withoutSettle > 100);
+  CHECK(withSettle < withoutSettle - 50);
+  int16_t difference = (int16_t)servo0.getFeedback() - potToAdc(1000);
+  CHECK((difference >= -4) && (difference <= 4));
+  CHECK(!servo0.stalled);
+}
+
+static void testStall() {
+  servo1.setStall(500, 3);
+  CHECK(moveFrames(servo1, 0) < 100);
+  CHECK(!servo1.stalled);
+  runFor(40);                                      // Power off
+  servo1.queueMove(KEEP_CURVE, 0, 1, 0);
+  servo1.moveServoAlongCurve(1);
+  runFor(100);
+  CHECK(hostModel.pinOut[POWER_PIN] == HIGH);
+  blocked = true;
+  runFor(100);
+  printf("stall: stalled %u, power %u, queued %u\n", servo1.stalled, hostModel.pinOut[POWER_PIN],
+    servo1.movesQueued());
+  CHECK(servo1.stalled);
+  CHECK(servo1.movementCompleted);
+  CHECK(hostModel.pinOut[POWER_PIN] == LOW);
+  CHECK(servo1.movesQueued() == 0);
+  blocked = false;
+  CHECK(moveFrames(servo1, 0) < 100);
+  CHECK(!servo1.stalled);
+}
+
+
+int main() {
+  hostReset();
+  hostModel.adcValue = adcValue;
+  hostModel.onUpdate = onUpdate;
+  servo0.attach(PIN_PA0);
+  servo1.attach(PIN_PA1);
+  servo2.attach(PIN_PA2);
+  servo3.attach(PIN_PB0);
+  servo0.setTreshold1(1000);
+  servo0.setTreshold2(2000);
+  servo0.initCurveFromPROGMEM(2, 3);
+  servo0.initPulse(0, 0, 150, 1000);               // 3 seconds of pulses after each movement
+  servo1.initCurveFromPROGMEM(2, 3);
+  servo1.initPower(true, POWER_PIN, HIGH, 0, 0);
+  servo0.writeMicroseconds(1000);
+  ServoFeedback::setOffset(OFFSET_US);
+  CHECK(servo0.initFeedback(POT_PIN));
+  CHECK(servo1.initFeedback(SHUNT_PIN));
+  CHECK(!servo3.initFeedback(PIN_PD2));            // One ADC: only servos of the same timer
+  CHECK(!servo2.initFeedback(PIN_PA3));            // Not an analog input
+
+  testSampling();
+  testSettle();
+  testStall();
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
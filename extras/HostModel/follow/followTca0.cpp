@@ -0,0 +1,189 @@
+//******************************************************************************************************
+//
+// file:      followTca0.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Test of Servo1::followTCA0() on the host model: TCA1 runs in step with TCA0, and the
+//            ISR of TCA0 handles the slots of both timers. The program checks:
+//            - that each UPDATE of TCA1 comes offset us after an UPDATE of TCA0
+//            - that Compare Unit n of TCA1 outputs its pulse in the slot that follows the pulse of
+//              Compare Unit n of TCA0, with the right width, once per frame
+//            - that TCA1 has no interrupts while it follows, and that its frames and getSlotServo()
+//              keep working
+//            - that the ISR of TCA0 is not suspended while TCA1 follows, and that TCA0 refuses
+//              syncFrames() meanwhile
+//            - that followTCA0(FOLLOW_OFF) gives TCA1 its own ISR again, without a missed pulse
+//            - that an interrupt latency below FOLLOW_MIN_OFFSET doesn't disturb the pulses of TCA1
+//            The argument is the offset (us). Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA0.h>
+#include <Servo_TCA1.h>
+#include "host_model.h"
+
+#define NO_UNIT         255
+
+Servo  servo0;
+Servo  servo1;
+Servo  servo2;
+Servo1 servo3;
+Servo1 servo4;
+Servo1 servo5;
+
+static const uint16_t widths[2][3] = {{1000, 1500, 2000}, {1200, 1700, 2200}};
+
+
+//******************************************************************************************************
+// Observation of both timers, via the onUpdate hook
+//******************************************************************************************************
+static bool measuring = false;
+static bool following = false;
+static uint64_t offsetCycles;                      // Expected distance of the UPDATEs
+static uint32_t cyclesPerTick;
+static uint64_t lastUpdate0;                       // Cycle of the latest UPDATE of TCA0
+static uint8_t unit0 = NO_UNIT;                    // Compare Unit of TCA0 with a pulse in the running slot
+static uint8_t lastUnit1 = NO_UNIT;
+static uint32_t pulses[2][3];
+static uint32_t badOffset = 0;
+static uint32_t badOrder = 0;
+static uint32_t badWidth = 0;
+static uint32_t badSlotServo = 0;
+
+static uint8_t pulseUnit(uint8_t timer, TCA_SINGLE_t *r) {
+  uint16_t cmp[3] = {r->CMP0, r->CMP1, r->CMP2};
+  uint8_t unit = NO_UNIT;
+  for (uint8_t i = 0; i < 3; i++) {
+    if (cmp[i] == 0) continue;
+    if (unit != NO_UNIT) badOrder++;               // Two pulses in one slot
+    if (cmp[i] != hostTicks(widths[timer][i])) badWidth++;
+    unit = i;
+  }
+  return unit;
+}
+
+static void onUpdate(uint8_t timer, TCA_SINGLE_t *r) {
+  if (!measuring) return;
+  uint8_t unit = pulseUnit(timer, r);
+  if (unit == NO_UNIT) {badOrder++; return;}
+  pulses[timer][unit]++;
+  if (timer == 0) {
+    lastUpdate0 = hostModel.cycles;
+    unit0 = unit;
+    return;
+  }
+  if (unit0 == NO_UNIT) return;                    // No UPDATE of TCA0 seen yet
+  // TCA1: offset us after the UPDATE of TCA0 that started the pulse on the same Compare Unit
+  int64_t deviation = (int64_t)(hostModel.cycles - lastUpdate0) - (int64_t)offsetCycles;
+  if ((deviation > cyclesPerTick) || (deviation < -(int64_t)cyclesPerTick)) badOffset++;
+  if (unit != unit0) badOrder++;
+  if ((lastUnit1 != NO_UNIT) && (unit != (lastUnit1 + 1) % 3)) badOrder++;
+  lastUnit1 = unit;
+  // The ISR of TCA1 itself runs after the UPDATE; followSlot() has already run before it
+  if (following && (Servo1::getSlotServo(0) != unit)) badSlotServo++;   // servo3..5 are on units 0..2
+}
+
+static void startMeasuring() {
+  memset(pulses, 0, sizeof(pulses));
+  badOffset = badOrder = badWidth = badSlotServo = 0;
+  unit0 = lastUnit1 = NO_UNIT;
+  lastUpdate0 = hostModel.cycles;
+  measuring = true;
+}
+
+static uint32_t isrLatency(uint8_t timer) {       // cycles
+  return (FOLLOW_MIN_OFFSET - 50) * clockCyclesPerMicrosecond();
+}
+
+// Runs for ms, and checks the pulses of both timers
+static void checkPulses(const char *name, uint32_t ms) {
+  hostAdvance(20000);
+  uint32_t isrs[2] = {hostTimers[0].isrCount, hostTimers[1].isrCount};
+  uint16_t frames = Servo1::getFrame();
+  startMeasuring();
+  hostAdvance(ms * 1000UL);
+  measuring = false;
+  uint32_t isrs0 = hostTimers[0].isrCount - isrs[0];
+  uint32_t isrs1 = hostTimers[1].isrCount - isrs[1];
+  frames = Servo1::getFrame() - frames;
+  printf("%s: interrupts %u %u, frames %u, pulses %u %u %u / %u %u %u\n", name, isrs0, isrs1, frames,
+    pulses[0][0], pulses[0][1], pulses[0][2], pulses[1][0], pulses[1][1], pulses[1][2]);
+  uint32_t expected = ms / 20;
+  for (uint8_t t = 0; t < 2; t++) {
+    for (uint8_t u = 0; u < 3; u++) CHECK((pulses[t][u] >= expected - 1) && (pulses[t][u] <= expected + 1));
+  }
+  CHECK((frames >= expected - 1) && (frames <= expected + 1));
+  CHECK((isrs0 >= 3 * expected - 1) && (isrs0 <= 3 * expected + 1));
+  if (following) CHECK(isrs1 == 0);
+  else CHECK((isrs1 >= 3 * expected - 1) && (isrs1 <= 3 * expected + 1));
+  CHECK(badOffset == 0);
+  CHECK(badOrder == 0);
+  CHECK(badWidth == 0);
+  CHECK(badSlotServo == 0);
+}
+
+
+//******************************************************************************************************
+int main(int argc, char *argv[]) {
+  uint16_t offset = (argc > 1) ? atoi(argv[1]) : 3000;
+  hostReset();
+  hostModel.onUpdate = onUpdate;
+
+  CHECK(!Servo1::followTCA0(offset));              // TCA0 doesn't run yet
+  servo0.writeMicroseconds(widths[0][0]);
+  servo1.writeMicroseconds(widths[0][1]);
+  servo2.writeMicroseconds(widths[0][2]);
+  servo0.attach(PIN_PA0);
+  servo1.attach(PIN_PA1);
+  servo2.attach(PIN_PA2);
+  following = Servo1::followTCA0(offset);
+  CHECK(following);
+  servo3.writeMicroseconds(widths[1][0]);
+  servo4.writeMicroseconds(widths[1][1]);
+  servo5.writeMicroseconds(widths[1][2]);
+  servo3.attach(PIN_PB0);
+  servo4.attach(PIN_PB1);
+  servo5.attach(PIN_PB2);
+
+  // The offset is limited to FOLLOW_MIN_OFFSET .. ISR_PERIOD - FOLLOW_MIN_OFFSET
+  uint16_t isrPeriod = REFRESH_INTERVAL / SERVOS_PER_TIMER;
+  if (offset < FOLLOW_MIN_OFFSET) offset = FOLLOW_MIN_OFFSET;
+  if (offset > isrPeriod - FOLLOW_MIN_OFFSET) offset = isrPeriod - FOLLOW_MIN_OFFSET;
+  cyclesPerTick = F_CPU / hostTimerClock(&hostTCA0.SINGLE);
+  offsetCycles = (uint64_t)hostTicks(offset) * cyclesPerTick;
+  printf("offset %u us\n", offset);
+  checkPulses("following", 1000);
+
+  // TCA0 keeps its ISR running for TCA1, also while its own outputs are constant
+  CHECK(!Servo::syncFrames(0));
+  servo0.constantOutput(0);
+  servo1.constantOutput(0);
+  servo2.constantOutput(0);
+  hostAdvance(200000);
+  CHECK(!Servo::isSuspended());
+  uint32_t pulses1 = hostTimers[1].overflows;
+  uint16_t frames = Servo1::getFrame();
+  hostAdvance(1000000);
+  printf("TCA0 constant: TCA1 frames %u\n", (uint16_t)(Servo1::getFrame() - frames));
+  CHECK((uint16_t)(Servo1::getFrame() - frames) >= 49);
+  CHECK(hostTimers[1].overflows - pulses1 >= 149);
+  servo0.writeMicroseconds(widths[0][0]);
+  servo1.writeMicroseconds(widths[0][1]);
+  servo2.writeMicroseconds(widths[0][2]);
+  checkPulses("written again", 200);
+
+  // TCA1 on its own again: its slots keep their position
+  following = Servo1::followTCA0(FOLLOW_OFF);
+  CHECK(!following);
+  checkPulses("own ISR", 1000);
+
+  // And following again, with an interrupt latency just below FOLLOW_MIN_OFFSET
+  following = Servo1::followTCA0(offset);
+  CHECK(following);
+  hostModel.isrLatency = isrLatency;
+  checkPulses("following again", 1000);
+
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+//******************************************************************************************************
+//
+// file:      Arduino.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Host (Linux / macOS) stand-in for the Arduino core, as far as it is used by the Servo_TCA
+//            library. Together with avr_model.h it allows the unmodified library sources to be
+//            compiled and run on an ordinary PC.
+//
+// Only the parts of the Arduino / DxCore API that are used by the library are modelled:
+// pinMode(), digitalWrite(), delay(), millis(), micros(), map() and the pin / port macros.
+// Pin numbers follow the DxCore 48 pin layout: PIN_Pxn = 8 * port + n.
+//
+//******************************************************************************************************
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "avr_model.h"
+
+
+//******************************************************************************************************
+// Basic Arduino types and constants
+//******************************************************************************************************
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH   1
+#define LOW    0
+#define INPUT  0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#ifndef F_CPU
+#define F_CPU 24000000L
+#endif
+#define clockCyclesPerMicrosecond() ((long)(F_CPU / 1000000L))
+
+#define PROGMEM
+#define PROGMEM_MAPPED
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#define interrupts()   sei()
+#define noInterrupts() cli()
+
+
+//******************************************************************************************************
+// Pins and ports. PA = 0 .. PG = 6, as in DxCore.
+//******************************************************************************************************
+#define PA 0
+#define PB 1
+#define PC 2
+#define PD 3
+#define PE 4
+#define PF 5
+#define PG 6
+#define NOT_A_PIN 255
+#define NUM_TOTAL_PINS 56
+
+#define _HOST_PIN(port, bit) ((port) * 8 + (bit))
+#define PIN_PA0 _HOST_PIN(PA,0)
+#define PIN_PA1 _HOST_PIN(PA,1)
+#define PIN_PA2 _HOST_PIN(PA,2)
+#define PIN_PA3 _HOST_PIN(PA,3)
+#define PIN_PA4 _HOST_PIN(PA,4)
+#define PIN_PA5 _HOST_PIN(PA,5)
+#define PIN_PA6 _HOST_PIN(PA,6)
+#define PIN_PA7 _HOST_PIN(PA,7)
+#define PIN_PB0 _HOST_PIN(PB,0)
+#define PIN_PB1 _HOST_PIN(PB,1)
+#define PIN_PB2 _HOST_PIN(PB,2)
+#define PIN_PB3 _HOST_PIN(PB,3)
+#define PIN_PB4 _HOST_PIN(PB,4)
+#define PIN_PB5 _HOST_PIN(PB,5)
+#define PIN_PC0 _HOST_PIN(PC,0)
+#define PIN_PC1 _HOST_PIN(PC,1)
+#define PIN_PC2 _HOST_PIN(PC,2)
+#define PIN_PC3 _HOST_PIN(PC,3)
+#define PIN_PC4 _HOST_PIN(PC,4)
+#define PIN_PC5 _HOST_PIN(PC,5)
+#define PIN_PC6 _HOST_PIN(PC,6)
+#define PIN_PC7 _HOST_PIN(PC,7)
+#define PIN_PD0 _HOST_PIN(PD,0)
+#define PIN_PD1 _HOST_PIN(PD,1)
+#define PIN_PD2 _HOST_PIN(PD,2)
+#define PIN_PD3 _HOST_PIN(PD,3)
+#define PIN_PD4 _HOST_PIN(PD,4)
+#define PIN_PD5 _HOST_PIN(PD,5)
+#define PIN_PD6 _HOST_PIN(PD,6)
+#define PIN_PD7 _HOST_PIN(PD,7)
+#define PIN_PE0 _HOST_PIN(PE,0)
+#define PIN_PE1 _HOST_PIN(PE,1)
+#define PIN_PE2 _HOST_PIN(PE,2)
+#define PIN_PE3 _HOST_PIN(PE,3)
+#define PIN_PE4 _HOST_PIN(PE,4)
+#define PIN_PE5 _HOST_PIN(PE,5)
+#define PIN_PE6 _HOST_PIN(PE,6)
+#define PIN_PE7 _HOST_PIN(PE,7)
+#define PIN_PF0 _HOST_PIN(PF,0)
+#define PIN_PF1 _HOST_PIN(PF,1)
+#define PIN_PF2 _HOST_PIN(PF,2)
+#define PIN_PF3 _HOST_PIN(PF,3)
+#define PIN_PF4 _HOST_PIN(PF,4)
+#define PIN_PF5 _HOST_PIN(PF,5)
+#define PIN_PG0 _HOST_PIN(PG,0)
+#define PIN_PG1 _HOST_PIN(PG,1)
+#define PIN_PG2 _HOST_PIN(PG,2)
+
+#define digitalPinToPort(pin)              (((pin) < NUM_TOTAL_PINS) ? ((pin) >> 3) : NOT_A_PIN)
+#define digitalPinToBitPosition(pin)       (((pin) < NUM_TOTAL_PINS) ? ((pin) & 0x07) : NOT_A_PIN)
+#define digitalPinToBitMask(pin)           (((pin) < NUM_TOTAL_PINS) ? (1 << ((pin) & 0x07)) : 0)
+#define digitalPinToPortStruct(pin)        (&hostPorts[(pin) >> 3])
+#define digitalPinToPortStatic(pin)        ((pin) >> 3)
+#define digitalPinToBitPositionStatic(pin) ((pin) & 0x07)
+#define digitalPinToBitMaskStatic(pin)     (1 << ((pin) & 0x07))
+#define digitalPinToAnalogInput(pin)       (((pin) >= PIN_PD0 && (pin) <= PIN_PD7) ? (pin) - PIN_PD0 :      \
+                                            ((pin) >= PIN_PE0 && (pin) <= PIN_PE3) ? (pin) - PIN_PE0 + 8 :  \
+                                            ((pin) >= PIN_PF0 && (pin) <= PIN_PF5) ? (pin) - PIN_PF0 + 16 : \
+                                            NOT_A_PIN)
+
+
+//******************************************************************************************************
+// Arduino functions. Time is simulated: delay() advances the simulation clock, which in turn runs
+// the TCA timers and calls the overflow ISRs.
+//******************************************************************************************************
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+uint8_t digitalRead(uint8_t pin);
+void digitalWriteFast(uint8_t pin, uint8_t value);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis();
+unsigned long micros();
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+#ifdef __cplusplus
+#include "Print.h"
+#endif
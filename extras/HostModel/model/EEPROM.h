@@ -0,0 +1,38 @@
+//******************************************************************************************************
+//
+// file:      EEPROM.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Host model of the EEPROM library. The EEPROM content is kept in RAM, and starts erased
+//            (0xFF), as on a new processor.
+//
+//******************************************************************************************************
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#define EEPROM_SIZE 512
+
+class EEPROMClass {
+  public:
+    uint8_t data[EEPROM_SIZE];
+    uint32_t writeCount;                           // number of cells that were actually written
+    EEPROMClass() {erase();}
+    void erase() {memset(data, 0xFF, sizeof(data));}
+    uint8_t read(int address) {return data[address % EEPROM_SIZE];}
+    void write(int address, uint8_t value) {data[address % EEPROM_SIZE] = value; writeCount++;}
+    void update(int address, uint8_t value) {if (read(address) != value) write(address, value);}
+    uint16_t length() {return EEPROM_SIZE;}
+    template <typename T> T &get(int address, T &t) {
+      memcpy(&t, &data[address % EEPROM_SIZE], sizeof(T));
+      return t;
+    }
+    template <typename T> const T &put(int address, const T &t) {
+      const uint8_t *p = (const uint8_t *)&t;
+      for (unsigned i = 0; i < sizeof(T); i++) update(address + i, p[i]);
+      return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
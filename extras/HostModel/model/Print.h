@@ -0,0 +1,65 @@
+//******************************************************************************************************
+//
+// file:      Print.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Host stand-in for the Arduino Print and Stream classes. Serial and Serial1 write to
+//            stdout.
+//
+//******************************************************************************************************
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+class Print {
+  public:
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+      size_t n = 0;
+      while (size--) n += write(*buffer++);
+      return n;
+    }
+    virtual int availableForWrite() {return 64;}
+    size_t print(const char *s) {return write((const uint8_t *)s, strlen(s));}
+    size_t print(char c) {return write((uint8_t)c);}
+    size_t print(long n) {char b[16]; snprintf(b, sizeof(b), "%ld", n); return print(b);}
+    size_t print(unsigned long n) {char b[16]; snprintf(b, sizeof(b), "%lu", n); return print(b);}
+    size_t print(int n) {return print((long)n);}
+    size_t print(unsigned int n) {return print((unsigned long)n);}
+    size_t print(uint8_t n) {return print((unsigned long)n);}
+    size_t println() {return print("\n");}
+    template <typename T> size_t println(T value) {size_t n = print(value); return n + println();}
+    size_t printf(const char *format, ...) {
+      char b[128];
+      va_list args;
+      va_start(args, format);
+      vsnprintf(b, sizeof(b), format, args);
+      va_end(args);
+      return print(b);
+    }
+    virtual ~Print() {}
+};
+
+class Stream: public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+class HostSerial: public Stream {
+  public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) {return fputc(c, stdout) == EOF ? 0 : 1;}
+    using Print::write;
+    int available() {return 0;}
+    int read() {return -1;}
+    int peek() {return -1;}
+};
+
+extern HostSerial Serial;
+extern HostSerial Serial1;
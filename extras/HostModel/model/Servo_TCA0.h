@@ -0,0 +1,7 @@
+//******************************************************************************************************
+// The library sources and the examples include "Servo_TCA0.h", whereas the file is called
+// "servo_TCA0.h". That works on the (case insensitive) file systems of Windows and macOS, but not on
+// Linux. This file bridges the difference for the host build.
+//******************************************************************************************************
+#pragma once
+#include "../../../src/servo_TCA0.h"
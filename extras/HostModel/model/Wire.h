@@ -0,0 +1,66 @@
+//******************************************************************************************************
+//
+// file:      Wire.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Host model of the Wire library, target mode only. A host program plays the controller:
+//            hostMasterWrite() delivers bytes as a controller write (calling the onReceive handler),
+//            and hostMasterRead() performs a controller read (calling the onRequest handler).
+//
+//******************************************************************************************************
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+  public:
+    void begin(uint8_t address) {this->address = address;}
+    void onReceive(void (*handler)(int)) {receiveHandler = handler;}
+    void onRequest(void (*handler)(void)) {requestHandler = handler;}
+    int available() {return rxLength - rxIndex;}
+    int read() {return (rxIndex < rxLength) ? buffer[rxIndex++] : -1;}
+    size_t write(uint8_t data) {
+      if (txLength >= BUFFER_LENGTH) return 0;
+      buffer[txLength++] = data;
+      return 1;
+    }
+    size_t write(const uint8_t *data, size_t length) {
+      size_t n = 0;
+      while ((n < length) && write(data[n])) n++;
+      return n;
+    }
+
+    // Host side. Returns the number of bytes transferred.
+    int hostMasterWrite(const uint8_t *data, int length) {
+      if (length > BUFFER_LENGTH) length = BUFFER_LENGTH;
+      for (int i = 0; i < length; i++) buffer[i] = data[i];
+      rxLength = length;
+      rxIndex = 0;
+      if (receiveHandler) receiveHandler(length);
+      rxLength = 0;
+      return length;
+    }
+    int hostMasterRead(uint8_t *data, int length) {
+      txLength = 0;
+      if (requestHandler) requestHandler();
+      if (length > txLength) length = txLength;  // A real controller would read padding
+      for (int i = 0; i < length; i++) data[i] = buffer[i];
+      txLength = 0;
+      return length;
+    }
+
+    uint8_t address = 0;
+
+  private:
+    void (*receiveHandler)(int) = 0;
+    void (*requestHandler)(void) = 0;
+    uint8_t buffer[BUFFER_LENGTH];
+    int rxLength = 0;
+    int rxIndex = 0;
+    int txLength = 0;
+};
+
+inline TwoWire Wire;
@@ -0,0 +1,316 @@
+//******************************************************************************************************
+//
+// file:      avr_model.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Host model of the AVR registers used by the Servo_TCA library: TCA0 / TCA1 in SINGLE
+//            mode, PORTMUX, the I/O ports, and the event system, TCB and ADC0 as far as they are
+//            used for frame-synchronised feedback sampling and frame synchronisation. The register
+//            names and bit masks are the same as in the Microchip headers (<avr/io.h>), so the
+//            library sources compile unmodified.
+//
+// Registers are modelled by small wrapper types. Writes to the Compare Buffer registers are logged
+// with a timestamp. The buffered registers (PERBUF, CMPnBUF) are copied into PER and CMPn on the
+// UPDATE condition (the overflow), exactly as the hardware does; after that the overflow ISR
+// (TCA0_OVF_vect / TCA1_OVF_vect) is called, provided INTCTRL enables it.
+//
+//******************************************************************************************************
+#pragma once
+#include <stdint.h>
+
+
+//******************************************************************************************************
+// Register wrappers
+//******************************************************************************************************
+struct reg8_t {
+  uint8_t value;
+  operator uint8_t() const {return value;}
+  reg8_t &operator=(uint8_t v) {value = v; return *this;}
+  reg8_t &operator|=(uint8_t v) {value |= v; return *this;}
+  reg8_t &operator&=(uint8_t v) {value &= v; return *this;}
+};
+
+struct flags8_t {                                  // Interrupt flags: writing a 1 clears the flag
+  uint8_t value;
+  operator uint8_t() const {return value;}
+  flags8_t &operator=(uint8_t v) {value &= ~v; return *this;}
+  flags8_t &operator|=(uint8_t v) {value |= v; return *this;}    // used by the model only
+};
+
+struct TCA_SINGLE_t;
+void hostLogBufferWrite(TCA_SINGLE_t *timer, uint8_t reg, uint16_t value);
+
+struct buf16_t {                                   // A Compare / Period buffer register
+  uint16_t value;
+  bool valid;                                      // BV flag: the buffer contains a new value
+  TCA_SINGLE_t *timer;
+  uint8_t reg;                                     // 0..2 = CMPnBUF, 3 = PERBUF
+  operator uint16_t() const {return value;}
+  buf16_t &operator=(uint16_t v) {
+    value = v;
+    valid = true;
+    hostLogBufferWrite(timer, reg, v);
+    return *this;
+  }
+};
+
+struct TCA_SINGLE_t {
+  reg8_t CTRLA;
+  reg8_t CTRLB;
+  reg8_t CTRLC;
+  reg8_t CTRLD;
+  reg8_t CTRLECLR;
+  reg8_t CTRLESET;
+  reg8_t CTRLFCLR;
+  reg8_t CTRLFSET;
+  reg8_t EVCTRL;
+  reg8_t INTCTRL;
+  flags8_t INTFLAGS;
+  reg8_t DBGCTRL;
+  uint16_t CNT;
+  uint16_t PER;
+  uint16_t CMP0;
+  uint16_t CMP1;
+  uint16_t CMP2;
+  buf16_t PERBUF;
+  buf16_t CMP0BUF;
+  buf16_t CMP1BUF;
+  buf16_t CMP2BUF;
+};
+
+typedef struct {
+  TCA_SINGLE_t SINGLE;
+  TCA_SINGLE_t SPLIT;                              // Only CTRLA / CTRLESET are used (MegaCoreX)
+} TCA_t;
+
+struct strobe8_t {                                 // OUTSET, OUTCLR, DIRSET ... act on OUT / DIR
+  reg8_t *target;
+  uint8_t operation;                               // 0 = set, 1 = clear, 2 = toggle
+  operator uint8_t() const {return target->value;}
+  strobe8_t &operator=(uint8_t v);
+};
+
+typedef struct {
+  reg8_t DIR;
+  strobe8_t DIRSET;
+  strobe8_t DIRCLR;
+  strobe8_t DIRTGL;
+  reg8_t OUT;
+  strobe8_t OUTSET;
+  strobe8_t OUTCLR;
+  strobe8_t OUTTGL;
+  reg8_t IN;
+} PORT_t;
+
+struct cycles16_t {                                // TCB CNT used as cycle counter: follows the CPU clock
+  operator uint16_t() const;
+  cycles16_t &operator=(uint16_t v) {return *this;}
+};
+
+typedef struct {                                   // Cycle counter, or single shot mode started by an event
+  reg8_t CTRLA;
+  reg8_t CTRLB;
+  reg8_t EVCTRL;
+  reg8_t INTCTRL;
+  flags8_t INTFLAGS;
+  cycles16_t CNT;
+  uint16_t CCMP;
+} TCB_t;
+
+typedef struct {                                   // Only STATUS; the EEPROM model is never busy
+  reg8_t CTRLA;
+  reg8_t CTRLB;
+  reg8_t STATUS;
+} NVMCTRL_t;
+
+typedef struct {                                   // Only the conversions started by an event are modelled
+  reg8_t CTRLA;
+  reg8_t CTRLB;
+  reg8_t CTRLC;
+  reg8_t CTRLD;
+  reg8_t MUXPOS;
+  reg8_t MUXNEG;
+  reg8_t COMMAND;
+  reg8_t EVCTRL;
+  reg8_t INTCTRL;
+  flags8_t INTFLAGS;
+  uint16_t RES;
+} ADC_t;
+
+typedef struct {                                   // Channels and the users the library needs
+  reg8_t CHANNEL0;
+  reg8_t CHANNEL1;
+  reg8_t CHANNEL2;
+  reg8_t CHANNEL3;
+  reg8_t CHANNEL4;
+  reg8_t CHANNEL5;
+  reg8_t CHANNEL6;
+  reg8_t CHANNEL7;
+  reg8_t CHANNEL8;
+  reg8_t CHANNEL9;
+  reg8_t USERTCB0CAPT;
+  reg8_t USERTCB1CAPT;
+  reg8_t USERADC0START;
+  reg8_t USERTCA0CNTB;
+  reg8_t USERTCA1CNTB;
+} EVSYS_t;
+
+typedef struct {
+  reg8_t TCAROUTEA;
+  reg8_t CTRLC;
+  reg8_t EVSYSROUTEA;
+} PORTMUX_t;
+
+
+//******************************************************************************************************
+// Register instances and names
+//******************************************************************************************************
+extern TCA_t hostTCA0;
+extern TCA_t hostTCA1;
+extern PORTMUX_t hostPORTMUX;
+extern PORT_t hostPorts[7];
+extern TCB_t hostTCB0;
+extern TCB_t hostTCB1;
+extern NVMCTRL_t hostNVMCTRL;
+extern ADC_t hostADC0;
+extern EVSYS_t hostEVSYS;
+
+#define TCA0    hostTCA0
+#define TCA1    hostTCA1
+#define PORTMUX hostPORTMUX
+#define TCB0    hostTCB0
+#define TCB1    hostTCB1
+#define NVMCTRL hostNVMCTRL
+#define ADC0    hostADC0
+#define ADC0_RES hostADC0.RES                      // As the io headers of the parts with ADC0.RES
+#define EVSYS   hostEVSYS
+#define PORTA   hostPorts[0]
+#define PORTB   hostPorts[1]
+#define PORTC   hostPorts[2]
+#define PORTD   hostPorts[3]
+#define PORTE   hostPorts[4]
+#define PORTF   hostPorts[5]
+#define PORTG   hostPorts[6]
+
+
+//******************************************************************************************************
+// Bit masks and group configurations, as in the AVR Dx headers
+//******************************************************************************************************
+#define TCA_SINGLE_ENABLE_bm              0x01
+#define TCA_SINGLE_CLKSEL_gm              0x0E
+#define TCA_SINGLE_CLKSEL_DIV1_gc         (0x00 << 1)
+#define TCA_SINGLE_CLKSEL_DIV2_gc         (0x01 << 1)
+#define TCA_SINGLE_CLKSEL_DIV4_gc         (0x02 << 1)
+#define TCA_SINGLE_CLKSEL_DIV8_gc         (0x03 << 1)
+#define TCA_SINGLE_CLKSEL_DIV16_gc        (0x04 << 1)
+#define TCA_SINGLE_CLKSEL_DIV64_gc        (0x05 << 1)
+#define TCA_SINGLE_CLKSEL_DIV256_gc       (0x06 << 1)
+#define TCA_SINGLE_CLKSEL_DIV1024_gc      (0x07 << 1)
+#define TCA_SINGLE_WGMODE_gm              0x07
+#define TCA_SINGLE_WGMODE_NORMAL_gc       0x00
+#define TCA_SINGLE_WGMODE_SINGLESLOPE_gc  0x03
+#define TCA_SINGLE_CMP0EN_bm              0x10
+#define TCA_SINGLE_CMP1EN_bm              0x20
+#define TCA_SINGLE_CMP2EN_bm              0x40
+#define TCA_SINGLE_CNTEI_bm               0x01
+#define TCA_SINGLE_CNTAEI_bm              0x01
+#define TCA_SINGLE_EVACTA_gm              0x0E
+#define TCA_SINGLE_CNTBEI_bm              0x10
+#define TCA_SINGLE_EVACTB_gm              0xE0
+#define TCA_SINGLE_EVACTB_RESTART_POSEDGE_gc (0x04 << 5)
+#define TCA_SINGLE_OVF_bm                 0x01
+#define TCA_SINGLE_CMP0_bm                0x10
+#define TCA_SINGLE_CMP1_bm                0x20
+#define TCA_SINGLE_CMP2_bm                0x40
+#define TCA_SINGLE_CMD_RESTART_gc         (0x02 << 2)
+#define TCA_SPLIT_CMD_RESET_gc            (0x03 << 2)
+
+#define TCB_ENABLE_bm                     0x01
+#define TCB_CLKSEL_gm                     0x0E
+#define TCB_CLKSEL_DIV1_gc                (0x00 << 1)
+#define TCB_CLKSEL_DIV2_gc                (0x01 << 1)
+#define TCB_CLKSEL_TCA0_gc                (0x02 << 1)
+#define TCB_CLKSEL_TCA1_gc                (0x03 << 1)
+#define TCB_CNTMODE_gm                    0x07
+#define TCB_CNTMODE_INT_gc                0x00
+#define TCB_CNTMODE_SINGLE_gc             0x06
+#define TCB_CAPTEI_bm                     0x01
+#define TCB_CAPT_bm                       0x01
+
+#define ADC_ENABLE_bm                     0x01
+#define ADC_STARTEI_bm                    0x01
+#define ADC_RESRDY_bm                     0x01
+#define ADC_MUXPOS_GND_gc                 0x40
+
+#define EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc   0x80       // Event generators, as for the AVR DA / DB
+#define EVSYS_CHANNEL0_TCA1_OVF_LUNF_gc   0x88
+#define EVSYS_CHANNEL0_TCB1_CAPT_gc       0xA2
+
+#define NVMCTRL_EEBUSY_bm                 0x02
+
+#define PORTMUX_TCA0_gm                   0x07
+#define PORTMUX_TCA0_PORTA_gc             0x00
+#define PORTMUX_TCA0_PORTB_gc             0x01
+#define PORTMUX_TCA0_PORTC_gc             0x02
+#define PORTMUX_TCA0_PORTD_gc             0x03
+#define PORTMUX_TCA0_PORTE_gc             0x04
+#define PORTMUX_TCA0_PORTF_gc             0x05
+#define PORTMUX_TCA0_PORTG_gc             0x06
+#define PORTMUX_TCA1_gm                   0x38
+#define PORTMUX_TCA1_PORTB_gc             (0x00 << 3)
+#define PORTMUX_TCA1_PORTC_gc             (0x01 << 3)
+#define PORTMUX_TCA1_PORTE_gc             (0x02 << 3)
+#define PORTMUX_TCA1_PORTG_gc             (0x03 << 3)
+
+
+//******************************************************************************************************
+// Interrupts. ISR(vect) becomes an ordinary C function, which the model calls on overflow.
+//******************************************************************************************************
+#define ISR(vect) extern "C" void vect(void)
+#define TCA0_OVF_vect hostTCA0_OVF_vect
+#define TCA1_OVF_vect hostTCA1_OVF_vect
+#define ADC0_RESRDY_vect hostADC0_RESRDY_vect
+
+struct sreg_t {                                    // Only the I-bit (bit 7) is modelled. Setting it runs
+                                                   // pending ISRs, as the hardware would
+  operator uint8_t() const;
+  sreg_t &operator=(uint8_t v);
+};
+extern sreg_t SREG;
+#define cli() (SREG = 0)
+#define sei() (SREG = 0x80)
+
+void takeOverTCA0();
+void takeOverTCA1();
+void resumeTCA0();
+void resumeTCA1();
+
+
+//******************************************************************************************************
+// Simulation control, used by the host programs (not by the library)
+//******************************************************************************************************
+typedef struct {
+  uint64_t cycles;                                 // simulated time since reset, in CPU clock cycles
+  bool sreg_i;                                     // global interrupt enable
+  bool logBufferWrites;                            // print every CMPnBUF / PERBUF write on stdout
+  uint8_t pinDir[56];                              // pinMode() per pin
+  uint8_t pinOut[56];                              // digitalWrite() per pin
+  // Optional hooks for the host programs
+  uint32_t (*isrLatency)(uint8_t timer);           // cycles between overflow and start of the ISR
+  void (*onUpdate)(uint8_t timer, TCA_SINGLE_t *registers);    // called at every UPDATE condition
+  void (*onBufferWrite)(uint8_t timer, uint8_t reg, uint16_t value);
+  void (*onPinWrite)(uint8_t pin, uint8_t value);
+  uint16_t (*adcValue)(uint8_t muxpos);            // the simulated ADC: result of a conversion of MUXPOS
+  void (*onRestart)(uint8_t timer, uint16_t count);  // an event restarted the counter, which was at count
+  void (*onWaveform)(uint8_t timer, uint8_t unit, uint8_t level);  // waveform output WOn changed
+} hostModel_t;
+
+extern hostModel_t hostModel;
+
+void hostReset();                                  // power-on reset of the model
+void hostAdvance(uint32_t us);                     // advance the simulated time, running the timers
+uint32_t hostTimerClock(const TCA_SINGLE_t *timer); // timer clock in Hz, derived from CTRLA
+void hostEventSource(uint8_t channel, uint32_t periodUs, uint32_t firstUs);  // events on a channel; period 0 = off
+bool hostVcdOpen(const char *file);                // write the waveform outputs of both timers as VCD
+void hostVcdClose();
@@ -0,0 +1,499 @@
+//******************************************************************************************************
+//
+// file:      host_model.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Implementation of the host model: simulated time, the TCA0 / TCA1 counters, the UPDATE
+//            condition with its buffered registers, the waveform outputs, the overflow interrupts, the
+//            event system (TCA overflow -> TCB single shot -> ADC conversion, external source -> TCA
+//            restart) and the Arduino calls the library uses.
+//
+// Time is kept in CPU clock cycles. The timers are not stepped tick by tick; instead hostAdvance()
+// jumps from one event (an overflow, or a pending ISR) to the next. The overflow itself (copying
+// PERBUF / CMPnBUF into PER / CMPn) happens at the exact cycle, as it does in hardware. The ISR
+// starts hostModel.isrLatency() cycles later, which allows interrupt load to be injected.
+//
+// The waveform outputs WO0..WO2 follow single slope PWM: at the UPDATE an output becomes high if its
+// CMPn is not 0 (and stays high if CMPn > PER), and the compare match (CNT reaches CMPn) makes it low
+// again. The compare match is an event of its own, so each change is reported at its exact cycle, to
+// the onWaveform hook and to the VCD file of hostVcdOpen(). A restart doesn't change the outputs; a
+// pulse that is still high is lengthened. The outputs are those of the waveform generator: CMPnEN,
+// PORTMUX and the pin direction are not taken into account.
+//
+// Events are only passed on to the users that the library needs: TCB0 / TCB1 capture (single shot
+// mode), ADC0 start and TCA0 / TCA1 event input B (restart on the positive edge). A restart sets CNT
+// to 0 without an UPDATE condition: the buffered registers are not copied and no ISR is called.
+// hostEventSource() plays an external generator, such as a pin with a sync signal, that gives an event
+// on a channel at a fixed period. A conversion takes ADC_CONVERSION_US; its result is whatever the host program
+// returns from hostModel.adcValue() for the selected MUXPOS, sampled at the start of the conversion.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "host_model.h"
+
+TCA_t hostTCA0;
+TCA_t hostTCA1;
+PORTMUX_t hostPORTMUX;
+PORT_t hostPorts[7];
+TCB_t hostTCB0;
+TCB_t hostTCB1;
+NVMCTRL_t hostNVMCTRL;
+ADC_t hostADC0;
+EVSYS_t hostEVSYS;
+hostModel_t hostModel;
+sreg_t SREG;
+hostTimer_t hostTimers[2];
+int hostFailures = 0;
+EEPROMClass EEPROM;
+HostSerial Serial;
+HostSerial Serial1;
+
+// The ISRs are defined by servo_TCA0.cpp and servo_TCA1.cpp. A program may link only one of them.
+extern "C" void hostTCA0_OVF_vect(void) __attribute__((weak));
+extern "C" void hostTCA1_OVF_vect(void) __attribute__((weak));
+extern "C" void hostADC0_RESRDY_vect(void) __attribute__((weak));   // TCA_MobaFeedback/feedback.cpp
+
+static const char *regNames[4] = {"CMP0BUF", "CMP1BUF", "CMP2BUF", "PERBUF"};
+
+#define GENERATOR_TCA0_OVF     0x80                // Event generators, as in the AVR Dx datasheet
+#define GENERATOR_TCA1_OVF     0x88
+#define GENERATOR_TCB0_CAPT    0xA0
+#define GENERATOR_TCB1_CAPT    0xA2
+#define EVENT_CHANNELS           10
+#define ADC_CONVERSION_US        12                // About 13.5 ADC clocks at 1 MHz, plus sampling
+
+static struct {                                    // Simulation state of TCB0 / TCB1 and ADC0
+  bool tcbRunning[2];                              // single shot started, CAPT not yet reached
+  uint64_t tcbCaptureAt[2];
+  bool adcBusy;                                    // a conversion is running
+  uint64_t adcReadyAt;
+  uint16_t adcSample;
+  bool adcIsrPending;                              // result ready, ISR not yet executed
+  uint8_t sourceChannel;                           // hostEventSource()
+  uint32_t sourcePeriod;                           // us; 0 = no source
+  uint64_t sourceAt;                               // cycle of the next event of the source
+} peripherals;
+
+static FILE *vcdFile = 0;                          // hostVcdOpen()
+static uint64_t vcdTime;                           // ns, of the latest time stamp in the file
+
+static void generateEvent(uint8_t generator);
+static void vcdChange(uint8_t timer, uint8_t unit, uint8_t level);
+
+
+//******************************************************************************************************
+// Timer helpers
+//******************************************************************************************************
+static uint8_t prescaler(const TCA_SINGLE_t *timer) {
+  static const uint16_t div[8] = {1, 2, 4, 8, 16, 64, 256, 1024};
+  return div[(timer->CTRLA & TCA_SINGLE_CLKSEL_gm) >> 1];
+}
+
+uint32_t hostTimerClock(const TCA_SINGLE_t *timer) {
+  return F_CPU / prescaler(timer);
+}
+
+uint16_t hostTicks(uint16_t us) {
+  return (uint64_t)us * hostTimerClock(&hostTCA0.SINGLE) / 1000000UL;
+}
+
+static bool isRunning(const hostTimer_t *t) {
+  return (t->tca->SINGLE.CTRLA & TCA_SINGLE_ENABLE_bm);
+}
+
+// Bring CNT up to date for the current time
+static void syncCounter(hostTimer_t *t) {
+  if (!isRunning(t)) {t->base = hostModel.cycles; return;}
+  uint16_t div = prescaler(&t->tca->SINGLE);
+  uint64_t ticks = (hostModel.cycles - t->base) / div;
+  t->tca->SINGLE.CNT += ticks;
+  t->base += ticks * div;
+}
+
+static uint64_t nextOverflow(const hostTimer_t *t) {
+  const TCA_SINGLE_t *timer = &t->tca->SINGLE;
+  uint32_t ticksLeft = (uint32_t)timer->PER - timer->CNT + 1;
+  return t->base + (uint64_t)ticksLeft * prescaler(timer);
+}
+
+static uint16_t compareValue(const TCA_SINGLE_t *timer, uint8_t unit) {
+  return (unit == 0) ? timer->CMP0 : (unit == 1) ? timer->CMP1 : timer->CMP2;
+}
+
+static void setWaveform(hostTimer_t *t, uint8_t unit, uint8_t level) {
+  if (((t->wo >> unit) & 1) == level) return;
+  t->wo ^= (1 << unit);
+  if (hostModel.onWaveform) hostModel.onWaveform(t->number, unit, level);
+  vcdChange(t->number, unit, level);
+}
+
+// The next compare match that makes a high output low; returns UINT64_MAX if there is none. A match
+// at the current count is still due: another event may have been handled at the same cycle.
+static uint64_t nextMatch(const hostTimer_t *t, uint8_t *unit) {
+  const TCA_SINGLE_t *timer = &t->tca->SINGLE;
+  uint64_t next = UINT64_MAX;
+  for (uint8_t i = 0; i < 3; i++) {
+    uint16_t cmp = compareValue(timer, i);
+    if (!((t->wo >> i) & 1) || (cmp > timer->PER) || (cmp < timer->CNT)) continue;
+    uint64_t at = t->base + (uint64_t)(cmp - timer->CNT) * prescaler(timer);
+    if (at < next) {next = at; *unit = i;}
+  }
+  return next;
+}
+
+static void update(hostTimer_t *t) {                 // The UPDATE condition at BOTTOM
+  TCA_SINGLE_t *timer = &t->tca->SINGLE;
+  timer->CNT = 0;
+  t->base = hostModel.cycles;
+  if (timer->PERBUF.valid) {timer->PER = timer->PERBUF.value; timer->PERBUF.valid = false;}
+  if (timer->CMP0BUF.valid) {timer->CMP0 = timer->CMP0BUF.value; timer->CMP0BUF.valid = false;}
+  if (timer->CMP1BUF.valid) {timer->CMP1 = timer->CMP1BUF.value; timer->CMP1BUF.valid = false;}
+  if (timer->CMP2BUF.valid) {timer->CMP2 = timer->CMP2BUF.value; timer->CMP2BUF.valid = false;}
+  for (uint8_t i = 0; i < 3; i++) setWaveform(t, i, compareValue(timer, i) != 0);
+  timer->INTFLAGS |= TCA_SINGLE_OVF_bm;
+  t->overflows++;
+  if (hostModel.onUpdate) hostModel.onUpdate(t->number, timer);
+  if (timer->INTCTRL & TCA_SINGLE_OVF_bm) {
+    uint32_t latency = (hostModel.isrLatency) ? hostModel.isrLatency(t->number) : 0;
+    t->isrPending = true;
+    t->isrAt = hostModel.cycles + latency;
+  }
+  generateEvent((t->number == 0) ? GENERATOR_TCA0_OVF : GENERATOR_TCA1_OVF);
+}
+
+static void runIsr(hostTimer_t *t) {
+  t->isrPending = false;
+  if (t->number == 0) {if (hostTCA0_OVF_vect) hostTCA0_OVF_vect();}
+  else {if (hostTCA1_OVF_vect) hostTCA1_OVF_vect();}
+  t->isrCount++;
+}
+
+
+//******************************************************************************************************
+// Event system, TCB single shot and ADC0
+//******************************************************************************************************
+static void startTcb(uint8_t number) {             // CNT restarts, CAPT is reached at CCMP
+  TCB_t *tcb = (number == 0) ? &hostTCB0 : &hostTCB1;
+  if (!(tcb->CTRLA & TCB_ENABLE_bm) || !(tcb->EVCTRL & TCB_CAPTEI_bm)) return;
+  if ((tcb->CTRLB & TCB_CNTMODE_gm) != TCB_CNTMODE_SINGLE_gc) return;
+  if (peripherals.tcbRunning[number]) return;      // Events are ignored while counting
+  uint16_t div;
+  switch (tcb->CTRLA & TCB_CLKSEL_gm) {
+    case TCB_CLKSEL_DIV2_gc: div = 2; break;
+    case TCB_CLKSEL_TCA0_gc: div = prescaler(&hostTCA0.SINGLE); break;
+    case TCB_CLKSEL_TCA1_gc: div = prescaler(&hostTCA1.SINGLE); break;
+    default: div = 1;
+  }
+  peripherals.tcbRunning[number] = true;
+  peripherals.tcbCaptureAt[number] = hostModel.cycles + (uint64_t)tcb->CCMP * div;
+}
+
+static void captureTcb(uint8_t number) {
+  TCB_t *tcb = (number == 0) ? &hostTCB0 : &hostTCB1;
+  peripherals.tcbRunning[number] = false;
+  tcb->INTFLAGS |= TCB_CAPT_bm;
+  generateEvent((number == 0) ? GENERATOR_TCB0_CAPT : GENERATOR_TCB1_CAPT);
+}
+
+static void startAdc() {
+  if (!(hostADC0.CTRLA & ADC_ENABLE_bm) || !(hostADC0.EVCTRL & ADC_STARTEI_bm)) return;
+  if (peripherals.adcBusy) return;
+  peripherals.adcSample = (hostModel.adcValue) ? hostModel.adcValue(hostADC0.MUXPOS) : 0;
+  peripherals.adcBusy = true;
+  peripherals.adcReadyAt = hostModel.cycles + (uint64_t)ADC_CONVERSION_US * clockCyclesPerMicrosecond();
+}
+
+static void finishAdc() {
+  peripherals.adcBusy = false;
+  hostADC0.RES = peripherals.adcSample;
+  hostADC0.INTFLAGS |= ADC_RESRDY_bm;
+  if (hostADC0.INTCTRL & ADC_RESRDY_bm) peripherals.adcIsrPending = true;
+}
+
+static void runAdcIsr() {
+  peripherals.adcIsrPending = false;
+  if (hostADC0_RESRDY_vect) hostADC0_RESRDY_vect();
+}
+
+static void restartTca(uint8_t number) {           // Event input B with EVACTB = RESTART_POSEDGE
+  hostTimer_t *t = &hostTimers[number];
+  TCA_SINGLE_t *timer = &t->tca->SINGLE;
+  if (!isRunning(t) || !(timer->EVCTRL & TCA_SINGLE_CNTBEI_bm)) return;
+  if ((timer->EVCTRL & TCA_SINGLE_EVACTB_gm) != TCA_SINGLE_EVACTB_RESTART_POSEDGE_gc) return;
+  if (hostModel.onRestart) hostModel.onRestart(number, timer->CNT);
+  timer->CNT = 0;
+  t->base = hostModel.cycles;
+}
+
+static void channelEvent(uint8_t i) {              // Passes an event on channel i to its users
+  uint8_t user = i + 1;                            // EVSYS_USER_CHANNELn_gc
+  if (hostEVSYS.USERTCB0CAPT == user) startTcb(0);
+  if (hostEVSYS.USERTCB1CAPT == user) startTcb(1);
+  if (hostEVSYS.USERADC0START == user) startAdc();
+  if (hostEVSYS.USERTCA0CNTB == user) restartTca(0);
+  if (hostEVSYS.USERTCA1CNTB == user) restartTca(1);
+}
+
+static void generateEvent(uint8_t generator) {
+  reg8_t *channel = &hostEVSYS.CHANNEL0;
+  for (uint8_t i = 0; i < EVENT_CHANNELS; i++) {
+    if (channel[i] == generator) channelEvent(i);
+  }
+}
+
+void hostEventSource(uint8_t channel, uint32_t periodUs, uint32_t firstUs) {
+  peripherals.sourceChannel = channel;
+  peripherals.sourcePeriod = periodUs;
+  peripherals.sourceAt = hostModel.cycles + (uint64_t)firstUs * clockCyclesPerMicrosecond();
+}
+
+
+//******************************************************************************************************
+// VCD output of the waveform outputs. Identifiers '!' .. '&' are TCA0.WO0 .. TCA1.WO2.
+//******************************************************************************************************
+static uint64_t vcdNanoseconds() {
+  return hostModel.cycles * 1000000000ULL / F_CPU;
+}
+
+static void vcdChange(uint8_t timer, uint8_t unit, uint8_t level) {
+  if (vcdFile == 0) return;
+  uint64_t now = vcdNanoseconds();
+  if (now != vcdTime) fprintf(vcdFile, "#%llu\n", (unsigned long long)now);
+  vcdTime = now;
+  fprintf(vcdFile, "%u%c\n", level, '!' + 3 * timer + unit);
+}
+
+bool hostVcdOpen(const char *file) {
+  hostVcdClose();
+  vcdFile = fopen(file, "w");
+  if (vcdFile == 0) return false;
+  fprintf(vcdFile, "$timescale 1 ns $end\n$scope module servo $end\n");
+  for (uint8_t i = 0; i < 6; i++) {
+    fprintf(vcdFile, "$var wire 1 %c TCA%u.WO%u $end\n", '!' + i, i / 3, i % 3);
+  }
+  fprintf(vcdFile, "$upscope $end\n$enddefinitions $end\n");
+  vcdTime = vcdNanoseconds();
+  fprintf(vcdFile, "#%llu\n$dumpvars\n", (unsigned long long)vcdTime);
+  for (uint8_t i = 0; i < 6; i++) {
+    fprintf(vcdFile, "%u%c\n", (hostTimers[i / 3].wo >> (i % 3)) & 1, '!' + i);
+  }
+  fprintf(vcdFile, "$end\n");
+  return true;
+}
+
+void hostVcdClose() {
+  if (vcdFile == 0) return;
+  uint64_t now = vcdNanoseconds();
+  if (now != vcdTime) fprintf(vcdFile, "#%llu\n", (unsigned long long)now);   // Shows the final levels
+  fclose(vcdFile);
+  vcdFile = 0;
+}
+
+
+//******************************************************************************************************
+// Simulation control
+//******************************************************************************************************
+void hostReset() {
+  hostVcdClose();                                  // The time restarts at 0
+  memset(&hostTCA0, 0, sizeof(hostTCA0));
+  memset(&hostTCA1, 0, sizeof(hostTCA1));
+  memset(&hostPORTMUX, 0, sizeof(hostPORTMUX));
+  memset(hostPorts, 0, sizeof(hostPorts));
+  memset(&hostTCB0, 0, sizeof(hostTCB0));
+  memset(&hostTCB1, 0, sizeof(hostTCB1));
+  memset(&hostNVMCTRL, 0, sizeof(hostNVMCTRL));
+  memset(&hostADC0, 0, sizeof(hostADC0));
+  memset(&hostEVSYS, 0, sizeof(hostEVSYS));
+  memset(&peripherals, 0, sizeof(peripherals));
+  memset(hostTimers, 0, sizeof(hostTimers));
+  hostTimers[0].tca = &hostTCA0;
+  hostTimers[1].tca = &hostTCA1;
+  hostTimers[1].number = 1;
+  TCA_SINGLE_t *timers[2] = {&hostTCA0.SINGLE, &hostTCA1.SINGLE};
+  for (uint8_t i = 0; i < 2; i++) {
+    timers[i]->PER = 0xFFFF;
+    timers[i]->PERBUF.timer = timers[i];
+    timers[i]->PERBUF.reg = 3;
+    timers[i]->CMP0BUF.timer = timers[i];
+    timers[i]->CMP0BUF.reg = 0;
+    timers[i]->CMP1BUF.timer = timers[i];
+    timers[i]->CMP1BUF.reg = 1;
+    timers[i]->CMP2BUF.timer = timers[i];
+    timers[i]->CMP2BUF.reg = 2;
+  }
+  for (uint8_t i = 0; i < 7; i++) {
+    PORT_t *port = &hostPorts[i];
+    port->DIRSET.target = &port->DIR; port->DIRSET.operation = 0;
+    port->DIRCLR.target = &port->DIR; port->DIRCLR.operation = 1;
+    port->DIRTGL.target = &port->DIR; port->DIRTGL.operation = 2;
+    port->OUTSET.target = &port->OUT; port->OUTSET.operation = 0;
+    port->OUTCLR.target = &port->OUT; port->OUTCLR.operation = 1;
+    port->OUTTGL.target = &port->OUT; port->OUTTGL.operation = 2;
+  }
+  hostModel.cycles = 0;
+  hostModel.sreg_i = true;
+  memset(hostModel.pinDir, 0, sizeof(hostModel.pinDir));
+  memset(hostModel.pinOut, 0, sizeof(hostModel.pinOut));
+}
+
+
+void hostAdvance(uint32_t us) {
+  uint64_t target = hostModel.cycles + (uint64_t)us * clockCyclesPerMicrosecond();
+  for (;;) {
+    uint64_t next = target;
+    hostTimer_t *event = 0;
+    bool isIsr = false;
+    int8_t other = -1;                             // 0 / 1 = TCB capture, 2 = ADC result, 3 = ADC ISR, 4 = source,
+    uint8_t matchTimer = 0;                        // 5 = compare match
+    uint8_t matchUnit = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+      hostTimer_t *t = &hostTimers[i];
+      if (t->isrPending && hostModel.sreg_i && (t->isrAt <= next)) {
+        next = t->isrAt; event = t; isIsr = true;
+      }
+      if (isRunning(t) && (nextOverflow(t) < next || (nextOverflow(t) == next && !isIsr))) {
+        if (nextOverflow(t) <= next) {next = nextOverflow(t); event = t; isIsr = false;}
+      }
+    }
+    // At the same cycle, the TCA events go first (the TCA overflow vectors have higher priority)
+    for (uint8_t i = 0; i < 2; i++) {
+      uint8_t unit = 0;
+      uint64_t match = isRunning(&hostTimers[i]) ? nextMatch(&hostTimers[i], &unit) : UINT64_MAX;
+      if (match < next) {next = match; other = 5; matchTimer = i; matchUnit = unit;}
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+      if (peripherals.tcbRunning[i] && (peripherals.tcbCaptureAt[i] < next)) {
+        next = peripherals.tcbCaptureAt[i]; other = i;
+      }
+    }
+    if (peripherals.adcBusy && (peripherals.adcReadyAt < next)) {next = peripherals.adcReadyAt; other = 2;}
+    if (peripherals.adcIsrPending && hostModel.sreg_i && (hostModel.cycles < next)) {
+      next = hostModel.cycles; other = 3;
+    }
+    if (peripherals.sourcePeriod && (peripherals.sourceAt < next)) {next = peripherals.sourceAt; other = 4;}
+    if (other >= 0) event = 0;
+    hostModel.cycles = next;
+    for (uint8_t i = 0; i < 2; i++) {
+      if (&hostTimers[i] != event || isIsr) syncCounter(&hostTimers[i]);
+    }
+    if (other >= 0) {
+      if (other < 2) captureTcb(other);
+      else if (other == 2) finishAdc();
+      else if (other == 3) runAdcIsr();
+      else if (other == 5) setWaveform(&hostTimers[matchTimer], matchUnit, 0);
+      else {
+        peripherals.sourceAt += (uint64_t)peripherals.sourcePeriod * clockCyclesPerMicrosecond();
+        channelEvent(peripherals.sourceChannel);
+      }
+      continue;
+    }
+    if (event == 0) break;
+    if (isIsr) runIsr(event);
+    else update(event);
+  }
+}
+
+
+void hostLogBufferWrite(TCA_SINGLE_t *timer, uint8_t reg, uint16_t value) {
+  uint8_t number = (timer == &hostTCA1.SINGLE) ? 1 : 0;
+  if (hostModel.onBufferWrite) hostModel.onBufferWrite(number, reg, value);
+  if (hostModel.logBufferWrites) {
+    printf("%10.3f us  TCA%u.%s = %u\n", (double)hostModel.cycles / clockCyclesPerMicrosecond(),
+      number, regNames[reg], value);
+  }
+}
+
+
+// Writes to OUTSET / OUTCLR / OUTTGL update OUT, and are reported per pin to the onPinWrite hook 
+strobe8_t &strobe8_t::operator=(uint8_t v) {
+  uint8_t old = target->value;
+  if (operation == 0) target->value |= v;
+  else if (operation == 1) target->value &= ~v;
+  else target->value ^= v;
+  for (uint8_t port = 0; port < 7; port++) {
+    if (target != &hostPorts[port].OUT) continue;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      uint8_t pin = port * 8 + bit;
+      if (pin >= NUM_TOTAL_PINS) break;
+      hostModel.pinOut[pin] = (target->value >> bit) & 1;
+      if (((old ^ target->value) & (1 << bit)) && hostModel.onPinWrite) {
+        hostModel.onPinWrite(pin, hostModel.pinOut[pin]);
+      }
+    }
+  }
+  return *this;
+}
+
+sreg_t::operator uint8_t() const {
+  return hostModel.sreg_i ? 0x80 : 0;
+}
+
+sreg_t &sreg_t::operator=(uint8_t v) {
+  hostModel.sreg_i = (v & 0x80);
+  for (uint8_t i = 0; i < 2; i++) {
+    hostTimer_t *t = &hostTimers[i];
+    if (hostModel.sreg_i && t->isrPending && (t->isrAt <= hostModel.cycles)) runIsr(t);
+  }
+  if (hostModel.sreg_i && peripherals.adcIsrPending) runAdcIsr();
+  return *this;
+}
+
+cycles16_t::operator uint16_t() const {
+  return (uint16_t)hostModel.cycles;
+}
+
+
+//******************************************************************************************************
+// DxCore functions to take over / give back the TCA timer
+//******************************************************************************************************
+void takeOverTCA0() {hostTCA0.SINGLE.CTRLA = 0; hostTCA0.SINGLE.CTRLB = 0;}
+void takeOverTCA1() {hostTCA1.SINGLE.CTRLA = 0; hostTCA1.SINGLE.CTRLB = 0;}
+void resumeTCA0() {}
+void resumeTCA1() {}
+
+
+//******************************************************************************************************
+// Arduino functions
+//******************************************************************************************************
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= NUM_TOTAL_PINS) return;
+  hostModel.pinDir[pin] = mode;
+  if (mode == OUTPUT) hostPorts[pin >> 3].DIRSET = (1 << (pin & 7));
+  else hostPorts[pin >> 3].DIRCLR = (1 << (pin & 7));
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= NUM_TOTAL_PINS) return;
+  if (value) hostPorts[pin >> 3].OUTSET = (1 << (pin & 7));
+  else hostPorts[pin >> 3].OUTCLR = (1 << (pin & 7));
+}
+
+void digitalWriteFast(uint8_t pin, uint8_t value) {
+  digitalWrite(pin, value);
+}
+
+uint8_t digitalRead(uint8_t pin) {
+  return (pin < NUM_TOTAL_PINS) ? hostModel.pinOut[pin] : LOW;
+}
+
+void delay(unsigned long ms) {
+  hostAdvance(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us) {
+  hostAdvance(us);
+}
+
+unsigned long millis() {
+  return hostModel.cycles / clockCyclesPerMicrosecond() / 1000UL;
+}
+
+unsigned long micros() {
+  return hostModel.cycles / clockCyclesPerMicrosecond();
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
@@ -0,0 +1,34 @@
+//******************************************************************************************************
+//
+// file:      host_model.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Interface of the host model towards the host programs (simulator, tests). The library
+//            itself only sees Arduino.h, EEPROM.h and the registers in avr_model.h.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+typedef struct {                                   // Simulation state per TCA timer
+  TCA_t *tca;
+  uint8_t number;                                  // 0 = TCA0, 1 = TCA1
+  uint64_t base;                                   // cycle at which CNT had its current value
+  bool isrPending;                                 // overflow happened, ISR not yet executed
+  uint64_t isrAt;                                  // cycle at which the pending ISR will run
+  uint32_t overflows;                              // number of UPDATE conditions
+  uint32_t isrCount;                               // number of ISR invocations
+  uint8_t wo;                                      // bit n: level of waveform output WOn
+} hostTimer_t;
+
+extern hostTimer_t hostTimers[2];
+
+uint16_t hostTicks(uint16_t us);                   // us in ticks of TCA0 (TCA1 uses the same prescaler)
+
+// The checks of the test programs: a failed condition is printed with its line, and counted
+extern int hostFailures;
+
+#define CHECK(condition) do {                                                    \
+  if (!(condition)) {printf("FAIL line %d: %s\n", __LINE__, #condition); hostFailures++;} \
+} while (0)
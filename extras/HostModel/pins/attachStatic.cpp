@@ -0,0 +1,107 @@
+//******************************************************************************************************
+//
+// file:      attachStatic.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Test of attach<pin>() on the host model. attach<pin>() writes the PORTMUX and CTRLB
+//            values of the pin inline, as constants from TCA_Pins/pinMap.h; attach(pin) determines
+//            them at run time. The program checks:
+//            - that attach<pin>() routes the timer to the port of the pin, enables the Compare Unit
+//              and sets the pin as output, for TCA0 and TCA1, without changing the bits of the other
+//              timer in TCAROUTEA
+//            - that attach<pin>() and attach(pin) share the port in use: a pin on another port is
+//              refused by both, and canAttach() knows the port
+//            - that the servos of attach<pin>() output their pulses
+//            Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA0.h>
+#include <Servo_TCA1.h>
+#include "host_model.h"
+
+Servo  servo0;
+Servo  servo1;
+Servo  servo2;
+Servo1 servo3;
+Servo1 servo4;
+Servo1 servo5;
+
+
+//******************************************************************************************************
+// Pulses per Compare Unit, via the onUpdate hook
+//******************************************************************************************************
+static uint32_t pulses[2][3];
+
+static void onUpdate(uint8_t timer, TCA_SINGLE_t *r) {
+  if (r->CMP0 == hostTicks(1100)) pulses[timer][0]++;
+  if (r->CMP1 == hostTicks(1500)) pulses[timer][1]++;
+  if (r->CMP2 == hostTicks(1900)) pulses[timer][2]++;
+}
+
+
+//******************************************************************************************************
+static void testTCA0() {
+  CHECK(servo0.attach<PIN_PD0>() == 0);
+  CHECK((hostPORTMUX.TCAROUTEA & PORTMUX_TCA0_gm) == PORTMUX_TCA0_PORTD_gc);
+  CHECK(hostTCA0.SINGLE.CTRLB & TCA_SINGLE_CMP0EN_bm);
+  CHECK(!(hostTCA0.SINGLE.CTRLB & TCA_SINGLE_CMP2EN_bm));
+  CHECK(hostModel.pinDir[PIN_PD0] == OUTPUT);
+  CHECK(servo0.attached());
+  // A pin on another port is refused, by attach<pin>() as well as by attach(pin)
+  CHECK(!Servo::canAttach(PIN_PC1));
+  CHECK(servo1.attach<PIN_PC1>() == INVALID_SERVO);
+  CHECK(servo1.attach(PIN_PC1) == INVALID_SERVO);
+  CHECK((hostPORTMUX.TCAROUTEA & PORTMUX_TCA0_gm) == PORTMUX_TCA0_PORTD_gc);
+  CHECK(!(hostTCA0.SINGLE.CTRLB & TCA_SINGLE_CMP1EN_bm));
+  // Both ways on the port in use
+  CHECK(servo1.attach(PIN_PD1) == 1);
+  CHECK(servo2.attach<PIN_PD2>(1000, 2000) == 2);
+  CHECK(hostTCA0.SINGLE.CTRLB & TCA_SINGLE_CMP2EN_bm);
+  CHECK(hostModel.pinDir[PIN_PD2] == OUTPUT);
+}
+
+static void testTCA1() {
+  uint8_t tca0Route = hostPORTMUX.TCAROUTEA & PORTMUX_TCA0_gm;
+  CHECK(servo3.attach<PIN_PC4>() == 0);
+  CHECK((hostPORTMUX.TCAROUTEA & PORTMUX_TCA1_gm) == PORTMUX_TCA1_PORTC_gc);
+  CHECK((hostPORTMUX.TCAROUTEA & PORTMUX_TCA0_gm) == tca0Route);
+  CHECK(hostTCA1.SINGLE.CTRLB & TCA_SINGLE_CMP0EN_bm);
+  CHECK(hostModel.pinDir[PIN_PC4] == OUTPUT);
+  CHECK(servo4.attach<PIN_PB1>() == INVALID_SERVO);
+  CHECK(servo4.attach<PIN_PC5>() == 1);
+  CHECK(servo5.attach(PIN_PC6) == 2);
+  CHECK((hostTCA1.SINGLE.CTRLB & (TCA_SINGLE_CMP0EN_bm | TCA_SINGLE_CMP1EN_bm | TCA_SINGLE_CMP2EN_bm))
+        == (TCA_SINGLE_CMP0EN_bm | TCA_SINGLE_CMP1EN_bm | TCA_SINGLE_CMP2EN_bm));
+  CHECK((hostPORTMUX.TCAROUTEA & PORTMUX_TCA1_gm) == PORTMUX_TCA1_PORTC_gc);
+}
+
+static void testPulses() {
+  servo0.writeMicroseconds(1100);
+  servo1.writeMicroseconds(1500);
+  servo2.writeMicroseconds(1900);
+  servo3.writeMicroseconds(1100);
+  servo4.writeMicroseconds(1500);
+  servo5.writeMicroseconds(1900);
+  hostAdvance(100000);
+  memset(pulses, 0, sizeof(pulses));
+  hostAdvance(1000000);
+  for (uint8_t timer = 0; timer < 2; timer++) {
+    printf("TCA%u pulses: %u %u %u\n", timer, pulses[timer][0], pulses[timer][1], pulses[timer][2]);
+    for (uint8_t unit = 0; unit < 3; unit++) {
+      CHECK((pulses[timer][unit] >= 49) && (pulses[timer][unit] <= 51));
+    }
+  }
+}
+
+
+int main() {
+  hostReset();
+  hostModel.onUpdate = onUpdate;
+  testTCA0();
+  testTCA1();
+  testPulses();
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
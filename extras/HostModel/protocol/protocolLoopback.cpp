@@ -0,0 +1,276 @@
+//******************************************************************************************************
+//
+// file:      protocolLoopback.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Loopback test of ServoProtocol (Servo_TCA_Protocol.h) on the host model. The program
+//            plays the controller: it encodes request frames, passes them through a transport to
+//            the protocol, and decodes and checks the replies, while the simulated time advances
+//            and the servos move. Both transports are tested:
+//            - StreamTransport, over a loopback Stream that only accepts a few bytes per call (as
+//              a UART with a small transmit buffer), so replies are sent in pieces
+//            - TwiTransport, over the host model of the Wire library
+//            Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA_Protocol.h>
+#include <TCA_MobaProtocol/twiTransport.h>
+#include "host_model.h"
+
+
+//******************************************************************************************************
+// A Stream between controller and target, with a small transmit window
+//******************************************************************************************************
+class LoopbackStream: public Stream {
+  public:
+    uint8_t toTarget[256];
+    uint16_t toTargetHead = 0, toTargetTail = 0;
+    uint8_t fromTarget[256];
+    uint16_t fromTargetLength = 0;
+    int window = 5;                                // bytes accepted per call of write()
+
+    size_t write(uint8_t c) {
+      if (fromTargetLength >= sizeof(fromTarget)) return 0;
+      fromTarget[fromTargetLength++] = c;
+      return 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) {
+      size_t n = 0;
+      while ((n < size) && write(buffer[n])) n++;
+      return n;
+    }
+    int availableForWrite() {return window;}
+    int available() {return toTargetHead - toTargetTail;}
+    int read() {return (toTargetTail < toTargetHead) ? toTarget[toTargetTail++] : -1;}
+    int peek() {return (toTargetTail < toTargetHead) ? toTarget[toTargetTail] : -1;}
+    void send(const uint8_t *data, uint8_t length) {
+      if (toTargetTail == toTargetHead) toTargetHead = toTargetTail = 0;
+      for (uint8_t i = 0; i < length; i++) toTarget[toTargetHead++] = data[i];
+    }
+};
+
+
+//******************************************************************************************************
+// Controller side: frame encoding and decoding
+//******************************************************************************************************
+static uint8_t crc8(uint8_t crc, uint8_t data) {
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  return crc;
+}
+
+static uint8_t encode(uint8_t *frame, uint8_t command, const uint8_t *payload, uint8_t length) {
+  uint8_t crc = crc8(crc8(0, length), command);
+  frame[0] = PROTOCOL_SYNC;
+  frame[1] = length;
+  frame[2] = command;
+  for (uint8_t i = 0; i < length; i++) {
+    frame[3 + i] = payload[i];
+    crc = crc8(crc, payload[i]);
+  }
+  frame[3 + length] = crc;
+  return length + PROTOCOL_FRAME_OVERHEAD;
+}
+
+typedef struct {
+  uint8_t command;
+  uint8_t length;
+  uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+} reply_t;
+
+// Searches the bytes for a complete reply frame. Returns true if one was found with a correct CRC.
+static bool decode(const uint8_t *data, uint16_t size, reply_t &reply) {
+  for (uint16_t start = 0; start + PROTOCOL_FRAME_OVERHEAD <= size; start++) {
+    if (data[start] != PROTOCOL_SYNC) continue;
+    uint8_t length = data[start + 1];
+    if ((length > PROTOCOL_MAX_PAYLOAD) || (start + length + PROTOCOL_FRAME_OVERHEAD > size)) continue;
+    uint8_t crc = crc8(crc8(0, length), data[start + 2]);
+    for (uint8_t i = 0; i < length; i++) crc = crc8(crc, data[start + 3 + i]);
+    if (crc != data[start + 3 + length]) continue;
+    reply.command = data[start + 2];
+    reply.length = length;
+    memcpy(reply.payload, &data[start + 3], length);
+    return true;
+  }
+  return false;
+}
+
+static uint16_t get16(const reply_t &reply, uint8_t index) {
+  return reply.payload[index] | (reply.payload[index + 1] << 8);
+}
+
+
+//******************************************************************************************************
+// The target: two servos, the protocol, and a main loop
+//******************************************************************************************************
+ServoMoba servo0;
+ServoMoba1 servo3;
+LoopbackStream stream;
+StreamTransport streamTransport(stream);
+ServoProtocol uartProtocol(streamTransport);
+TwiTransport twi;
+ServoProtocol twiProtocol(twi);
+
+static void runFor(uint32_t ms) {
+  uint64_t until = (uint64_t)micros() + ms * 1000UL;
+  while (micros() < until) {
+    servo0.checkServo();
+    servo3.checkServo();
+    uartProtocol.poll();
+    twiProtocol.poll();
+    hostAdvance(100);
+  }
+}
+
+// Sends a request over the UART loopback, and waits (in simulated time) for the reply
+static bool requestUart(uint8_t command, const uint8_t *payload, uint8_t length, reply_t &reply) {
+  uint8_t frame[PROTOCOL_MAX_PAYLOAD + PROTOCOL_FRAME_OVERHEAD];
+  stream.fromTargetLength = 0;
+  stream.send(frame, encode(frame, command, payload, length));
+  for (uint16_t i = 0; i < 200; i++) {
+    runFor(1);
+    if (decode(stream.fromTarget, stream.fromTargetLength, reply)) return reply.command == (command | PROTOCOL_REPLY);
+  }
+  return false;
+}
+
+// The same over TWI. The controller writes the frame in one transfer, and reads in 32 byte blocks.
+static bool requestTwi(uint8_t command, const uint8_t *payload, uint8_t length, reply_t &reply) {
+  uint8_t frame[PROTOCOL_MAX_PAYLOAD + PROTOCOL_FRAME_OVERHEAD];
+  uint8_t received[256];
+  uint16_t size = 0;
+  uint8_t frameLength = encode(frame, command, payload, length);
+  for (uint8_t sent = 0; sent < frameLength; sent += BUFFER_LENGTH) {
+    uint8_t chunk = frameLength - sent;
+    Wire.hostMasterWrite(&frame[sent], (chunk > BUFFER_LENGTH) ? BUFFER_LENGTH : chunk);
+  }
+  for (uint16_t i = 0; i < 200; i++) {
+    runFor(1);
+    size += Wire.hostMasterRead(&received[size], BUFFER_LENGTH);
+    if (decode(received, size, reply)) return reply.command == (command | PROTOCOL_REPLY);
+  }
+  return false;
+}
+
+
+//******************************************************************************************************
+// The tests
+//******************************************************************************************************
+static void testCommands(bool (*request)(uint8_t, const uint8_t *, uint8_t, reply_t &)) {
+  reply_t reply;
+
+  // STATUS: servo 0 and 3 are known, the others are reported with state 255
+  CHECK(request(CMD_STATUS, 0, 0, reply));
+  CHECK(reply.length == 1 + PROTOCOL_SERVOS * 5);
+  CHECK(reply.payload[0] == PROTOCOL_OK);
+  CHECK(reply.payload[1 + 0 * 5] == 0);                              // servo 0 idle
+  CHECK(reply.payload[1 + 0 * 5 + 1] & 1);                           // attached
+  CHECK(reply.payload[1 + 1 * 5] == 255);                            // servo 1 unknown
+  CHECK(reply.payload[1 + 3 * 5] == 0);                              // servo 3 idle
+
+  // WRITE, as a batch for two servos
+  const uint8_t write[] = {0, 0xDC, 0x05, 3, 0x40, 0x06};            // 1500 and 1600 us
+  CHECK(request(CMD_WRITE, write, sizeof(write), reply));
+  CHECK(reply.payload[0] == PROTOCOL_OK);
+  runFor(60);
+  CHECK(servo0.readMicroseconds() == 1500);
+  CHECK(servo3.readMicroseconds() == 1600);
+  const uint8_t badWrite[] = {0, 0xDC, 0x05, 1, 0x40, 0x06};         // servo 1 was not added
+  CHECK(request(CMD_WRITE, badWrite, sizeof(badWrite), reply));
+  CHECK(reply.payload[0] == PROTOCOL_BAD_SERVO);
+
+  // CURVE and MOVE
+  const uint8_t curve[] = {0, 2, 1};
+  CHECK(request(CMD_CURVE, curve, sizeof(curve), reply));
+  CHECK(reply.payload[0] == PROTOCOL_OK);
+  const uint8_t move[] = {0, 1, 0};
+  CHECK(request(CMD_MOVE, move, sizeof(move), reply));
+  CHECK(reply.payload[0] == PROTOCOL_OK);
+  runFor(100);
+  CHECK(!servo0.movementCompleted);
+  while (!servo0.movementCompleted) runFor(20);
+  CHECK(servo0.readMicroseconds() == 1000);                          // direction 1: towards treshold1
+
+  // QUEUE: movements are executed one after the other
+  const uint8_t queue[] = {3, 0, 0, 1, 0};
+  CHECK(request(CMD_QUEUE, queue, sizeof(queue), reply));
+  CHECK(reply.payload[0] == PROTOCOL_OK);
+  const uint8_t badQueue[] = {3, 200, 0, 1, 0};
+  CHECK(request(CMD_QUEUE, badQueue, sizeof(badQueue), reply));
+  CHECK(reply.payload[0] == PROTOCOL_BAD_VALUE);
+  runFor(100);
+  while (!servo3.movementCompleted || servo3.movesQueued()) runFor(20);
+
+  // UPLOAD of a user curve, which is then used by MOVE
+  const uint8_t upload[] = {0, 1, 0, 0, 10, 128, 20, 255, 0, 0};
+  CHECK(request(CMD_UPLOAD, upload, sizeof(upload), reply));
+  CHECK(reply.payload[0] == PROTOCOL_OK);
+  CHECK(servo0.previousCurve == USER_CURVE);
+  CHECK(servo0.getCurveDuration() == 20);
+  const uint8_t noEnd[] = {0, 1, 0, 0, 10, 128, 20, 255};
+  CHECK(request(CMD_UPLOAD, noEnd, sizeof(noEnd), reply));
+  CHECK(reply.payload[0] == PROTOCOL_BAD_VALUE);
+  const uint8_t moveBack[] = {0, 0, 0};
+  CHECK(request(CMD_MOVE, moveBack, sizeof(moveBack), reply));
+  while (!servo0.movementCompleted) runFor(20);
+  CHECK(servo0.readMicroseconds() == 2000);                          // position 255, direction 0
+
+  // STATS and RESET_STATS
+  CHECK(request(CMD_STATS, 0, 0, reply));
+  CHECK(reply.length == 1 + 2 * (6 + 2 * LATENCY_BUCKETS) + 4);
+  CHECK(get16(reply, 1 + 2 * (6 + 2 * LATENCY_BUCKETS)) > 0);       // frames executed
+  CHECK(request(CMD_RESET_STATS, 0, 0, reply));
+  CHECK(reply.payload[0] == PROTOCOL_OK);
+
+  // Errors
+  CHECK(request(0x7F, 0, 0, reply));
+  CHECK(reply.payload[0] == PROTOCOL_BAD_COMMAND);
+  CHECK(request(CMD_MOVE, move, 2, reply));
+  CHECK(reply.payload[0] == PROTOCOL_BAD_LENGTH);
+}
+
+
+static void testCorruption() {
+  reply_t reply;
+  uint8_t frame[PROTOCOL_MAX_PAYLOAD + PROTOCOL_FRAME_OVERHEAD];
+  uint16_t errors = uartProtocol.getErrors();
+  uint8_t length = encode(frame, CMD_STATUS, 0, 0);
+  frame[length - 1] ^= 0x01;                       // wrong CRC: ignored
+  const uint8_t garbage[] = {0x00, 0x13, PROTOCOL_SYNC, 0xFF};   // noise, and an impossible length
+  stream.fromTargetLength = 0;
+  stream.send(garbage, sizeof(garbage));
+  stream.send(frame, length);
+  runFor(20);
+  CHECK(stream.fromTargetLength == 0);
+  CHECK(uartProtocol.getErrors() == errors + 2);
+  CHECK(requestUart(CMD_STATUS, 0, 0, reply));     // and the parser has resynchronised
+  CHECK(reply.payload[0] == PROTOCOL_OK);
+}
+
+
+int main() {
+  hostReset();
+  servo0.attach(PIN_PA0);
+  servo0.setTreshold1(1000);
+  servo0.setTreshold2(2000);
+  servo3.attach(PIN_PB0);
+  servo3.setTreshold1(1200);
+  servo3.setTreshold2(1800);
+  servo3.initCurveFromPROGMEM(8, 1);
+  uartProtocol.add(servo0);
+  uartProtocol.add(servo3);
+  twiProtocol.add(servo0);
+  twiProtocol.add(servo3);
+  twi.begin(0x40);
+  runFor(100);
+
+  printf("== StreamTransport\n");
+  testCommands(requestUart);
+  testCorruption();
+  printf("== TwiTransport\n");
+  testCommands(requestTwi);
+  printf("%u + %u frames, %d failures\n", uartProtocol.getFrames(), twiProtocol.getFrames(), hostFailures);
+  return hostFailures ? 1 : 0;
+}
@@ -0,0 +1,61 @@
+//******************************************************************************************************
+//
+// file:      sketch_main.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Runs an (unmodified) Arduino sketch on the host model. This file provides main(), which
+//            calls setup() once and loop() repeatedly, while the simulated time advances.
+//
+// Usage: <program> [-t milliseconds] [-l] [-p] [-w file.vcd]
+//   -t: the simulated run time. Default is 100 ms
+//   -l: log all writes to the Compare / Period Buffer registers (with timestamp)
+//   -p: log all changes of output pins (with timestamp)
+//   -w: write the waveform outputs of TCA0 and TCA1 to a VCD file (for GTKWave, PulseView, ...)
+//
+// Between two calls of loop() the simulated time advances LOOP_US microseconds. Sketches that
+// call delay() advance the time themselves.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include "host_model.h"
+
+#define LOOP_US 10
+
+void setup();
+void loop();
+
+static void printPinWrite(uint8_t pin, uint8_t value) {
+  printf("%10.3f us  P%c%u = %u\n", (double)hostModel.cycles / clockCyclesPerMicrosecond(),
+    'A' + (pin >> 3), pin & 7, value);
+}
+
+
+int main(int argc, char *argv[]) {
+  unsigned long runTime = 100;
+  const char *vcd = 0;
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) runTime = strtoul(argv[++i], 0, 10);
+    else if (strcmp(argv[i], "-l") == 0) hostModel.logBufferWrites = true;
+    else if (strcmp(argv[i], "-p") == 0) hostModel.onPinWrite = printPinWrite;
+    else if ((strcmp(argv[i], "-w") == 0) && (i + 1 < argc)) vcd = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [-t milliseconds] [-l] [-p] [-w file.vcd]\n", argv[0]);
+      return 1;
+    }
+  }
+  hostReset();
+  if (vcd && !hostVcdOpen(vcd)) {
+    fprintf(stderr, "cannot write %s\n", vcd);
+    return 1;
+  }
+  setup();
+  while (millis() < runTime) {
+    loop();
+    hostAdvance(LOOP_US);
+  }
+  printf("TCA0: %u overflows, %u ISR calls\n", hostTimers[0].overflows, hostTimers[0].isrCount);
+  printf("TCA1: %u overflows, %u ISR calls\n", hostTimers[1].overflows, hostTimers[1].isrCount);
+  hostVcdClose();
+  return 0;
+}
@@ -0,0 +1,386 @@
+//******************************************************************************************************
+//
+// file:      servoSim.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Deterministic timeline simulator for the ServoMoba and ServoMoba1 classes, built on the
+//            host model. It runs a scripted scenario and prints, per 20 ms frame and per servo, the
+//            output signal as it leaves the Compare Unit, plus the state of the power pin (CSV).
+//            It also compares every predefined curve against stored golden traces, to check that
+//            changes to the curve engine do not change the movement by even a single timer tick.
+//
+// Usage:
+//   servoSim <scenario file>            runs the scenario, CSV on stdout
+//   servoSim --golden-check <dir>       compares all predefined curves against <dir>/NN-name.csv
+//   servoSim --golden-update <dir>      (re)writes the golden traces in <dir>
+//   servoSim --curves                   prints the points of all predefined curves (CSV), as input
+//                                       for the plot scripts in extras/Python
+//
+// Scenario files contain one command per line; # starts a comment. Servos are numbered 0..5:
+// 0..2 are ServoMoba objects (TCA0), 3..5 are ServoMoba1 objects (TCA1). Pins are written as PA0.
+//   attach <servo> <pin>
+//   pulse <servo> <low|high> <pulsesBefore> <pulsesAfter> <initialPulseWidth>
+//   power <servo> <idlePowerIsOff> <pin> <enableValue> <stepsBefore> <stepsAfter>
+//   treshold <servo> <treshold1> <treshold2>
+//   curve <servo> <index> <timeStretch>                   initCurveFromPROGMEM()
+//   eecurve <servo> <index> <timeStretch> <address>       initCurveFromEEPROM()
+//   eeprom <address> <byte> <byte> ...                     preloads the EEPROM
+//   move <servo> <direction> [<delay>]
+//   queue <servo> <curve> <direction> <timeStretch> <dwell>
+//   loop <us>                 the main loop calls checkServo() every <us> microseconds (default 100)
+//   jitter <us>               adds a pseudo random 0..<us> to every main loop period (default 0)
+//   isr <cycles>              ISR latency, in CPU clock cycles (default 0)
+//   run <ms>                  advances the simulated time
+//   stats <servo>             prints the service statistics of the servo and its timer on stderr
+//
+// CSV columns: frame, time (ms, start of the frame), servo, output (pulse / high / low), pulse
+// width (us), pulse width (timer ticks) and power pin (1 / 0, or - if the servo has no power pin).
+//
+// A frame consists of three timer periods (three UPDATE conditions, 20/3 ms each). For every
+// Compare Unit, the output during a period follows from CMPn as it was loaded at the UPDATE:
+// 0 gives a low output, a value above PER (OUT_HIGH) a high output, anything else a pulse.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Servo_TCA0_MoBa.h>
+#include <Servo_TCA1_MoBa.h>
+#include "host_model.h"
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define NUMBER_OF_SERVOS 6
+#define NO_PIN 255
+#define MAX_ARGUMENTS 32                           // per scenario line
+
+ServoMoba  servosTCA0[SERVOS_PER_TIMER];
+ServoMoba1 servosTCA1[SERVOS_PER_TIMER];
+
+
+//******************************************************************************************************
+// Servo access. ServoMoba and ServoMoba1 are different classes, with the same interface
+//******************************************************************************************************
+template <typename F> void withServo(uint8_t servo, F f) {
+  if (servo < SERVOS_PER_TIMER) f(servosTCA0[servo]);
+  else f(servosTCA1[servo - SERVOS_PER_TIMER]);
+}
+
+typedef struct {
+  uint8_t pin;                                     // pulse pin, or NO_PIN if not attached
+  uint8_t powerPin;                                // power pin, or NO_PIN
+  uint8_t cmp[3];                                  // output per period: 0 = low, 1 = high, 2 = pulse
+  uint16_t ticks;                                  // pulse width within the frame
+} servoTrace_t;
+
+static servoTrace_t traces[NUMBER_OF_SERVOS];
+
+
+//******************************************************************************************************
+// Recording. onUpdate() is called by the model at every UPDATE condition
+//******************************************************************************************************
+typedef void (*frameHandler_t)(uint8_t servo, uint32_t frame, double ms, const servoTrace_t *trace);
+
+static frameHandler_t frameHandler;
+static uint32_t periods[2];                        // number of UPDATE conditions per timer
+static uint32_t frameStart[2];                     // time (us) of the first period in the frame
+static uint32_t loopPeriod = 100;
+static uint32_t loopJitter = 0;
+static uint32_t isrLatency = 0;
+static uint32_t randomState = 1;
+
+static void onUpdate(uint8_t timer, TCA_SINGLE_t *registers) {
+  uint8_t period = periods[timer] % 3;
+  if (period == 0) frameStart[timer] = micros();
+  for (uint8_t unit = 0; unit < SERVOS_PER_TIMER; unit++) {
+    servoTrace_t *trace = &traces[timer * SERVOS_PER_TIMER + unit];
+    if (trace->pin == NO_PIN) continue;
+    uint8_t cmpUnit = (trace->pin & 0x07) % 4;     // Px0..Px2 or Px4..Px6
+    uint16_t cmp = (cmpUnit == 0) ? registers->CMP0 : (cmpUnit == 1) ? registers->CMP1 : registers->CMP2;
+    bool enabled = registers->CTRLB & (TCA_SINGLE_CMP0EN_bm << cmpUnit);
+    if (period == 0) trace->ticks = 0;
+    if (!enabled) trace->cmp[period] = hostModel.pinOut[trace->pin];
+    else if (cmp == 0) trace->cmp[period] = 0;
+    else if (cmp > registers->PER) trace->cmp[period] = 1;
+    else {trace->cmp[period] = 2; trace->ticks = cmp;}
+  }
+  if ((period == 2) && frameHandler) {
+    uint32_t frame = periods[timer] / 3;
+    for (uint8_t unit = 0; unit < SERVOS_PER_TIMER; unit++) {
+      uint8_t servo = timer * SERVOS_PER_TIMER + unit;
+      if (traces[servo].pin == NO_PIN) continue;
+      frameHandler(servo, frame, frameStart[timer] / 1000.0, &traces[servo]);
+    }
+  }
+  periods[timer]++;
+}
+
+static const char *outputName(const servoTrace_t *trace) {
+  if ((trace->cmp[0] == 2) || (trace->cmp[1] == 2) || (trace->cmp[2] == 2)) return "pulse";
+  if ((trace->cmp[0] == 1) || (trace->cmp[1] == 1) || (trace->cmp[2] == 1)) return "high";
+  return "low";
+}
+
+static double ticksToUs(uint16_t ticks, uint8_t servo) {
+  TCA_t *tca = (servo < SERVOS_PER_TIMER) ? &TCA0 : &TCA1;
+  return ticks * 1000000.0 / hostTimerClock(&tca->SINGLE);
+}
+
+static void printFrame(uint8_t servo, uint32_t frame, double ms, const servoTrace_t *trace) {
+  printf("%u,%.3f,%u,%s,%.3f,%u,", frame, ms, servo, outputName(trace), ticksToUs(trace->ticks, servo),
+    trace->ticks);
+  if (trace->powerPin == NO_PIN) printf("-\n");
+  else printf("%u\n", hostModel.pinOut[trace->powerPin]);
+}
+
+static uint32_t hostIsrLatency(uint8_t timer) {
+  return isrLatency;
+}
+
+
+//******************************************************************************************************
+// The main loop: call checkServo() for all attached servos, then wait for the next loop period
+//******************************************************************************************************
+static void runFor(uint32_t ms) {
+  uint64_t until = (uint64_t)micros() + ms * 1000UL;
+  while (micros() < until) {
+    for (uint8_t servo = 0; servo < NUMBER_OF_SERVOS; servo++) {
+      if (traces[servo].pin == NO_PIN) continue;
+      withServo(servo, [](auto &s) {s.checkServo();});
+    }
+    uint32_t wait = loopPeriod;
+    if (loopJitter) {
+      randomState = randomState * 1103515245UL + 12345UL;   // deterministic pseudo random
+      wait += (randomState >> 16) % (loopJitter + 1);
+    }
+    hostAdvance(wait);
+  }
+}
+
+static bool movementCompleted(uint8_t servo) {
+  bool completed = true;
+  withServo(servo, [&](auto &s) {completed = s.movementCompleted && (s.movesQueued() == 0);});
+  return completed;
+}
+
+static void startSimulation() {
+  hostReset();
+  memset(periods, 0, sizeof(periods));
+  for (uint8_t servo = 0; servo < NUMBER_OF_SERVOS; servo++) {
+    traces[servo].pin = NO_PIN;
+    traces[servo].powerPin = NO_PIN;
+  }
+  hostModel.onUpdate = onUpdate;
+  hostModel.isrLatency = hostIsrLatency;
+}
+
+
+//******************************************************************************************************
+// Scenarios
+//******************************************************************************************************
+static uint8_t parsePin(const char *name) {
+  if ((strlen(name) == 3) && (name[0] == 'P') && (name[1] >= 'A') && (name[1] <= 'G')) {
+    return (name[1] - 'A') * 8 + (name[2] - '0');
+  }
+  return atoi(name);
+}
+
+// The statistics of the servo, followed by those of its timer (totals and latency histogram)
+static void printStats(uint8_t servo) {
+  servoStats_t stats;
+  servoStats_t timerStats;
+  uint16_t histogram[LATENCY_BUCKETS];
+  withServo(servo, [&](auto &s) {
+    s.getStats(stats);
+    s.getTimerStats(timerStats);
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) histogram[i] = s.getLatencyCount(i);
+  });
+  fprintf(stderr, "servo %u: missed frames %u, overwritten values %u, max latency %u us\n", servo,
+    stats.missedFrames, stats.overwrittenValues, stats.maxLatency);
+  fprintf(stderr, "TCA%u: missed frames %u, overwritten values %u, max latency %u us, latency <1/<2/<5/<10/<20/>=20 ms:",
+    servo / SERVOS_PER_TIMER, timerStats.missedFrames, timerStats.overwrittenValues, timerStats.maxLatency);
+  for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) fprintf(stderr, " %u", histogram[i]);
+  fprintf(stderr, "\n");
+}
+
+static bool runScenario(FILE *file, const char *fileName) {
+  char line[256];
+  uint16_t lineNumber = 0;
+  startSimulation();
+  frameHandler = printFrame;
+  printf("frame,time_ms,servo,output,pulse_us,pulse_ticks,power\n");
+  while (fgets(line, sizeof(line), file)) {
+    lineNumber++;
+    char *comment = strchr(line, '#');
+    if (comment) *comment = 0;
+    char *arg[MAX_ARGUMENTS];
+    char *command = strtok(line, " \t\r\n");
+    if (!command) continue;
+    int n = 0;
+    while ((n < MAX_ARGUMENTS) && (arg[n] = strtok(0, " \t\r\n"))) n++;
+    long a[MAX_ARGUMENTS];
+    for (int i = 0; i < n; i++) a[i] = strtol(arg[i], 0, 0);
+    bool perServo = strcmp(command, "run") && strcmp(command, "loop") && strcmp(command, "jitter")
+      && strcmp(command, "isr") && strcmp(command, "eeprom");
+    if (perServo && ((n < 1) || (a[0] < 0) || (a[0] >= NUMBER_OF_SERVOS))) {
+      fprintf(stderr, "%s:%u: invalid servo for %s\n", fileName, lineNumber, command);
+      return false;
+    }
+    uint8_t servo = perServo ? a[0] : 0;
+    bool ok = true;
+    if (!strcmp(command, "attach") && (n == 2)) {
+      uint8_t pin = parsePin(arg[1]);
+      uint8_t index = INVALID_SERVO;
+      withServo(servo, [&](auto &s) {index = s.attach(pin);});
+      if (index != INVALID_SERVO) traces[servo].pin = pin;
+      else ok = false;
+    }
+    else if (!strcmp(command, "pulse") && (n == 5)) {
+      uint8_t idle = !strcmp(arg[1], "high");
+      withServo(servo, [&](auto &s) {s.initPulse(idle, a[2], a[3], a[4]);});
+    }
+    else if (!strcmp(command, "power") && (n == 6)) {
+      traces[servo].powerPin = parsePin(arg[2]);
+      withServo(servo, [&](auto &s) {s.initPower(a[1], traces[servo].powerPin, a[3], a[4], a[5]);});
+    }
+    else if (!strcmp(command, "treshold") && (n == 3)) {
+      withServo(servo, [&](auto &s) {s.setTreshold1(a[1]); s.setTreshold2(a[2]);});
+    }
+    else if (!strcmp(command, "curve") && (n == 3)) {
+      withServo(servo, [&](auto &s) {s.initCurveFromPROGMEM(a[1], a[2]);});
+    }
+    else if (!strcmp(command, "eecurve") && (n == 4)) {
+      withServo(servo, [&](auto &s) {s.initCurveFromEEPROM(a[1], a[2], a[3]);});
+    }
+    else if (!strcmp(command, "eeprom") && (n >= 2)) {
+      for (int i = 1; i < n; i++) EEPROM.update(a[0] + i - 1, a[i]);
+    }
+    else if (!strcmp(command, "move") && (n >= 2)) {
+      uint8_t delay = (n > 2) ? a[2] : 0;
+      withServo(servo, [&](auto &s) {s.moveServoAlongCurve(a[1], delay);});
+    }
+    else if (!strcmp(command, "queue") && (n == 5)) {
+      withServo(servo, [&](auto &s) {s.queueMove(a[1], a[2], a[3], a[4]);});
+    }
+    else if (!strcmp(command, "loop") && (n == 1)) loopPeriod = a[0];
+    else if (!strcmp(command, "jitter") && (n == 1)) loopJitter = a[0];
+    else if (!strcmp(command, "isr") && (n == 1)) isrLatency = a[0];
+    else if (!strcmp(command, "run") && (n == 1)) runFor(a[0]);
+    else if (!strcmp(command, "stats") && (n == 1)) printStats(servo);
+    else ok = false;
+    if (!ok) {
+      fprintf(stderr, "%s:%u: invalid command or arguments: %s\n", fileName, lineNumber, command);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+//******************************************************************************************************
+// Golden traces. Per predefined curve: stretch 1 and 3, both directions, one after the other.
+// Every curve runs in its own (forked) process, since the library keeps its state in static
+// variables, and can therefore not be reset from within a single process.
+//******************************************************************************************************
+static const char *curveNames[NUMBER_OF_PREDEFINED_CURVES] = {
+  "lin_A", "lin_B", "move_A", "move_B", "sine_A", "sine_B",
+  "whip_A", "whip_B", "sig_hp0", "sig_hp1", "hp1p", "sine_AB"
+};
+
+static const uint8_t goldenStretch[] = {1, 3};
+
+static FILE *goldenFile;
+static uint8_t goldenStep;                         // index into goldenStretch * 2 + direction
+
+static void goldenFrame(uint8_t servo, uint32_t frame, double ms, const servoTrace_t *trace) {
+  fprintf(goldenFile, "%u,%u,%u,%s,%u\n", goldenStretch[goldenStep >> 1], goldenStep & 1, frame,
+    outputName(trace), trace->ticks);
+}
+
+static void goldenFileName(char *name, size_t size, const char *dir, uint8_t curve) {
+  const char *curveName = (curve < sizeof(curveNames) / sizeof(curveNames[0])) ? curveNames[curve] : "curve";
+  snprintf(name, size, "%s/%02u-%s.csv", dir, curve, curveName);
+}
+
+static void goldenTrace(uint8_t curve, FILE *file) {
+  startSimulation();
+  goldenFile = file;
+  fprintf(file, "stretch,direction,frame,output,pulse_ticks\n");
+  servosTCA0[0].setTreshold1(1000);
+  servosTCA0[0].setTreshold2(2000);
+  servosTCA0[0].attach(PIN_PA0);
+  traces[0].pin = PIN_PA0;
+  runFor(100);
+  for (goldenStep = 0; goldenStep < 2 * sizeof(goldenStretch); goldenStep++) {
+    servosTCA0[0].initCurveFromPROGMEM(curve, goldenStretch[goldenStep >> 1]);
+    servosTCA0[0].moveServoAlongCurve(goldenStep & 1);
+    frameHandler = goldenFrame;
+    while (!movementCompleted(0)) runFor(1);
+    runFor(60);                                    // three frames after the movement
+    frameHandler = 0;
+  }
+}
+
+static int golden(const char *dir, bool update) {
+  int failures = 0;
+  for (uint8_t curve = 0; curve < NUMBER_OF_PREDEFINED_CURVES; curve++) {
+    char name[256];
+    char actual[] = "/tmp/servoSimXXXXXX";
+    goldenFileName(name, sizeof(name), dir, curve);
+    int fd = mkstemp(actual);
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+      FILE *file = fdopen(fd, "w");
+      goldenTrace(curve, file);
+      fclose(file);
+      _exit(0);
+    }
+    waitpid(pid, 0, 0);
+    close(fd);
+    char command[600];
+    if (update) snprintf(command, sizeof(command), "cp %s %s", actual, name);
+    else snprintf(command, sizeof(command), "diff -u %s %s > /dev/null", name, actual);
+    bool ok = (system(command) == 0);
+    if (!ok && !update) {
+      printf("FAILED: %s\n", name);
+      snprintf(command, sizeof(command), "diff -u %s %s | head -20", name, actual);
+      fflush(stdout);
+      if (system(command)) {}
+    }
+    else printf("%s: %s\n", update ? "written" : "ok", name);
+    if (!ok) failures++;
+    unlink(actual);
+  }
+  return failures ? 1 : 0;
+}
+
+
+// The curve points, as the library has them; the plot scripts use these instead of a copy
+static int printCurves() {
+  printf("curve,name,time,position\n");
+  for (uint8_t curve = 0; curve < NUMBER_OF_PREDEFINED_CURVES; curve++) {
+    const curvePoint_t *points = curveByIndex(curve);
+    for (uint8_t i = 0; (i == 0) || ((i < SIZE_SERVO_CURVE) && (points[i].time != 0)); i++) {
+      printf("%u,%s,%u,%u\n", curve, curveNames[curve], points[i].time, points[i].position);
+    }
+  }
+  return 0;
+}
+
+
+//******************************************************************************************************
+int main(int argc, char *argv[]) {
+  if ((argc == 3) && !strcmp(argv[1], "--golden-check")) return golden(argv[2], false);
+  if ((argc == 3) && !strcmp(argv[1], "--golden-update")) return golden(argv[2], true);
+  if ((argc == 2) && !strcmp(argv[1], "--curves")) return printCurves();
+  if ((argc == 2) && (argv[1][0] != '-')) {
+    FILE *file = fopen(argv[1], "r");
+    if (!file) {perror(argv[1]); return 1;}
+    bool ok = runScenario(file, argv[1]);
+    fclose(file);
+    return ok ? 0 : 1;
+  }
+  fprintf(stderr, "usage: %s <scenario file> | --golden-check <dir> | --golden-update <dir> | --curves\n", argv[0]);
+  return 1;
+}
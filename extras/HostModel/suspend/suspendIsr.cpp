@@ -0,0 +1,197 @@
+//******************************************************************************************************
+//
+// file:      suspendIsr.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Test of the suspension of the ISR on the host model. Servos of TCA0 switch between
+//            pulses and constant levels; a ServoMoba1 on TCA1 moves along a curve with switched
+//            power and low idle pulses. The program checks:
+//            - that the ISR is suspended once all attached servos output a constant level, and
+//              that no interrupts occur while it is suspended
+//            - that the Compare Units keep their constant levels meanwhile, and that the first pulse
+//              after a write is complete (no glitches on any output)
+//            - that needFrames(true) keeps the ISR running
+//            - that a write while the ISR is suspended doesn't count a latency
+//            - that ServoMoba keeps the ISR running until the power steps after a movement are
+//              done, and that queueMove() resumes it
+//            Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <Servo_TCA0.h>
+#include <Servo_TCA1_MoBa.h>
+#include "host_model.h"
+
+#define OUT_HIGH      65535
+#define ANY_LEVEL         1                        // expected[]: not checked
+#define POWER_PIN     PIN_PD4
+
+Servo servo0;
+Servo servo1;
+ServoMoba1 moba;
+
+
+//******************************************************************************************************
+// At every UPDATE: a Compare Unit holds 0 (low), OUT_HIGH (high) or a complete pulse, and the
+// expected level of each unit is known from the test
+//******************************************************************************************************
+static uint16_t expected[3] = {0, 0, 0};           // Per Compare Unit of TCA0: 0, OUT_HIGH, or a pulse
+static uint32_t badLevel = 0;
+static uint32_t pulsesSeen[3];
+
+static void onUpdate(uint8_t timer, TCA_SINGLE_t *r) {
+  if (timer != 0) return;
+  uint16_t cmp[3] = {r->CMP0, r->CMP1, r->CMP2};
+  for (uint8_t i = 0; i < 3; i++) {
+    if (expected[i] == ANY_LEVEL) continue;
+    if ((expected[i] == 0) || (expected[i] == OUT_HIGH)) {
+      if (cmp[i] != expected[i]) badLevel++;
+    }
+    else {                                         // A pulse: in its own slot, otherwise low
+      if ((cmp[i] != 0) && (cmp[i] != expected[i])) badLevel++;
+      if (cmp[i] == expected[i]) pulsesSeen[i]++;
+    }
+  }
+}
+
+static uint32_t isrCount(uint8_t timer) {
+  return hostTimers[timer].isrCount;
+}
+
+static uint32_t isrsIn(uint8_t timer, uint32_t ms) {
+  uint32_t first = isrCount(timer);
+  hostAdvance(ms * 1000UL);
+  return isrCount(timer) - first;
+}
+
+static uint32_t latencyCounts() {
+  uint32_t sum = 0;
+  for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) sum += Servo::getLatencyCount(i);
+  return sum;
+}
+
+// The Compare Units may still hold the previous levels for one frame after a change
+static void settle(uint16_t level0, uint16_t level1) {
+  expected[0] = expected[1] = ANY_LEVEL;
+  hostAdvance(30000);
+  expected[0] = level0;
+  expected[1] = level1;
+}
+
+
+//******************************************************************************************************
+static void testConstant() {
+  servo0.writeMicroseconds(1500);
+  servo1.writeMicroseconds(2000);
+  settle(hostTicks(1500), hostTicks(2000));
+  CHECK(!Servo::isSuspended());
+  CHECK(isrsIn(0, 100) >= 14);                     // 150 per second
+  servo0.constantOutput(0);
+  settle(0, hostTicks(2000));
+  CHECK(!Servo::isSuspended());                    // servo1 still has pulses
+  servo1.constantOutput(1);
+  settle(0, OUT_HIGH);
+  CHECK(Servo::isSuspended());
+  uint16_t frame = Servo::getFrame();
+  uint32_t isrs = isrsIn(0, 1000);
+  printf("constant: %u interrupts in 1000 ms, frames %u\n", isrs, (uint16_t)(Servo::getFrame() - frame));
+  CHECK(isrs == 0);
+  CHECK(Servo::getFrame() == frame);
+  CHECK(hostTimers[0].overflows > 0);              // The timer itself keeps running
+}
+
+static void testResume() {
+  // A new constant level resumes the ISR, and suspends it again once loaded
+  servo1.constantOutput(0);
+  CHECK(!Servo::isSuspended());
+  settle(0, 0);
+  CHECK(Servo::isSuspended());
+  // A write: the first pulse is complete, and servo1 remains low
+  memset(pulsesSeen, 0, sizeof(pulsesSeen));
+  expected[0] = hostTicks(1200);
+  uint32_t counts = latencyCounts();
+  servo0.writeMicroseconds(1200);
+  CHECK(!Servo::isSuspended());
+  CHECK(latencyCounts() == counts);                // The time since the last UPDATE is unknown
+  uint32_t start = micros();
+  while (pulsesSeen[0] == 0 && (micros() - start < 100000)) hostAdvance(100);
+  printf("resume: first pulse %lu us after the write\n", micros() - start);
+  CHECK(micros() - start <= 30000);                // At most one slot plus one frame
+  hostAdvance(1000000);
+  CHECK((pulsesSeen[0] >= 49) && (pulsesSeen[0] <= 51));
+  CHECK(!Servo::isSuspended());
+  servo0.constantOutput(1);
+  settle(OUT_HIGH, 0);
+  CHECK(Servo::isSuspended());
+  hostAdvance(100000);
+}
+
+static void testNeedFrames() {
+  servo0.needFrames(true);
+  CHECK(!Servo::isSuspended());
+  uint16_t frame = Servo::getFrame();
+  hostAdvance(1000000);
+  CHECK((uint16_t)(Servo::getFrame() - frame) >= 49);
+  CHECK(servo0.acceptsNewValue());
+  servo0.needFrames(false);
+  hostAdvance(100000);
+  CHECK(Servo::isSuspended());
+}
+
+// ServoMoba1 on TCA1: low pulses and no power while idle
+static void runFor(uint32_t ms) {
+  uint64_t until = (uint64_t)micros() + ms * 1000UL;
+  while (micros() < until) {
+    moba.checkServo();
+    hostAdvance(100);
+  }
+}
+
+static void testMoba() {
+  runFor(200);
+  CHECK(Servo1::isSuspended());
+  moba.moveServoAlongCurve(0);
+  CHECK(!Servo1::isSuspended());
+  runFor(100);
+  CHECK(hostModel.pinOut[POWER_PIN] == HIGH);
+  while (!moba.movementCompleted) runFor(20);
+  CHECK(!Servo1::isSuspended());                   // The pulse and power steps after the movement
+  runFor(300);
+  CHECK(hostModel.pinOut[POWER_PIN] == LOW);
+  CHECK(hostTCA1.SINGLE.CMP0 == 0);
+  CHECK(Servo1::isSuspended());
+  uint32_t isrs = isrsIn(1, 1000);
+  printf("moba idle: %u interrupts in 1000 ms\n", isrs);
+  CHECK(isrs == 0);
+  // A queued movement, for instance from ServoProtocol, resumes the ISR
+  CHECK(moba.queueMove(KEEP_CURVE, 1, 1, 0));
+  CHECK(!Servo1::isSuspended());
+  runFor(100);
+  CHECK(!moba.movementCompleted);
+  while (!moba.movementCompleted) runFor(20);
+  runFor(300);
+  CHECK(hostModel.pinOut[POWER_PIN] == LOW);
+  CHECK(Servo1::isSuspended());
+}
+
+
+int main() {
+  hostReset();
+  hostModel.onUpdate = onUpdate;
+  servo0.attach(PIN_PA0);
+  servo1.attach(PIN_PA1);
+  moba.initCurveFromPROGMEM(2, 1);
+  moba.initPulse(0, 2, 3, 1500);
+  moba.initPower(true, POWER_PIN, HIGH, 3, 2);
+  moba.attach(PIN_PB0);
+
+  testConstant();
+  testResume();
+  testNeedFrames();
+  testMoba();
+  printf("%u level errors\n", badLevel);
+  CHECK(badLevel == 0);
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+//******************************************************************************************************
+//
+// file:      frameSync.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Test of syncFrames() (external frame synchronisation) on the host model. A simulated
+//            event source plays the sync signal on event channel 0; TCA0 and TCA1 are both locked
+//            to it. The program checks:
+//            - that syncFrames() returns at once, that isSynced() tells when the timer has locked,
+//              and that slot 0 then starts SYNC_MARGIN before each event
+//            - that the event restarts the counter after the pulse of slot 0, never during a pulse
+//            - that each Compare Unit outputs one pulse per frame, in the order 0, 1, 2
+//            - that the lock follows a sync period that drifts, and returns after lost events
+//            - that syncFrames(SYNC_OFF) and a missing sync signal give ordinary 20 ms frames
+//            The argument is the time (us) of the first event, to start at different offsets.
+//            Returns 0 if all checks passed.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <math.h>
+#include <Servo_TCA0.h>
+#include <Servo_TCA1.h>
+#include "host_model.h"
+
+#define SYNC_CHANNEL      0
+#define NO_UNIT         255
+
+Servo  servo0;
+Servo  servo1;
+Servo  servo2;
+Servo1 servo3;
+Servo1 servo4;
+Servo1 servo5;
+
+
+//******************************************************************************************************
+// Observation of both timers, via the onUpdate and onRestart hooks
+//******************************************************************************************************
+static bool measuring = false;
+static uint32_t period = 20000;                    // us, of the event source
+static uint32_t nextPeriod = 0;                    // if not 0: new period, from the next event on
+static uint64_t slot0Start[2];                     // cycle of the latest UPDATE that started slot 0
+static uint8_t lastUnit[2] = {NO_UNIT, NO_UNIT};
+static uint32_t pulses[2][3];                      // per timer and Compare Unit
+static uint32_t badOrder = 0;
+static uint32_t restarts[2];
+static uint32_t badOffset = 0;
+static uint32_t duringPulse = 0;
+static double maxDeviation = 0;                    // us, of the event from its expected position
+
+static TCA_SINGLE_t *registers(uint8_t timer) {
+  return (timer == 0) ? &hostTCA0.SINGLE : &hostTCA1.SINGLE;
+}
+
+static double slotUs(uint8_t timer) {              // Length of a slot that is not restarted
+  return (registers(timer)->PER + 1) * 1000000.0 / hostTimerClock(registers(timer));
+}
+
+static void onUpdate(uint8_t timer, TCA_SINGLE_t *r) {
+  if (!measuring) return;
+  uint16_t cmp[3] = {r->CMP0, r->CMP1, r->CMP2};
+  uint8_t unit = NO_UNIT;
+  for (uint8_t i = 0; i < 3; i++) {
+    if (cmp[i] == 0) continue;
+    if (unit != NO_UNIT) badOrder++;               // Two pulses in one slot
+    unit = i;
+  }
+  if (unit == NO_UNIT) {badOrder++; return;}
+  if ((lastUnit[timer] != NO_UNIT) && (unit != (lastUnit[timer] + 1) % 3)) badOrder++;
+  lastUnit[timer] = unit;
+  pulses[timer][unit]++;
+  if (unit == 0) slot0Start[timer] = hostModel.cycles;
+}
+
+static void onRestart(uint8_t timer, uint16_t count) {
+  if (nextPeriod && (timer == 0)) {
+    period = nextPeriod;
+    nextPeriod = 0;
+    hostEventSource(SYNC_CHANNEL, period, period);
+  }
+  if (!measuring) return;
+  TCA_SINGLE_t *r = registers(timer);
+  restarts[timer]++;
+  if ((r->CMP1 != 0) || (r->CMP2 != 0)) badOffset++;         // Not in slot 0
+  if (count <= r->CMP0) duringPulse++;
+  // Three slots after the previous event, slot 0 starts; this event arrives period - 3 slots later
+  double offset = (double)(hostModel.cycles - slot0Start[timer]) / clockCyclesPerMicrosecond();
+  double deviation = fabs(offset - (period - 3 * slotUs(timer)));
+  if (deviation > maxDeviation) maxDeviation = deviation;
+  if (deviation > 1) badOffset++;
+}
+
+static void startMeasuring() {
+  memset(pulses, 0, sizeof(pulses));
+  memset(restarts, 0, sizeof(restarts));
+  lastUnit[0] = lastUnit[1] = NO_UNIT;
+  slot0Start[0] = slot0Start[1] = hostModel.cycles;
+  badOrder = badOffset = duringPulse = 0;
+  maxDeviation = 0;
+  measuring = true;
+}
+
+// Runs for ms, and checks that both timers were locked during all that time
+static void checkLocked(const char *name, uint32_t ms) {
+  hostAdvance(period);                             // The first frame may have been running already
+  startMeasuring();
+  hostAdvance(ms * 1000UL);
+  measuring = false;
+  uint32_t events = ms * 1000UL / period;
+  printf("%s: period %u us, restarts %u %u, pulses %u %u %u / %u %u %u, max deviation %.2f us\n",
+    name, period, restarts[0], restarts[1], pulses[0][0], pulses[0][1], pulses[0][2],
+    pulses[1][0], pulses[1][1], pulses[1][2], maxDeviation);
+  for (uint8_t t = 0; t < 2; t++) {
+    CHECK((restarts[t] >= events - 1) && (restarts[t] <= events + 1));    // Every event restarts
+    for (uint8_t u = 0; u < 3; u++) CHECK((pulses[t][u] >= events - 1) && (pulses[t][u] <= events + 1));
+  }
+  CHECK(badOrder == 0);
+  CHECK(badOffset == 0);
+  CHECK(duringPulse == 0);
+}
+
+// Polls isSynced() of both timers every 50 us; returns the time (ms) until both have locked
+static unsigned long waitSynced(unsigned long timeout) {
+  unsigned long start = millis();
+  bool synced0 = false;
+  bool synced1 = false;
+  while (!(synced0 && synced1) && (millis() - start < timeout)) {
+    hostAdvance(50);
+    synced0 = Servo::isSynced();
+    synced1 = Servo1::isSynced();
+  }
+  return millis() - start;
+}
+
+// Frames without synchronisation: returns the number of frames of TCA0 in ms
+static uint16_t framesIn(uint32_t ms) {
+  uint16_t first = Servo::getFrame();
+  hostAdvance(ms * 1000UL);
+  return Servo::getFrame() - first;
+}
+
+
+//******************************************************************************************************
+int main(int argc, char *argv[]) {
+  uint32_t firstUs = (argc > 1) ? atol(argv[1]) : 0;
+  hostReset();
+  hostModel.onUpdate = onUpdate;
+  hostModel.onRestart = onRestart;
+  hostEventSource(SYNC_CHANNEL, period, firstUs);
+
+  // Lock before attach(), such that no pulse is disturbed while locking
+  CHECK(Servo::syncFrames(SYNC_CHANNEL));
+  CHECK(Servo1::syncFrames(SYNC_CHANNEL));
+  CHECK(!Servo::isSynced() && !Servo1::isSynced());
+  unsigned long ms = waitSynced(200);
+  printf("locked at %lu ms (first event at %u us)\n", ms, firstUs);
+  CHECK(Servo::isSynced() && Servo1::isSynced());
+  servo0.attach(PIN_PA0);
+  servo1.attach(PIN_PA1);
+  servo2.attach(PIN_PA2);
+  servo3.attach(PIN_PB0);
+  servo4.attach(PIN_PB1);
+  servo5.attach(PIN_PB2);
+  servo0.writeMicroseconds(MAX_PULSE_WIDTH);       // The longest pulse ends closest to the event
+  servo1.writeMicroseconds(1500);
+  servo2.writeMicroseconds(1000);
+  servo3.writeMicroseconds(MAX_PULSE_WIDTH);
+  servo4.writeMicroseconds(MIN_PULSE_WIDTH);
+  servo5.writeMicroseconds(2000);
+  checkLocked("locked", 1000);
+
+  // A sync period that drifts
+  nextPeriod = 20500;
+  hostAdvance(25000);
+  checkLocked("slower", 1000);
+  nextPeriod = 19500;
+  hostAdvance(25000);
+  checkLocked("faster", 1000);
+  nextPeriod = 20000;
+  hostAdvance(25000);
+
+  // Lost events: the frames become three slots long, and lock again once the events return
+  hostEventSource(SYNC_CHANNEL, 0, 0);
+  uint16_t frames = framesIn(480);
+  printf("without events: %u frames in 480 ms\n", frames);
+  CHECK((frames >= 29) && (frames <= 31));         // 16 ms frames
+  hostEventSource(SYNC_CHANNEL, period, 7000);
+  hostAdvance(200000);
+  checkLocked("relocked", 1000);
+
+  // Synchronisation switched off: 20 ms frames, no restarts
+  CHECK(!Servo::syncFrames(SYNC_OFF));
+  CHECK(!Servo1::syncFrames(SYNC_OFF));
+  CHECK(!Servo::isSynced() && !Servo1::isSynced());
+  hostAdvance(20000);
+  startMeasuring();
+  frames = framesIn(1000);
+  measuring = false;
+  printf("sync off: %u frames in 1000 ms, restarts %u %u\n", frames, restarts[0], restarts[1]);
+  CHECK((frames >= 49) && (frames <= 51));
+  CHECK((restarts[0] == 0) && (restarts[1] == 0));
+  CHECK(badOrder == 0);
+
+  // No sync signal: isSynced() stays false; the sketch gives up, and the frames return to 20 ms
+  hostEventSource(SYNC_CHANNEL, 0, 0);
+  unsigned long start = micros();
+  CHECK(Servo::syncFrames(SYNC_CHANNEL));
+  CHECK(micros() - start < 100);                   // syncFrames() doesn't wait for an event
+  ms = waitSynced(200);
+  printf("no events: not locked after %lu ms\n", ms);
+  CHECK(!Servo::isSynced());
+  CHECK(!Servo::syncFrames(SYNC_OFF));
+  frames = framesIn(1000);
+  CHECK((frames >= 49) && (frames <= 51));
+
+  printf("%d failures\n", hostFailures);
+  return hostFailures ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+# Compares two result files of the Test_Benchmark sketch, and lists the items that got slower.
+# Usage: python3 compare-benchmark.py old.csv new.csv [threshold in percent, default 2]
+# The minimum number of cycles is compared, since it is not disturbed by other interrupts.
+# The exit code is 1 if any item got slower than the threshold, so it can be used in scripts.
+import csv
+import sys
+
+
+def load(name):
+    results = {}
+    with open(name) as f:
+        rows = [line for line in f if line.count(",") == 7 and not line.startswith("#")]
+    for row in csv.DictReader(rows):
+        key = (row["item"], row["timer"], row["servos"], row["label"])
+        results[key] = int(row["min"])
+    return results
+
+
+old = load(sys.argv[1])
+new = load(sys.argv[2])
+threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 2.0
+
+slower = 0
+for key in sorted(set(old) | set(new)):
+    name = ",".join(key)
+    if key not in new:
+        print(f"  removed  {name}")
+        continue
+    if key not in old:
+        print(f"  new      {name}: {new[key]} cycles")
+        continue
+    before = old[key]
+    after = new[key]
+    change = (after - before) * 100.0 / before if before else 0.0
+    marker = "  "
+    if change > threshold:
+        marker = "! "
+        slower += 1
+    print(f"{marker}{before:6} -> {after:6} cycles ({change:+6.1f}%)  {name}")
+
+print(f"{slower} item(s) slower than {threshold}%")
+sys.exit(1 if slower else 0)
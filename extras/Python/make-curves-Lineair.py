@@ -1,23 +1,24 @@
 import matplotlib.pyplot as plt
+import csv
 import os
-
-# Define curves from C++ code
-curves = {
-    "lin_A": [(0, 1), (2, 128), (4, 255)],
-    "lin_B": [(0, 255), (2, 128), (4, 0)],
-}
-
-curve_indices = {
-    name: idx for idx, name in enumerate([
-        "lin_A", "lin_B"
-    ])
-}
+import sys
+
+# The curve points are those of the library itself, as printed by the servo simulator of the host model:
+#   make -C ../HostModel && ../HostModel/build/servoSim --curves > curves.csv
+# The file name may also be given as argument.
+curves = {}
+curve_indices = {}
+with open(sys.argv[1] if len(sys.argv) > 1 else "curves.csv") as file:
+    for row in csv.DictReader(file):
+        if not row["name"].startswith("lin_"):
+            continue                                   # See make-curves-Smooth.py
+        curves.setdefault(row["name"], []).append((int(row["time"]), int(row["position"])))
+        curve_indices[row["name"]] = int(row["curve"])
 
 os.makedirs("curves", exist_ok=True)
 
 for name, points in curves.items():
-    # Convert into milliseconds and remove {0,0} endpoint
-    points = [p for p in points if p != (0, 0)]
+    # Convert into milliseconds
     x_vals = [x * 20 for x, _ in points]
     y_vals = [y for _, y in points]
 
@@ -28,7 +29,7 @@ for name, points in curves.items():
     plt.plot(x_vals, y_vals, color='blue', linewidth=1, linestyle='-')
 
 
-    plt.title(f"{name} ({curve_indices.get(name, '?')})", fontsize=14)
+    plt.title(f"{name} ({curve_indices[name]})", fontsize=14)
     plt.xlabel("time (ms)")
     plt.ylabel("position")
     plt.ylim(0, 256)
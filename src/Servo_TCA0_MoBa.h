@@ -17,6 +17,13 @@
 #pragma once
 #include "Servo_TCA0.h"
 #include "TCA_MobaCurves/curves.h"
+#include "TCA_MobaCurves/curveGenerator.h"
+#include "TCA_MobaQueue/moveQueue.h"
+#include "TCA_MobaPower/power.h"
+#include "TCA_MobaConfig/config.h"
+#include "TCA_MobaJournal/journal.h"
+#include "TCA_MobaFeedback/feedback.h"
+#include "TCA_Trace/trace.h"
 
 class ServoMoba: public Servo {
 
@@ -31,16 +38,37 @@ class ServoMoba: public Servo {
     void checkServo();                             // Must be called as often as possible from the main loop 
 
     void moveServoAlongCurve(uint8_t direction);   // Start moving along the path selected with initCurve
+    void moveServoAlongCurve(uint8_t direction,    // As above, but the movement starts after
+      uint8_t delay);                              // 0..255 additional steps of 20 ms
     bool movementCompleted = true;                 // Flag to indicate servo is not moving 
 
+    bool queueMove(                                // Queue a movement. May be called from an ISR
+      uint8_t indexCurve,                          // See curves.cpp, or KEEP_CURVE
+      uint8_t direction,                           // See moveServoAlongCurve()
+      uint8_t timeStretch,                         // 1..255
+      uint8_t dwell                                // 0..255. Steps are in 20 ms
+    );                                             // returns false if the queue is full
+    uint8_t movesQueued();                         // Number of movements waiting in the queue
+    void clearQueue();                             // Removes all movements that are still waiting
+
     void initCurveFromEEPROM(                      // use a predefined curve from EEPROM
       uint8_t indexCurve,                          // 0..3
       uint8_t timeStretch,                         // 1..255
       int adresEeprom                              // The starting address in EEPRROM of this curve
     );
     
-    void initCurveFromPROGMEM(                     // use a predefined curve from PROGMEM
-      uint8_t indexCurve,                          // See curves.cpp for possible curves
+    void initCurveFromPROGMEM(                     // use a predefined or sketch curve from PROGMEM
+      uint8_t indexCurve,                          // See curves.cpp, or a sketchCurve() index
+      uint8_t timeStretch                          // 1..255
+    );
+
+    void initCurveFromTable(                       // use a curve of the sketch, for example from makeCurve()
+      const curvePoint_t *curve,                   // In FLASH_MEMORY, ends with {0, 0}
+      uint8_t timeStretch                          // 1..255
+    );
+
+    void initCurveFromRAM(                         // use a curve in RAM, for example received via ServoProtocol
+      const curvePoint_t *curve,                   // In RAM, ends with {0, 0}
       uint8_t timeStretch                          // 1..255
     );
     
@@ -59,84 +87,127 @@ class ServoMoba: public Servo {
       uint8_t powerOffAfterMoving                  // 0.255. Steps are in 20 ms
     );
     
+    bool initJournal(                              // Keep the position in EEPROM, for a jump-free start-up
+      int adresEeprom,                             // The starting address in EEPROM of the journal
+      uint8_t records                              // 2..127; each record takes JOURNAL_RECORD_SIZE bytes
+    );                                             // returns true if the last position has been restored;
+                                                   // false if the journal is empty, or records < 2 (no journal)
+
     void setTreshold1(uint16_t value);             // Treshold1 can be higher or lower than Treshold2 
-    void setTreshold2(uint16_t value);             // Value in us.
+    void setTreshold2(uint16_t value);             // Value in us. During a movement: effective at the next frame
     uint16_t getTreshold1();                       // returns Treshold1 
     uint16_t getTreshold2();                       // returns Treshold2
 
-    uint16_t getFirstCurvePosition();              // returns the servo position for the start of the curve (in us)
-    uint16_t getLastCurvePosition();               // returns the servo position for the end of the curve (in us)
+    uint16_t getFirstCurvePosition();              // returns the servo position for the start of the curve (in us),
+    uint16_t getLastCurvePosition();               // and for the end, both with the current tresholds
+    uint8_t getServoState();                       // 0 = idle, 1 = start, 2 = moving, 3 = finish
 
-    uint8_t previousCurve;                         // The curve that is currently loaded into myCurve
+    uint8_t getStartDuration();                    // Steps (20 ms) before the curve starts
+    uint16_t getCurveDuration();                   // Steps (20 ms) from the first to the last curve point
+    void setCurveDuration(uint16_t frames);        // Stretch or compress the loaded curve to this number of steps
+
+    uint8_t previousCurve;                         // The curve that is currently loaded
 
     void powerOn();                                // Switch power on
     void powerOff();                               // Switch power off
+    void setMoveCurrent(uint16_t current);         // Current (mA) while moving. See ServoPower::setBudget()
+
+    bool initFeedback(uint8_t analogPin);          // Sample this pin once per frame. See TCA_MobaFeedback/feedback.h
+    uint16_t getFeedback();                        // The latest sample, as seen by checkServo()
+    void setSettle(                                // Position feedback: end the finish state once the servo is there
+      uint16_t atTreshold1,                        // Sample with the servo at treshold1
+      uint16_t atTreshold2,                        // Sample with the servo at treshold2
+      uint8_t tolerance                            // 1..255; 0 switches settling off
+    );
+    void setStall(                                 // Current feedback: stop the servo if it stalls
+      uint16_t limit,                              // Sample above which the servo is stalled; 0 switches it off
+      uint8_t frames                               // 1..255: consecutive frames above the limit
+    );
+    bool stalled = false;                          // Flag to indicate the latest movement was stopped by a stall
 
     void printCurve();                             // May be used for testing. Uses Serial1
 
   //====================================================================================================
   private:
-    typedef struct {                               // A segment is built from a pair of curve points
-      uint8_t index;
-      int16_t xFrom;
-      int16_t xTo;
-      int16_t xDelta;
-      int16_t yFrom;
-      int16_t yTo;
-      int16_t yDelta;
-    } segment_t;
-
-    segment_t segment;
-    
     enum state_t {                                 // the states the servo may be in
       idle,
       start,
       moving,
       finish,
-    } servoState;
+    };
+
+    enum curveSource_t {                           // where the points of the loaded curve are stored
+      noCurve,
+      inFlash,                                     // initCurveFromPROGMEM() and initCurveFromTable()
+      inRam,                                       // initCurveFromRAM(): a copy in ramCurves[]
+      inEeprom                                     // initCurveFromEEPROM()
+    };
+
+    // The state and all flags are packed in two bytes
+    state_t servoState : 2;
+    idlePulseDefault_t idlePulseDefault : 2;       // low, high or continuous
+    curveSource_t curveSource : 2;
+    uint8_t servoDirection : 1;                    // Used in valueTo_us to change both tresholds
+    uint8_t curveDirection : 1;                    // servoDirection when the curve was loaded
+    bool PulseOffNextTick : 1;                     // Flag to stop the pulses, change in 20ms
+    bool idlePowerIsOff : 1;                       // If true, power will be switch off while idle
+    bool powerIsOn : 1;                            // This servo has switched its power rail on
+    bool PowerOnNextTick : 1;                      // Flag for power switch pin, change in 20ms
+    bool PowerOffNextTick : 1;                     // Flag for power switch pin, change in 20ms
+    bool hasCurrent : 1;                           // The budget has granted moveCurrent to this servo
+    bool hasFeedback : 1;                          // initFeedback() succeeded
 
     void servoIdle();                              // Actions to be perfomed while in the idle phase
     void servoStart();                             // Actions to be perfomed while in the start phase
     void servoMoving();                            // Actions to be perfomed while in the moving phase
     void servoFinish();                            // Actions to be perfomed while in the finish phase
 
-    // Moving state: Curves for possible servo movements
-    curvePoint_t myCurve[SIZE_SERVO_CURVE];        // myCurve is the destination Array
-    void fillSegment(uint8_t index);               // initialises the variable for the next segment
+    // The move queue, the position journal and the feedback state are not part of the object. They 
+    // are kept per servoIndex in servo_TCA0_MoBa.cpp, and only take RAM if queueMove(), initJournal()
+    // or the feedback methods are used.
+
+    // Settings that are shared with other servos: pulse and power timing, move current, settling and
+    // stall limits. Index of the entry in the ServoConfig table (see config.h)
+    uint8_t config;
+    uint8_t powerRail;                             // Rail (enable pin) that switches the servo power
+    void changeConfig(const servoConfig_t &value); // Used by the methods that change a setting
+
+    // Moving state: the loaded curve. Its points are not copied, but read where they are stored
+    union {
+      const curvePoint_t *curve;                   // inFlash and inRam
+      uint16_t curveEeprom;                        // inEeprom: address of the first point
+    };
+    uint8_t lastPoint;                             // Index of the last curve point (before the end marker)
+    curvePoint_t curvePoint(uint8_t i);            // Point i of the loaded curve; {0, 0} after the last point
+    void initCurve(uint8_t timeStretch);           // Determines lastPoint, curveEnd and curveFrames
  
     // Moving state: pulsewidth must always stay between these treshold values (in us) 
     int16_t treshold1;                            // Servo may not move beyound this treshold (signed integer!)
     int16_t treshold2;                            // Servo may not move beyound this treshold (signed integer!)
-    int16_t firstCurvePosition;                   // The curve starts here (in us)
-    int16_t lastCurvePosition;                    // The curve ends here (in us)
 
     // Moving state: methods and attributes to control the movement along the curve
-    uint16_t positionIn_us(uint16_t xValue);       // Mapping function for the X-axis
+    uint16_t positionIn_us(uint16_t xValue);       // Mapping function within the segment that ends at index
     uint16_t valueTo_us(uint8_t yValue);           // Mapping function for the Y-axis
+    uint16_t valueTo_us(uint8_t yValue, uint8_t direction);
     uint16_t ticks;                                // Curve time. One tick every 20us
     uint8_t timeStretch;                           // 1..255: will be multiplied to ticks (=> X-coordinate)
+    uint8_t curveEnd;                              // Time of the last curve point
+    uint16_t curveFrames;                          // Duration of the curve, in ticks
+    uint16_t curveTimeToFrames(uint8_t time);      // Mapping function from curve time to ticks
     uint8_t index;                                 // Which segment of the curve is this?
     uint16_t lastPulseWidth;                       // Current / previous pulse time in us (=> Y-coordinate)
-    uint8_t servoDirection;                        // Used in valueTo_us to change both tresholds
     
-    // Idle state: what happens at the servo pulse line?
-    idlePulseDefault_t idlePulseDefault;           // low, high or continuous
-    uint8_t pulseOnBeforeMoving;                   // 0.255. Steps are in 20 ms
-    uint8_t pulseOffAfterMoving;                   // 0.255. Steps are in 20 ms
-    bool PulseOffNextTick;                         // Flag to stop the pulses, change in 20ms
     void pulseOff();                               // Stop the servo pulses
 
-    // Idle state: what happens at the servo power line?
-    uint8_t powerEnablePin;                        // Pin to enable / disable the servo power
-    uint8_t powerEnableValue;                      // 0: Enable with LOW, otherwise: HIGH 
-    uint8_t powerOnBeforeMoving;                   // 0.255. Steps are in 20 ms
-    uint8_t powerOffAfterMoving;                   // 0.255. Steps are in 20 ms
-    bool idlePowerIsOff;                           // If true, power will be switch off while idle
-    bool PowerOnNextTick;                          // Flag for power switch pin, change in 20ms
-    bool PowerOffNextTick;                         // Flag for power switch pin, change in 20ms
-
     // Internal counters for the start and finish states
     uint8_t countServo;
     uint8_t countPulse;
     uint8_t countPower;
+
+    // Catch-up: frames in which checkServo() was not called (see checkServo())
+    uint16_t lastPulseFrame;                       // getPulseFrame() at the previous checkServo() action
+
+    // Optional feedback: a frame-synchronised ADC sample per frame (see TCA_MobaFeedback/feedback.h)
+    void checkFeedback(servoFeedback_t *state);    // Once per frame, from checkServo()
+    void stopStalled();                            // Cut pulses and power, and return to idle
 };
@@ -0,0 +1,67 @@
+//******************************************************************************************************
+//
+// file:      Servo_TCA_Group.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   A group of ServoMoba / ServoMoba1 objects, that is serviced by a single call from the 
+//            main loop.
+//
+// Without a group, the main loop must call checkServo() for every servo "as often as possible".
+// Each of these calls tests, via acceptsNewValue(), if the servo's 20ms frame has just started, 
+// and in most cases it hasn't. With six servos, most loop iterations thus make six calls that do 
+// nothing. 
+// The TCA interrupt service routines maintain a bit mask that tells which servos have just received 
+// their new pulse (see Servo::readyServos()). ServoGroup::checkServos() reads these masks for TCA0 
+// and TCA1, and calls checkServo() only for the servos whose frame has just started. Per 20ms frame 
+// every servo is therefore serviced exactly once, and the per-loop overhead does no longer depend
+// on the number of servos.
+//
+// Members are numbered by their timer and servoIndex: 0..2 are the ServoMoba objects (TCA0), 3..5
+// the ServoMoba1 objects (TCA1). The return value of checkServos() uses the same numbering.
+// moveTogether() is intended for linked mechanisms (double crossing gates, two-servo doors, turnout 
+// plus lock bar), where several servos should start and finish at exactly the same frame, although 
+// their curves and travel distances differ. Each servo uses the curve that was loaded by its own
+// initCurveFromPROGMEM() / initCurveFromEEPROM(). moveTogether() stretches these curves, such that
+// all of them take as long as the longest one, and delays the start of servos that need less steps
+// to switch on power and pulses. A movement that is running is restarted, as with
+// moveServoAlongCurve(); queued movements remain in the queue.
+//
+// readyServos() only clears the bits of the members, so a sketch may have several groups, provided
+// that each servo is member of one group only. It should no longer call checkServo() for servos that
+// are member of a group.
+//
+//******************************************************************************************************
+#pragma once
+#include "Servo_TCA0_MoBa.h"
+#if defined(TCA1)
+#include "Servo_TCA1_MoBa.h"
+#endif
+
+#define MAX_GROUP_SERVOS (2 * SERVOS_PER_TIMER)   // TCA0 plus TCA1
+
+
+class ServoGroup {
+
+  public:
+    ServoGroup();                                  // constructor
+    uint8_t add(ServoMoba &servo);                 // returns the member number, or INVALID_SERVO
+    #if defined(TCA1)
+    uint8_t add(ServoMoba1 &servo);                // returns the member number, or INVALID_SERVO
+    #endif
+    uint8_t checkServos();                         // Call as often as possible. Returns the serviced members
+    uint8_t getMembers();                          // Bit mask of all members
+    uint16_t moveTogether(                         // Start and finish several servos at the same frame
+      uint8_t members,                             // Bit mask of the members that should move
+      uint8_t directions                           // Bit n is the direction of member n
+    );                                             // returns the number of steps (20 ms) until the end
+
+  private:
+    // The members are stored as parallel arrays per timer, indexed by servoIndex
+    ServoMoba *servoTCA0[SERVOS_PER_TIMER];
+    uint8_t membersTCA0;                           // bit n is set if servoIndex n of TCA0 is a member
+    #if defined(TCA1)
+    ServoMoba1 *servoTCA1[SERVOS_PER_TIMER];
+    uint8_t membersTCA1;                           // bit n is set if servoIndex n of TCA1 is a member
+    #endif
+};
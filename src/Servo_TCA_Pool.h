@@ -0,0 +1,256 @@
+//******************************************************************************************************
+//
+// file:      Servo_TCA_Pool.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   A pool of servos, that finds the timer (TCA0 or TCA1) for each pin at attach() time.
+//
+// Without a pool, the sketch decides at compile time which timer drives a servo: objects of class
+// Servo / ServoMoba use TCA0, objects of class Servo1 / ServoMoba1 use TCA1. The sketch must therefore
+// know which pins each timer can drive, and channels are handed out in the order in which the objects
+// are constructed. A pool owns the objects of both timers. attach(pin) asks each timer, via
+// canAttach(), if it can drive the pin with a free Compare Unit, attaches the first timer that can,
+// and returns a pool index. Pool indices are handed out in attach order (0, 1, 2 ...), independent
+// of the timer, and can be used for all further operations:
+// - with(index, function) calls function(servo) with the ServoMoba or ServoMoba1 object. A generic
+//   lambda, such as [](auto &servo) {servo.initCurveFromPROGMEM(2, 3);}, works for both.
+// - forEach(function) does the same for all servos of the pool, in the order of their pool index.
+// - checkServos() services all servos whose frame has just started, like ServoGroup::checkServos(),
+//   but returns a bit mask indexed by pool index.
+// - The most common calls (writeMicroseconds(), moveServoAlongCurve() etc.) are also available
+//   directly, with the pool index as first parameter.
+//
+// The pool is a template, such that it can hold Servo / Servo1 objects (ServoPool) as well as
+// ServoMoba / ServoMoba1 objects (ServoMobaPool). All code is in this header, so a sketch that doesn't
+// declare a pool doesn't get any pool objects.
+//
+// Notes:
+// - The pool constructs SERVOS_PER_TIMER objects per timer, thus takes all channels. A sketch with a
+//   pool should therefore not declare any other Servo, Servo1, ServoMoba or ServoMoba1 object.
+// - Timers are tried in order: TCA0 first. On DxCore all servos of a timer must use the same port,
+//   and the first servo of a timer determines that port. Attaching PIN_PC0 first, for example, ties
+//   TCA0 to PORTC; a later PIN_PB0 then ends up at TCA1.
+// - Pool indices are not reused. Use with(index, ...) to detach() a servo; its pin and Compare Unit
+//   remain reserved, as with detach() of an individual servo.
+// - checkServos() uses readyServos() with the servos of the pool as mask, and should not be combined
+//   with ServoGroup::checkServos() or individual checkServo() calls for the same servos.
+//
+//******************************************************************************************************
+#pragma once
+#include "Servo_TCA0_MoBa.h"
+#if defined(TCA1)
+#include "Servo_TCA1_MoBa.h"
+#define MAX_POOL_SERVOS (2 * SERVOS_PER_TIMER)    // TCA0 plus TCA1
+#else
+#define MAX_POOL_SERVOS (SERVOS_PER_TIMER)        // TCA0 only
+#endif
+
+#define POOL_TCA1      0x80                       // entry[]: set for TCA1; the lower bits are the servoIndex
+#define POOL_INDEX_MASK 0x7F
+
+
+template <class T0, class T1> class ServoPoolOf {
+
+  public:
+    ServoPoolOf();                                 // constructor
+    uint8_t attach(uint8_t pin);                   // returns the pool index, or INVALID_SERVO
+    uint8_t attach(uint8_t pin, int min, int max); // as above but also sets min and max values (in us)
+    uint8_t size();                                // Number of servos attached: pool indices 0 .. size()-1
+    uint8_t getTimer(uint8_t index);               // 0 = TCA0, 1 = TCA1, INVALID_SERVO for unknown indices
+    uint8_t getServoIndex(uint8_t index);          // servoIndex within the timer, or INVALID_SERVO
+    T0 *servoTCA0(uint8_t index);                  // The object if the servo is driven by TCA0, otherwise 0
+    #if defined(TCA1)
+    T1 *servoTCA1(uint8_t index);                  // The object if the servo is driven by TCA1, otherwise 0
+    #endif
+
+    template <class F> void with(uint8_t index, F function);   // function(servo)
+    template <class F> void forEach(F function);   // function(servo), for all servos in pool order
+
+    void write(uint8_t index, uint16_t value);
+    void writeMicroseconds(uint8_t index, uint16_t value);
+    uint16_t readMicroseconds(uint8_t index);      // 0 for unknown indices
+
+    // ServoMobaPool only
+    uint8_t checkServos();                         // Call as often as possible. Returns the serviced pool indices
+    void moveServoAlongCurve(uint8_t index, uint8_t direction);
+    bool movementCompleted(uint8_t index);         // true for unknown indices
+
+  private:
+    T0 objectsTCA0[SERVOS_PER_TIMER];
+    T0 *byServoIndexTCA0[SERVOS_PER_TIMER];        // Attached objects, indexed by servoIndex
+    uint8_t poolIndexTCA0[SERVOS_PER_TIMER];       // Pool index, indexed by servoIndex
+    uint8_t membersTCA0;                           // bit n is set if servoIndex n of TCA0 is attached
+    #if defined(TCA1)
+    T1 objectsTCA1[SERVOS_PER_TIMER];
+    T1 *byServoIndexTCA1[SERVOS_PER_TIMER];
+    uint8_t poolIndexTCA1[SERVOS_PER_TIMER];
+    uint8_t membersTCA1;
+    #endif
+    uint8_t entry[MAX_POOL_SERVOS];                // Per pool index: POOL_TCA1 bit plus servoIndex
+    uint8_t count;                                 // Number of entries in use
+
+    template <class T> uint8_t attachTo(T *objects, T **byServoIndex, uint8_t *poolIndex,
+      uint8_t &members, uint8_t timerBit, uint8_t pin, int min, int max);
+};
+
+#if defined(TCA1)
+typedef ServoPoolOf<Servo, Servo1> ServoPool;
+typedef ServoPoolOf<ServoMoba, ServoMoba1> ServoMobaPool;
+#else                                              // The second type is not used
+typedef ServoPoolOf<Servo, Servo> ServoPool;
+typedef ServoPoolOf<ServoMoba, ServoMoba> ServoMobaPool;
+#endif
+
+
+//******************************************************************************************************
+// Implementation. Templates must be visible to the sketch, so this is not in a .cpp file
+//******************************************************************************************************
+template <class T0, class T1> ServoPoolOf<T0, T1>::ServoPoolOf() {
+  count = 0;
+  membersTCA0 = 0;
+  #if defined(TCA1)
+  membersTCA1 = 0;
+  #endif
+}
+
+
+// Objects are taken in the order of their servoIndex. An object that didn't get a channel (because
+// the sketch declared other servo objects as well) is skipped.
+template <class T0, class T1> template <class T>
+uint8_t ServoPoolOf<T0, T1>::attachTo(T *objects, T **byServoIndex, uint8_t *poolIndex,
+  uint8_t &members, uint8_t timerBit, uint8_t pin, int min, int max) {
+  for (uint8_t i = 0; i < SERVOS_PER_TIMER; i++) {
+    uint8_t servoIndex = objects[i].getServoIndex();
+    if ((servoIndex >= SERVOS_PER_TIMER) || (members & (1 << servoIndex))) continue;
+    if (objects[i].attach(pin, min, max) == INVALID_SERVO) return INVALID_SERVO;
+    byServoIndex[servoIndex] = &objects[i];
+    poolIndex[servoIndex] = count;
+    members |= (1 << servoIndex);
+    entry[count] = timerBit | servoIndex;
+    return count++;
+  }
+  return INVALID_SERVO;
+}
+
+
+template <class T0, class T1> uint8_t ServoPoolOf<T0, T1>::attach(uint8_t pin, int min, int max) {
+  uint8_t index = INVALID_SERVO;
+  if (count >= MAX_POOL_SERVOS) return INVALID_SERVO;
+  if (T0::canAttach(pin))
+    index = attachTo(objectsTCA0, byServoIndexTCA0, poolIndexTCA0, membersTCA0, 0, pin, min, max);
+  #if defined(TCA1)
+  if ((index == INVALID_SERVO) && T1::canAttach(pin))
+    index = attachTo(objectsTCA1, byServoIndexTCA1, poolIndexTCA1, membersTCA1, POOL_TCA1, pin, min, max);
+  #endif
+  return index;
+}
+
+
+// With the default limits, attach(pin, min, max) gives the same result as attach(pin)
+template <class T0, class T1> uint8_t ServoPoolOf<T0, T1>::attach(uint8_t pin) {
+  return attach(pin, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH);
+}
+
+
+template <class T0, class T1> uint8_t ServoPoolOf<T0, T1>::size() {
+  return count;
+}
+
+
+template <class T0, class T1> uint8_t ServoPoolOf<T0, T1>::getTimer(uint8_t index) {
+  if (index >= count) return INVALID_SERVO;
+  return (entry[index] & POOL_TCA1) ? 1 : 0;
+}
+
+
+template <class T0, class T1> uint8_t ServoPoolOf<T0, T1>::getServoIndex(uint8_t index) {
+  if (index >= count) return INVALID_SERVO;
+  return entry[index] & POOL_INDEX_MASK;
+}
+
+
+template <class T0, class T1> T0 *ServoPoolOf<T0, T1>::servoTCA0(uint8_t index) {
+  if ((index >= count) || (entry[index] & POOL_TCA1)) return 0;
+  return byServoIndexTCA0[entry[index]];
+}
+
+
+#if defined(TCA1)
+template <class T0, class T1> T1 *ServoPoolOf<T0, T1>::servoTCA1(uint8_t index) {
+  if ((index >= count) || !(entry[index] & POOL_TCA1)) return 0;
+  return byServoIndexTCA1[entry[index] & POOL_INDEX_MASK];
+}
+#endif
+
+
+template <class T0, class T1> template <class F> void ServoPoolOf<T0, T1>::with(uint8_t index, F function) {
+  if (index >= count) return;
+  uint8_t servoIndex = entry[index] & POOL_INDEX_MASK;
+  #if defined(TCA1)
+  if (entry[index] & POOL_TCA1) {function(*byServoIndexTCA1[servoIndex]); return;}
+  #endif
+  function(*byServoIndexTCA0[servoIndex]);
+}
+
+
+template <class T0, class T1> template <class F> void ServoPoolOf<T0, T1>::forEach(F function) {
+  for (uint8_t i = 0; i < count; i++) with(i, function);
+}
+
+
+template <class T0, class T1> void ServoPoolOf<T0, T1>::write(uint8_t index, uint16_t value) {
+  with(index, [value](auto &servo) {servo.write(value);});
+}
+
+
+template <class T0, class T1> void ServoPoolOf<T0, T1>::writeMicroseconds(uint8_t index, uint16_t value) {
+  with(index, [value](auto &servo) {servo.writeMicroseconds(value);});
+}
+
+
+template <class T0, class T1> uint16_t ServoPoolOf<T0, T1>::readMicroseconds(uint8_t index) {
+  uint16_t value = 0;
+  with(index, [&value](auto &servo) {value = servo.readMicroseconds();});
+  return value;
+}
+
+
+//******************************************************************************************************
+// checkServos() reads the bit masks of both timers, as ServoGroup::checkServos() does, and translates
+// the servoIndex of each serviced servo into its pool index.
+//******************************************************************************************************
+template <class T0, class T1> uint8_t ServoPoolOf<T0, T1>::checkServos() {
+  uint8_t serviced = 0;
+  uint8_t ready = T0::readyServos(membersTCA0);
+  for (uint8_t i = 0; ready; i++) {
+    if (ready & 1) {
+      byServoIndexTCA0[i]->checkServo();
+      serviced |= (1 << poolIndexTCA0[i]);
+    }
+    ready >>= 1;
+  }
+  #if defined(TCA1)
+  ready = T1::readyServos(membersTCA1);
+  for (uint8_t i = 0; ready; i++) {
+    if (ready & 1) {
+      byServoIndexTCA1[i]->checkServo();
+      serviced |= (1 << poolIndexTCA1[i]);
+    }
+    ready >>= 1;
+  }
+  #endif
+  return serviced;
+}
+
+
+template <class T0, class T1> void ServoPoolOf<T0, T1>::moveServoAlongCurve(uint8_t index, uint8_t direction) {
+  with(index, [direction](auto &servo) {servo.moveServoAlongCurve(direction);});
+}
+
+
+template <class T0, class T1> bool ServoPoolOf<T0, T1>::movementCompleted(uint8_t index) {
+  bool completed = true;
+  with(index, [&completed](auto &servo) {completed = servo.movementCompleted;});
+  return completed;
+}
@@ -0,0 +1,151 @@
+//******************************************************************************************************
+//
+// file:      Servo_TCA_Protocol.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Compact binary command and telemetry protocol for ServoMoba / ServoMoba1 objects.
+//            It allows the AVR to act as a servo co-processor for a larger controller (that may
+//            drive many of such nodes), via a UART or via TWI (I2C) in target mode.
+//
+// Frame format (requests as well as replies):
+//   SYNC (0xA5) | LENGTH | COMMAND | PAYLOAD (LENGTH bytes) | CRC
+// - LENGTH is the number of payload bytes (0..PROTOCOL_MAX_PAYLOAD)
+// - CRC is a CRC-8 (polynomial 0x07, initial value 0) over LENGTH, COMMAND and PAYLOAD
+// - 16 bit values are little endian
+// Every request gets a reply with COMMAND | PROTOCOL_REPLY; the first payload byte of the reply is
+// a result code (PROTOCOL_OK, or one of the errors below). Frames with a wrong CRC are ignored (and
+// counted); the parser then searches for the next SYNC byte.
+//
+// Servos are numbered as in ServoGroup: 0..2 are the ServoMoba objects (TCA0), 3..5 the ServoMoba1
+// objects (TCA1), using their servoIndex. Requests (payload) and replies (payload after the result):
+//   CMD_WRITE        {servo, pulse (2)} ...     writeMicroseconds() for one or more servos
+//   CMD_CURVE        servo, curve, stretch      initCurveFromPROGMEM()
+//   CMD_MOVE         servo, direction, delay    moveServoAlongCurve()
+//   CMD_QUEUE        servo, curve, direction, stretch, dwell   queueMove()
+//   CMD_UPLOAD       servo, stretch, {time, position} ... {0, 0}   initCurveFromRAM()
+//   CMD_STATUS       -                          per servo: state, flags, queued, pulse (2)
+//                                               (flags: bit 0 = attached, bit 1 = movementCompleted)
+//   CMD_STATS        -                          per timer: missedFrames (2), overwrittenValues (2),
+//                                               maxLatency (2), LATENCY_BUCKETS counts (2 each); then
+//                                               the protocol's own frame and CRC error counters (2 + 2)
+//   CMD_RESET_STATS  -                          resetTimerStats() for both timers
+//
+// The parser is incremental: poll() should be called from the main loop (for example once per
+// frame, or after ServoGroup::checkServos()). Each call handles at most PROTOCOL_BYTES_PER_POLL
+// received bytes and at most one frame, so its costs are bounded. Frames are not copied: commands
+// are executed directly from the receive buffer. Replies are sent as far as the transport accepts
+// them; the rest follows with the next calls of poll(). No call ever waits for the transport.
+//
+// Transports are small classes derived from ServoTransport. StreamTransport (below) is used for a
+// UART (or any other Stream). TwiTransport (see TCA_MobaProtocol/twiTransport.h) is for TWI in
+// target mode, and requires the Wire library.
+//
+//******************************************************************************************************
+#pragma once
+#include "Servo_TCA0_MoBa.h"
+#if defined(TCA1)
+#include "Servo_TCA1_MoBa.h"
+#endif
+
+#define PROTOCOL_SYNC           0xA5
+#define PROTOCOL_MAX_PAYLOAD      52             // CMD_UPLOAD with SIZE_SERVO_CURVE points
+#define PROTOCOL_FRAME_OVERHEAD    4             // SYNC, LENGTH, COMMAND and CRC
+#define PROTOCOL_BYTES_PER_POLL   16             // Received bytes handled per call of poll()
+#define PROTOCOL_SERVOS         (2 * SERVOS_PER_TIMER)
+
+// Commands
+#define CMD_WRITE               0x01
+#define CMD_CURVE               0x02
+#define CMD_MOVE                0x03
+#define CMD_QUEUE               0x04
+#define CMD_UPLOAD              0x05
+#define CMD_STATUS              0x06
+#define CMD_STATS               0x07
+#define CMD_RESET_STATS         0x08
+#define PROTOCOL_REPLY          0x80             // Added to the command in the reply
+
+// Result codes
+#define PROTOCOL_OK                0
+#define PROTOCOL_BAD_COMMAND       1
+#define PROTOCOL_BAD_LENGTH        2
+#define PROTOCOL_BAD_SERVO         3
+#define PROTOCOL_BAD_VALUE         4
+#define PROTOCOL_QUEUE_FULL        5
+
+
+//******************************************************************************************************
+// Transports. read() and write() should never wait.
+//******************************************************************************************************
+class ServoTransport {
+  public:
+    virtual int available() = 0;                   // Number of received bytes
+    virtual int read() = 0;                        // The next received byte, or -1
+    virtual uint8_t write(const uint8_t *data, uint8_t length) = 0;   // Returns the bytes accepted
+};
+
+class StreamTransport: public ServoTransport {
+  public:
+    StreamTransport(Stream &stream): stream(stream) {}
+    int available() {return stream.available();}
+    int read() {return stream.read();}
+    uint8_t write(const uint8_t *data, uint8_t length) {
+      int space = stream.availableForWrite();
+      if (space <= 0) return 0;
+      if (length > space) length = space;
+      return stream.write(data, length);
+    }
+
+  private:
+    Stream &stream;
+};
+
+
+//******************************************************************************************************
+// The protocol
+//******************************************************************************************************
+class ServoProtocol {
+
+  public:
+    ServoProtocol(ServoTransport &transport);      // constructor
+    uint8_t add(ServoMoba &servo);                 // returns the servo number, or INVALID_SERVO
+    #if defined(TCA1)
+    uint8_t add(ServoMoba1 &servo);                // returns the servo number, or INVALID_SERVO
+    #endif
+    bool poll();                                   // Call from the main loop. Returns true if a frame was executed
+    uint16_t getFrames();                          // Number of frames executed
+    uint16_t getErrors();                          // Number of frames with a wrong CRC
+
+  private:
+    enum rxState_t {waitSync, waitLength, waitCommand, waitPayload, waitCrc};
+
+    ServoTransport &transport;
+    ServoMoba *servoTCA0[SERVOS_PER_TIMER];
+    #if defined(TCA1)
+    ServoMoba1 *servoTCA1[SERVOS_PER_TIMER];
+    #endif
+
+    // Receive side: the frame is stored from LENGTH onwards; the payload starts at rx[2]
+    rxState_t rxState;
+    uint8_t rx[PROTOCOL_MAX_PAYLOAD + 2];
+    uint8_t rxCount;                               // Payload bytes received so far
+    uint8_t rxCrc;
+
+    // Transmit side: the complete reply frame
+    uint8_t tx[PROTOCOL_MAX_PAYLOAD + PROTOCOL_FRAME_OVERHEAD];
+    uint8_t txLength;                              // Length of the reply frame (0: no reply)
+    uint8_t txSent;                                // Bytes of the reply frame already sent
+
+    uint16_t frames;
+    uint16_t errors;
+
+    void execute();                                // Executes the frame in rx
+    uint8_t executeWrite(const uint8_t *payload, uint8_t length);
+    uint8_t executeServo(uint8_t command, const uint8_t *payload, uint8_t length);
+    void addStatus(uint8_t servo);
+    void addStats(const servoStats_t &stats, uint16_t (*latencyCount)(uint8_t));
+    void reply(uint8_t result);                    // Starts the reply frame
+    void add8(uint8_t value);                      // Adds a byte to the reply payload
+    void add16(uint16_t value);
+    void sendReply();
+};
@@ -21,12 +21,13 @@
 #define takeOverTCA() takeOverTCA0()            // Used in the .cpp file
 #define resumeTCA()   resumeTCA0()              // Used in the .cpp file
 #define ServoHandler  TCA0_OVF_vect             // Used in the .cpp file
+#define SyncUser      EVSYS.USERTCA0CNTB        // Used in the .cpp file (frame synchronisation)
 
 //******************************************************************************************************
 // The initialisation of the multplexer depends on the processor being used.
 // DxCore and MEGACOREX processors require that all pins belong to the same port
 //******************************************************************************************************
-static boolean initMultiplexer(uint8_t port) {
+static boolean initMultiplexer(uint8_t port, boolean apply = true) {   // apply = false: only test the port
   boolean configured = false;
   // DxCore will preset the PORTMUX to a certain port during startup. 
   // Therefore we have to clear the TCA0 bits before we can set it with new values. 
@@ -70,7 +71,7 @@ static boolean initMultiplexer(uint8_t port) {
     break;
     #endif
   }  
-  if (configured) PORTMUX.TCAROUTEA = tcaroutea; // write the temp variable back to the register.
+  if (configured && apply) PORTMUX.TCAROUTEA = tcaroutea;   // write the temp variable back to the register.
   return configured;
 }
 
@@ -80,19 +81,16 @@ static boolean enableCompareUnit(uint8_t compareUnit, uint8_t servoIndex) {
   switch (compareUnit) { 
     case 0:                                                         // Compare Unit 0
       compareUnit0 = servoIndex;                                    // index into the channels array
-      channels[servoIndex].CompareUnit = 0;                         // attach the channel to the Compare Unit
       _TIMER.CTRLB |= TCA_SINGLE_CMP0EN_bm;                         // enable Compare Unit 0
       enabled = true;
     break;
     case 1: 
       compareUnit1 = servoIndex;
-      channels[servoIndex].CompareUnit = 1;
       _TIMER.CTRLB |= TCA_SINGLE_CMP1EN_bm;                         // enable Compare Unit 1
       enabled = true;
     break;
     case 2: 
       compareUnit2 = servoIndex;
-      channels[servoIndex].CompareUnit = 2;
       _TIMER.CTRLB |= TCA_SINGLE_CMP2EN_bm;                         // enable Compare Unit 2     
       enabled = true;
     break;
@@ -135,6 +133,43 @@ static boolean initCompareUnit(byte pin, uint8_t servoIndex) {
 }
 
 
+//******************************************************************************************************
+// For attach<pin>(), which writes PORTMUX and CTRLB itself (see servo_TCA0.h): the compiler has
+// already determined (and checked) the port and Compare Unit of the pin, see TCA_Pins/pinMap.h.
+// As initCompareUnit(), all servos must use the same port.
+//******************************************************************************************************
+static boolean claimCompareUnit(uint8_t port, uint8_t compareUnit, uint8_t servoIndex) {
+  if ((usedPort != NO_PORT) && (usedPort != port)) return false;
+  usedPort = port;
+  if (compareUnit == 0) compareUnit0 = servoIndex;                  // index into the channels array
+  else if (compareUnit == 1) compareUnit1 = servoIndex;
+  else compareUnit2 = servoIndex;
+  return true;
+}
+
+
+//******************************************************************************************************
+// pinIsFree() tells if initCompareUnit() would accept the pin, without changing any register: the pin
+// belongs to the port in use (or, for the first servo, to a port the multiplexer supports), and its
+// Compare Unit has not yet been taken by another servo. Used by Servo::canAttach().
+//******************************************************************************************************
+static boolean pinIsFree(byte pin) {
+  uint8_t newPort = digitalPinToPort(pin);
+  if (usedPort == NO_PORT) {
+    if (!initMultiplexer(newPort, false)) return false;
+  }
+  else {
+    if (usedPort != newPort) return false;
+  }
+  switch (digitalPinToBitPosition(pin)) {
+    case 0: return (compareUnit0 == NO_CHANNEL);
+    case 1: return (compareUnit1 == NO_CHANNEL);
+    case 2: return (compareUnit2 == NO_CHANNEL);
+  }
+  return false;
+}
+
+
 //******************************************************************************************************
 // MegaCoreX (ATmega4809, ATmega4808, ATmega3209, ATmega3208, ATmega1609, ATmega1608, ATmega809 and 
 // ATmega808) doesn't define takeOverTCA(). Therefore we copied the code from DxCore here, 
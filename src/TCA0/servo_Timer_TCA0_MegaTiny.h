@@ -22,6 +22,7 @@
 #define takeOverTCA() takeOverTCA0()            // Used in the .cpp file
 #define resumeTCA()   resumeTCA0()              // Used in the .cpp file
 #define ServoHandler  TCA0_OVF_vect             // Used in the .cpp file
+#define SyncUser      EVSYS.USERTCA0CNTB        // Used in the .cpp file (frame synchronisation)
 
 
 //******************************************************************************************************
@@ -49,26 +50,22 @@ static boolean initCompareUnit(byte pin, uint8_t servoIndex) {
   uint8_t servoPin = digitalPinToBitPosition(pin);
   switch (servoPin) { 
     case 1: 
-      compareUnit0 = servoIndex;                                    // index into the channels array
-      channels[servoIndex].CompareUnit = 1;                         // attach the channel to the Compare Unit
+      compareUnit1 = servoIndex;                                    // index into the channels array
       _TIMER.CTRLB |= TCA_SINGLE_CMP1EN_bm;                         // enable Compare Unit 1
       TCAMUX &= ~PORTMUX_TCA0_1_bm;                                 // use the default pin
     break;
     case 2: 
       compareUnit2 = servoIndex;
-      channels[servoIndex].CompareUnit = 2;
       _TIMER.CTRLB |= TCA_SINGLE_CMP2EN_bm;                         // enable Compare Unit 2     
       TCAMUX &= ~PORTMUX_TCA0_2_bm;                                 // use the default pin
     break;
     case 3:
       compareUnit0 = servoIndex;
-      channels[servoIndex].CompareUnit = 0;
       _TIMER.CTRLB |= TCA_SINGLE_CMP0EN_bm;                         // enable Compare Unit 0
       TCAMUX &= ~PORTMUX_TCA0_0_bm;                                 // use the default pin
     break;
     case 7:                                                         // Not on 14 pins processors
       compareUnit0 = servoIndex;
-      channels[servoIndex].CompareUnit = 0;
       _TIMER.CTRLB |= TCA_SINGLE_CMP0EN_bm;                         // enable Compare Unit 0     
       TCAMUX |= PORTMUX_TCA0_0_bm;                                  // use the alternativ pin
     break;
@@ -80,6 +77,18 @@ static boolean initCompareUnit(byte pin, uint8_t servoIndex) {
   return true;
 }
 
+
+// Tells, without changing any register, if initCompareUnit() would accept the pin (see canAttach())
+static boolean pinIsFree(byte pin) {
+  switch (digitalPinToBitPosition(pin)) {
+    case 1: return (compareUnit1 == NO_CHANNEL);
+    case 2: return (compareUnit2 == NO_CHANNEL);
+    case 3:
+    case 7: return (compareUnit0 == NO_CHANNEL);
+  }
+  return false;
+}
+
 //
 #else                                                               // _AVR_PINCOUNT != 8
 //===
@@ -91,37 +100,31 @@ static boolean initCompareUnit(byte pin, uint8_t servoIndex) {
   switch (servoPin) { 
     case 0:                                                         // Compare Unit 0
       compareUnit0 = servoIndex;                                    // index into the channels array
-      channels[servoIndex].CompareUnit = 0;                         // attach the channel to the Compare Unit
       _TIMER.CTRLB |= TCA_SINGLE_CMP0EN_bm;                         // enable Compare Unit 0
       TCAMUX &= ~PORTMUX_TCA0_0_bm;                                 // use the default pin
     break;
     case 1: 
       compareUnit1 = servoIndex;
-      channels[servoIndex].CompareUnit = 1;
       _TIMER.CTRLB |= TCA_SINGLE_CMP1EN_bm;                         // enable Compare Unit 1
       TCAMUX &= ~PORTMUX_TCA0_1_bm;                                 // use the default pin
     break;
     case 2: 
       compareUnit2 = servoIndex;
-      channels[servoIndex].CompareUnit = 2;
       _TIMER.CTRLB |= TCA_SINGLE_CMP2EN_bm;                         // enable Compare Unit 2     
       TCAMUX &= ~PORTMUX_TCA0_2_bm;                                 // use the default pin
     break;
     case 3:
       compareUnit0 = servoIndex;
-      channels[servoIndex].CompareUnit = 0;
       _TIMER.CTRLB |= TCA_SINGLE_CMP0EN_bm;                         // enable Compare Unit 0
       TCAMUX |= PORTMUX_TCA0_0_bm;                                  // use the alternativ pin
     break;
     case 4:                                                         // Not on 14 pins processors
       compareUnit1 = servoIndex;
-      channels[servoIndex].CompareUnit = 1;
       _TIMER.CTRLB |= TCA_SINGLE_CMP1EN_bm;                         // enable Compare Unit 1
       TCAMUX |= PORTMUX_TCA0_1_bm;                                  // use the alternativ pin
     break;
     case 5:                                                         // Not on 14 pins processors
       compareUnit2 = servoIndex;
-      channels[servoIndex].CompareUnit = 2;
       _TIMER.CTRLB |= TCA_SINGLE_CMP2EN_bm;                         // enable Compare Unit 2     
       TCAMUX |= PORTMUX_TCA0_2_bm;                                  // use the alternativ pin
     break;
@@ -133,10 +136,36 @@ static boolean initCompareUnit(byte pin, uint8_t servoIndex) {
   return true;
 }
 
+
+// Tells, without changing any register, if initCompareUnit() would accept the pin (see canAttach())
+static boolean pinIsFree(byte pin) {
+  if (digitalPinToPort(pin) != PB) return false;
+  switch (digitalPinToBitPosition(pin)) {
+    case 0:
+    case 3: return (compareUnit0 == NO_CHANNEL);
+    case 1:
+    case 4: return (compareUnit1 == NO_CHANNEL);
+    case 2:
+    case 5: return (compareUnit2 == NO_CHANNEL);
+  }
+  return false;
+}
+
 //
 #endif                                                              // _AVR_PINCOUNT != 8
 //====
 
+
+// For attach<pin>(), which writes TCAMUX and CTRLB itself (see servo_TCA0.h): the compiler has
+// already determined (and checked) the Compare Unit of the pin, see TCA_Pins/pinMap.h. Each
+// Compare Unit has its own TCAMUX bit, so there is no port to check.
+static boolean claimCompareUnit(uint8_t port, uint8_t compareUnit, uint8_t servoIndex) {
+  if (compareUnit == 0) compareUnit0 = servoIndex;                  // index into the channels array
+  else if (compareUnit == 1) compareUnit1 = servoIndex;
+  else compareUnit2 = servoIndex;
+  return true;
+}
+
 //======================================================================================================
 #else
 #error "TCA0 is not defined for this processor / Board is not MEGATINYCORE"
@@ -28,24 +28,69 @@
 
 #if defined(TCA1) // Skip if we don't have a TCA1 timer
 #include "../servo_TCA1.h"
+#include "../servo_TCA0.h"                     // Servo::setFollower(), see followTCA0()
+#include "../TCA_Trace/trace.h"
+#include "../TCA_Clock/tickScale.h"
 
 //******************************************************************************************************
-// The following typedef is for internal use by this library. It is used to create an array holding  
-// three channels, that act as interface between the servo objects and the processor's compare units.
+// The following variables are for internal use by this library. They hold three channels, that act
+// as interface between the servo objects and the processor's compare units.
 // Servo objects operate on channels, which in turn are used by the TCA interrupt routine.
 // After a succeful attach(), servo objects receive a "servoIndex" that can be used to access 
-// the channels array, via channels[servoIndex].xxx
+// the channels, via ChannelTicks[servoIndex] and channels[servoIndex].xxx
+// The channels are stored as a struct of arrays: the pulse widths in one array, and the flags as
+// bit masks, in which bit n belongs to servoIndex n. The ISR and the polling methods thus test the
+// state of a channel (or of all channels) with a single load and mask. Since the ISR changes bits
+// in the same bytes, the main loop must change these masks with interrupts disabled.
 // Note that all variables must be declared as static, to ensure their scope remains within this unit.
 //******************************************************************************************************
-typedef struct {
-  volatile uint8_t CompareUnit = 255;  // 0, 1 or 2. 255 if mapping of channel to Compare Unit fails
-  volatile uint16_t ticks;             // value for the Compare n Buffer Register
-  volatile bool CMPisSet;              // true if the Compare Unit has received the latest value
-  volatile bool isActive;              // true if this servo is attached
+static volatile uint16_t ChannelTicks[MAX_SERVOS];// value for the Compare n Buffer Register
+static volatile uint8_t ActiveServos = 0;       // bit n is set if servo n is attached
+static volatile uint8_t CommittedServos = 0;    // bit n is set if the Compare Unit has received the latest value
+static volatile uint8_t PendingServos = 0;      // bit n is set if ticks has not yet been used by the ISR
+static volatile uint8_t SlewingServos = 0;      // bit n is set while the ISR moves servo n towards TargetTicks
+static volatile uint16_t TargetTicks[MAX_SERVOS];// slew rate limited writes: the value written by the main loop
+static volatile uint16_t SlewStep[MAX_SERVOS];  // slew rate limit in ticks per frame, times SLEW_ONE. 0 = no limit
+static uint8_t SlewFraction[MAX_SERVOS];        // remainder of the steps taken so far, in 1/SLEW_ONE ticks
+static volatile uint8_t ConstantServos = 0;     // bit n is set while servo n outputs a constant level
+static volatile uint8_t FrameServos = 0;        // bit n is set if the main loop needs the frames of servo n
+
+typedef struct {                       // The channel data that is used per channel only
+  volatile uint16_t readySlot;         // value of Slots when the main loop had to react on the pulse
+  volatile uint16_t pulseFrame;        // value of Frames when the ISR started the latest pulse
+  volatile uint16_t missedFrames;      // statistics: see TCA_Stats/servoStats.h
+  uint16_t overwrittenValues;
+  uint16_t maxLatency;
 } channel_t;
 
 static channel_t channels[MAX_SERVOS];         // the array of channels
 
+// Calibration per servoIndex, outside the servo objects (see setCalibration()). The array is only
+// referenced by setCalibration(), which sets the pointer next to it; without calibration, the array
+// is not linked and takes no RAM.
+typedef struct {
+  ServoCalibration *table;             // 0 if this servo is not calibrated
+  uint16_t requested;                  // pulse width (us) as written, before the calibration
+} calibrated_t;
+
+static calibrated_t calibrationStorage[MAX_SERVOS];
+static calibrated_t *calibrations = 0;
+
+static inline void setServoBits(volatile uint8_t &mask, uint8_t bits) {
+  uint8_t oldSREG = SREG;
+  cli();
+  mask |= bits;
+  SREG = oldSREG;
+}
+
+static inline void clearServoBits(volatile uint8_t &mask, uint8_t bits) {
+  uint8_t oldSREG = SREG;
+  cli();
+  mask &= ~bits;
+  SREG = oldSREG;
+}
+
+
 //******************************************************************************************************
 // Include the file that contains the code to initialise the multiplexer and the compare unit
 //******************************************************************************************************
@@ -60,9 +105,9 @@ static uint8_t compareUnit2 = NO_CHANNEL;      // Point from the compare unit to
 //******************************************************************************************************
 // Check if the library supports the current clockspeed
 #if (F_CPU != 48000000) && (F_CPU != 40000000) && (F_CPU != 36000000) && (F_CPU != 32000000) \
- && (F_CPU != 28000000) && (F_CPU != 24000000) && (F_CPU != 20000000) && (F_CPU != 16000000) \
- && (F_CPU != 12000000) && (F_CPU != 10000000) && (F_CPU !=  8000000) && (F_CPU !=  5000000) \
- && (F_CPU !=  4000000) && (F_CPU !=  1000000) 
+ && (F_CPU != 30000000) && (F_CPU != 28000000) && (F_CPU != 24000000) && (F_CPU != 20000000) \
+ && (F_CPU != 16000000) && (F_CPU != 12000000) && (F_CPU != 10000000) && (F_CPU !=  8000000) \
+ && (F_CPU !=  5000000) && (F_CPU !=  4000000) && (F_CPU !=  1000000) 
 #error "Library has not been designed for this Clock Speed "
 #endif
 
@@ -71,21 +116,20 @@ static uint8_t compareUnit2 = NO_CHANNEL;      // Point from the compare unit to
 // Set the prescaler, and define two functions:
 // - usToTicks(us):    converts microseconds to ticks               (us = 0 ... 20000/3)
 // - ticksToUs(ticks): converts from ticks back to microseconds     (ticks = 0 ... 60000)
-// Note that rounding errors may occur during calculation of these functions, leading to lost precision.
 //
-// The sketch may run at different clock speeds: 1, 4, 5, 8, 10, 12, 16, 20, 24MHz (28, 32, 36, 40, 48)
-// clockCyclesPerMicrosecond() can be: 1, 4, 5, 8, 10, 12, 16, 20, 24(, 28, 30, 32, 36, 40, 48)
+// The sketch may run at different clock speeds: 1, 4, 5, 8, 10, 12, 16, 20, 24MHz (28, 30, 32, 36, 40, 48)
 // The prescaler can take the values: 1, 2, 4 and 8.
 //
 // Prescaler    clockCyclesPerMicrosecond()       clockCyclesPerMicrosecond() / Prescaler 
 // ---------------------------------------------------------------------------------------
 //     1                1, 4, 5, 8                               1, 4, 5, 8                   
 //     2                10, 12, 16                                 5, 6, 8                    
-//     4             20, 24, 28, 32 36                          5, 6, 7, 8, 9                 
+//     4           20, 24, 28, 30, 32 36                      5, 6, 7, 7.5, 8, 9              
 //     8                  40, 48                                   5, 6                     
 // 
-// To limit rounding errors / overflows in usToTicks() and ticksToUs(), we always divide first
-// clockCyclesPerMicrosecond by the prescaler.
+// Since the number of ticks per microsecond is not always a whole number (30 MHz), both functions
+// are calculated by TickScale (see TCA_Clock/tickScale.h): the compiler turns F_CPU / PRESCALER into
+// an exact fraction, and both conversions into a multiplication and a shift, without divisions.
 // Note: this approach differs from the original DxCore Servo library (for TCB)!
 #if (F_CPU > 36000000) // requires external clock and has not been tested
   #define PRESCALER 8 
@@ -102,14 +146,22 @@ static uint8_t compareUnit2 = NO_CHANNEL;      // Point from the compare unit to
 #endif
 
 
-#define CYCLES_DIV_PRESCALER   (clockCyclesPerMicrosecond() / PRESCALER)
+typedef TickScale<F_CPU, PRESCALER> tickScale;
+static_assert(PRESCALER == tcaPrescaler(F_CPU), "tcaPrescaler() differs from PRESCALER");
+static_assert(tickScale::roundTripIsExact(), "Pulse widths can not be converted exactly at this clock speed");
+static_assert(angleToUsIsExact(), "write(angle) would differ from map()");
+
 #define ISR_PERIOD             ((int) REFRESH_INTERVAL / SERVOS_PER_TIMER)
 #define SERVO_MIN()            (MIN_PULSE_WIDTH - (int8_t)this->min * 4)
 #define SERVO_MAX()            (MAX_PULSE_WIDTH - this->max * 4)
-#define usToTicks(_us)         (CYCLES_DIV_PRESCALER * _us) 
-#define ticksToUs(_ticks)      ((unsigned) (_ticks / CYCLES_DIV_PRESCALER))
+#define usToTicks(_us)         (tickScale::usToTicks(_us))
+#define ticksToUs(_ticks)      (tickScale::ticksToUs(_ticks))
 #define myServo                this->servoIndex
 #define OUT_HIGH               65535            // Used to set / indicate the output at 5V
+#define SLEW_FRACTION_BITS     5                // SlewStep is a fixed point value with 5 fractional bits
+#define SLEW_ONE               (1 << SLEW_FRACTION_BITS)
+#define SLEW_FRAMES_PER_SECOND 50
+#define SYNC_PERIOD            ((int) (REFRESH_INTERVAL - SYNC_MARGIN) / SERVOS_PER_TIMER)
 
 
 //******************************************************************************************************
@@ -117,11 +169,99 @@ static uint8_t compareUnit2 = NO_CHANNEL;      // Point from the compare unit to
 //******************************************************************************************************
 static volatile uint8_t CurrentCompareUnit = 0;   // 0, 1 or 2. Used by the ISR to switch after 20/3 ms
 static uint8_t ServoCount = 0;                    // number of instatiated servo objects (0, 1, 2 or 3)
+static volatile uint8_t ReadyServos = 0;          // bit n is set by the ISR once servo n got its new pulse
+static volatile uint16_t Frames = 0;              // incremented by the ISR after each frame of 20 ms
+static volatile uint16_t Slots = 0;               // incremented by the ISR after each slot of 20/3 ms
+static uint16_t LatencyHistogram[LATENCY_BUCKETS];// see TCA_Stats/servoStats.h
 static boolean IsNotRunning = true;               // TCA is initialised as part of the 1st attach() call
+static uint8_t SyncEvctrl = 0;                    // EVCTRL value during slot 0, 0 if not synchronised (see syncFrames())
+static boolean Synced = false;                    // a restart by the sync event has been seen (see isSynced())
+static uint16_t SyncCount = 0;                    // counter and slots at the previous isSynced()
+static uint16_t SyncSlots = 0;                    // idem
+static uint8_t QuietSlots = 0;                    // consecutive slots in which no servo needed the ISR
+static volatile boolean Suspended = false;        // the ISR has switched its own interrupt off (see suspendISR())
+static boolean Following = false;                 // the ISR of TCA0 handles the slots (see followTCA0())
+
+// If tracing is switched on, the ISR records each pulse width that differs from the previous pulse
+// width of that servo. Identical pulses are not recorded, to avoid that the trace buffer gets filled
+// with pulses of servos that do not move.
+#if defined(SERVO_TRACE)
+static uint16_t TracedTicks[MAX_SERVOS];
+#define TRACE_PULSE(channel) \
+  if (ChannelTicks[channel] != TracedTicks[channel]) { \
+    TracedTicks[channel] = ChannelTicks[channel]; \
+    ServoTrace::add(Frames, channel + SERVOS_PER_TIMER, traceIsrPulse, TracedTicks[channel]); \
+  }
+#else
+#define TRACE_PULSE(channel)
+#endif
+
+
+// newPulse() is called by the ISR for the servo whose pulse starts in the next slot. If the main loop
+// did not yet react on the previous pulse of this servo, a frame was missed.
+static inline void newPulse(uint8_t channel) {
+  uint8_t bit = (1 << channel);
+  if (CommittedServos & bit) {                   // The latency is counted from the first missed pulse
+    if ((ActiveServos & bit) && (channels[channel].missedFrames != 0xFFFF)) channels[channel].missedFrames++;
+  }
+  else channels[channel].readySlot = Slots;
+  CommittedServos |= bit;
+  PendingServos &= ~bit;
+  channels[channel].pulseFrame = Frames;
+  ReadyServos |= bit;
+}
+
+
+// slewTicks() is called by the ISR once per frame for a servo that moves with a limited speed, just
+// before its pulse width is loaded. The step is a fixed point value, such that slow speeds add one
+// tick every few frames without any rounding error.
+static inline void slewTicks(uint8_t channel) {
+  uint16_t step = SlewFraction[channel] + SlewStep[channel];
+  SlewFraction[channel] = step & (SLEW_ONE - 1);
+  step >>= SLEW_FRACTION_BITS;
+  uint16_t ticks = ChannelTicks[channel];
+  uint16_t target = TargetTicks[channel];
+  if (ticks < target) ticks = (target - ticks > step) ? ticks + step : target;
+  else ticks = (ticks - target > step) ? ticks - step : target;
+  ChannelTicks[channel] = ticks;
+  if (ticks == target) SlewingServos &= ~(1 << channel);
+}
+
+static inline uint16_t nextTicks(uint8_t channel) {
+  if (SlewingServos & (1 << channel)) slewTicks(channel);
+  return ChannelTicks[channel];
+}
+
 
 // ******************************************************************************************************
 // Local (static) functions
 // ******************************************************************************************************
+// The latency is the time between the UPDATE that started the pulse of this servo, and now. It is
+// calculated from the number of slots since then, plus the current TCA count. If the overflow flag
+// is set while the count is still low, the ISR for the latest overflow has not run yet.
+// While TCA1 follows TCA0, the slots are counted by the ISR of TCA0, so its count is used instead.
+// While the ISR is suspended, Slots doesn't change and the overflow flag stays set, so the time since
+// the UPDATE is unknown; such write is not counted.
+static const uint16_t LatencyLimits[LATENCY_BUCKETS - 1] = {1000, 2000, 5000, 10000, 20000};
+
+static void countLatency(uint8_t channel) {
+  if (Suspended) return;
+  uint8_t oldSREG = SREG;
+  cli();
+  TCA_SINGLE_t &slotTimer = (Following) ? TCA0.SINGLE : _TIMER;
+  uint16_t count = slotTimer.CNT;
+  uint16_t slots = Slots - channels[channel].readySlot;
+  if ((slotTimer.INTFLAGS & TCA_SINGLE_OVF_bm) && (count < (slotTimer.PER >> 1))) slots++;
+  SREG = oldSREG;
+  uint32_t latency = (uint32_t)slots * ISR_PERIOD + ticksToUs(count);
+  if (latency > 0xFFFF) latency = 0xFFFF;
+  if (latency > channels[channel].maxLatency) channels[channel].maxLatency = latency;
+  uint8_t bucket = 0;
+  while ((bucket < LATENCY_BUCKETS - 1) && (latency >= LatencyLimits[bucket])) bucket++;
+  if (LatencyHistogram[bucket] != 0xFFFF) LatencyHistogram[bucket]++;
+}
+
+
 static void initTCA() {
   // STEP 1: Avoid that DxCore/Mightycore will configure TCA
   // The file included above tells if this is for TCA0 or TCA1
@@ -141,15 +281,36 @@ static void initTCA() {
 }
 
 static void finISR() {
+  if (Following) Servo1::followTCA0(FOLLOW_OFF);
+  uint8_t oldSREG = SREG;
+  cli();
+  // Without the ISR, the values in the Compare Units and their buffers would repeat in every slot.
+  // A running pulse completes; a pulse loaded for the next slot is dropped.
+  _TIMER.CMP0BUF = (_TIMER.CMP0 == OUT_HIGH) ? OUT_HIGH : 0;
+  _TIMER.CMP1BUF = (_TIMER.CMP1 == OUT_HIGH) ? OUT_HIGH : 0;
+  _TIMER.CMP2BUF = (_TIMER.CMP2 == OUT_HIGH) ? OUT_HIGH : 0;
   _TIMER.INTCTRL = 0;                    // Disable interrupt
+  SREG = oldSREG;
+  Suspended = false;                     // A later attach() should not switch it on again
   resumeTCA();                           // Give TCA back to DxCore / MegaTinyCore
 }
 
 static boolean isTimerActive() {         // returns true if any servo is active on this timer
-  for (uint8_t i = 0; i < SERVOS_PER_TIMER; i++) {
-    if (channels[i].isActive == true) return true;
+  return (ActiveServos != 0);
+}
+
+// resumeISR() switches the interrupt on again after suspendISR(). The OVF flag of the overflows that
+// passed meanwhile is cleared, so the ISR runs at the next slot boundary, and not halfway a slot.
+static void resumeISR() {
+  uint8_t oldSREG = SREG;
+  cli();
+  QuietSlots = 0;
+  if (Suspended) {
+    Suspended = false;
+    _TIMER.INTFLAGS = TCA_SINGLE_OVF_bm;
+    _TIMER.INTCTRL = TCA_SINGLE_OVF_bm;
   }
-  return false;
+  SREG = oldSREG;
 }
 
 //******************************************************************************************************
@@ -163,7 +324,7 @@ static boolean isTimerActive() {         // returns true if any servo is active
 Servo1::Servo1() {
   if (ServoCount < MAX_SERVOS) {
     myServo = ServoCount++;                                   // assign a channel index to this instance
-    channels[myServo].ticks = usToTicks(DEFAULT_PULSE_WIDTH); // start with the default value
+    ChannelTicks[myServo] = usToTicks(DEFAULT_PULSE_WIDTH);   // start with the default value
     this->min = 0;                                            // delta from MIN_PULSE_WIDTH
     this->max = 0;                                            // delta from MAX_PULSE_WIDTH
   } else {
@@ -176,8 +337,8 @@ Servo1::Servo1() {
 // attach sets te desired pin as output, and configures the multiplexer.
 // If a certain pin can not be used for compare unit output, attach returns with INVALID_SERVO (255)
 //******************************************************************************************************
-uint8_t Servo1::attach(byte pin, int min, int max) {
-  // Overwrite the minimum and maximum values for this servo, and call attach()
+void Servo1::setLimits(int min, int max) {
+  // Overwrite the minimum and maximum values for this servo
   // this->min and this->max are 4us delta values, ranging from -128 .. 127 (int8_t)
   // resolution of min/max is thus 4 uS
   // If an int8_t overflow would occur, store the possible min/max value 
@@ -194,6 +355,11 @@ uint8_t Servo1::attach(byte pin, int min, int max) {
     else this->max = -127;
     // this->max = (int8_t)((MAX_PULSE_WIDTH - 127) / 4);
   }
+}
+
+
+uint8_t Servo1::attach(byte pin, int min, int max) {
+  setLimits(min, max);
   return this->attach(pin);
 }
 
@@ -203,22 +369,40 @@ uint8_t Servo1::attach(byte pin) {
   if (IsNotRunning) {initTCA();}
   // Find the compare unit for this pin, and set the pin as output
   if (initCompareUnit(pin, myServo)) {
-    channels[myServo].isActive = true;
+    setServoBits(ActiveServos, 1 << myServo);
+    resumeISR();
     return myServo;
     }
   else return INVALID_SERVO;
 }
 
 
+// attach<pin>(): the compiler has checked the pin, and attach<pin>() writes PORTMUX and CTRLB itself
+// (see servo_TCA1.h). attachBegin() checks the port and stores the Compare Unit; attachEnd() then
+// activates the servo.
+bool Servo1::attachBegin(uint8_t port, uint8_t compareUnit) {
+  if (myServo == INVALID_SERVO) {return false;}
+  if (IsNotRunning) {initTCA();}
+  return claimCompareUnit(port, compareUnit, myServo);
+}
+
+
+uint8_t Servo1::attachEnd() {
+  setServoBits(ActiveServos, 1 << myServo);
+  resumeISR();
+  return myServo;
+}
+
+
 //******************************************************************************************************
 // The following four read and write methods are identical to other, existing, servo libraries
 //******************************************************************************************************
-void Servo1::write(unsigned int value) {
+void Servo1::write(uint16_t value) {
   // treat values less than MIN_PULSE_WIDTH as angles in degrees
   // treat values above MIN_PULSE_WIDTH as microseconds
   if (value < MIN_PULSE_WIDTH) {
     if (value > 180) {value = 180;}
-    value = map(value, 0, 180, SERVO_MIN(), SERVO_MAX());
+    value = angleToUs(value, SERVO_MIN(), SERVO_MAX());
   }
   writeMicroseconds(value);
 }
@@ -229,9 +413,83 @@ void Servo1::writeMicroseconds(uint16_t value) {
   if (myServo != INVALID_SERVO) {   
     if (value < (uint16_t) SERVO_MIN()) value = SERVO_MIN();
     else if (value > (uint16_t) SERVO_MAX()) value = SERVO_MAX();
-    channels[myServo].ticks = usToTicks(value);
-    channels[myServo].CMPisSet = false;           // Flag for the main program
+    uint16_t ticks;
+    calibrated_t *calibrated = (calibrations) ? calibrations + myServo : 0;
+    if (calibrated && calibrated->table) {
+      calibrated->requested = value;              // returned by readMicroseconds()
+      ticks = calibrated->table->toTicks(value);
+    }
+    else ticks = usToTicks(value);
+    uint8_t bit = (1 << myServo);
+    uint8_t active = ActiveServos & bit;
+    if (active && (CommittedServos & bit)) countLatency(myServo);
+    uint8_t oldSREG = SREG;                       // ticks and all flags change together
+    cli();
+    uint16_t current = ChannelTicks[myServo];
+    uint16_t previous = (SlewingServos & bit) ? TargetTicks[myServo] : current;
+    if (active && (PendingServos & bit) && (ticks != previous)
+        && (channels[myServo].overwrittenValues != 0xFFFF)) {
+      channels[myServo].overwrittenValues++;      // The previous value never reached the servo
+    }
+    // With a slew rate limit the ISR moves towards the new value, unless there is no position to
+    // start from: the servo is not attached yet, or its output is constant
+    if (active && SlewStep[myServo] && (current != 0) && (current != OUT_HIGH)) {
+      TargetTicks[myServo] = ticks;
+      if (ticks != current) SlewingServos |= bit;
+      else SlewingServos &= ~bit;
+    }
+    else {
+      ChannelTicks[myServo] = ticks;
+      SlewingServos &= ~bit;
+    }
+    PendingServos |= bit;
+    CommittedServos &= ~bit;                      // Flag for the main program
+    ConstantServos &= ~bit;
+    SREG = oldSREG;
+    resumeISR();
+  }
+}
+
+
+//******************************************************************************************************
+// Slew rate limited writes. The speed is in us per second, and is converted once into a step per
+// frame (in ticks); the ISR takes these steps, so the main loop has nothing to do while the servo
+// moves, and the movement keeps its speed if the main loop is late.
+//******************************************************************************************************
+void Servo1::writeMicroseconds(uint16_t value, uint16_t speed) {
+  setMaxSlew(speed);
+  writeMicroseconds(value);
+}
+
+
+void Servo1::setMaxSlew(uint16_t speed) {
+  if (myServo == INVALID_SERVO) return;
+  if (speed > MAX_SLEW_SPEED) speed = MAX_SLEW_SPEED;
+  uint16_t step = ((uint32_t)usToTicks(speed) * SLEW_ONE + SLEW_FRAMES_PER_SECOND / 2) / SLEW_FRAMES_PER_SECOND;
+  if ((speed > 0) && (step == 0)) step = 1;       // The slowest possible speed
+  uint8_t oldSREG = SREG;
+  cli();
+  SlewStep[myServo] = step;
+  if ((step == 0) && (SlewingServos & (1 << myServo))) {
+    ChannelTicks[myServo] = TargetTicks[myServo]; // No limit: finish the running movement at once
+    SlewingServos &= ~(1 << myServo);
   }
+  SREG = oldSREG;
+}
+
+
+bool Servo1::isMoving() {
+  if (myServo == INVALID_SERVO) return false;
+  return (SlewingServos & (1 << myServo));
+}
+
+
+void Servo1::setCalibration(ServoCalibration *calibration) {
+  if (myServo == INVALID_SERVO) return;
+  uint16_t requested = readMicroseconds();       // Before the table changes
+  calibrations = calibrationStorage;
+  calibrations[myServo].table = calibration;
+  calibrations[myServo].requested = requested;
 }
 
 
@@ -242,7 +500,16 @@ int Servo1::read() { // return the value as degrees
 
 uint16_t Servo1::readMicroseconds(){
   uint16_t pulsewidth;
-  if (myServo != INVALID_SERVO) {pulsewidth = ticksToUs(channels[myServo].ticks);} 
+  if (myServo != INVALID_SERVO) {
+    uint8_t oldSREG = SREG;                        // The ISR changes ticks while slewing
+    cli();
+    uint16_t ticks = ChannelTicks[myServo];
+    SREG = oldSREG;
+    if (calibrations && calibrations[myServo].table && (ticks != 0) && (ticks != OUT_HIGH)) {
+      pulsewidth = calibrations[myServo].requested;  // the value as written, not the calibrated width
+    }
+    else pulsewidth = ticksToUs(ticks);
+  } 
     else {pulsewidth  = 0;}
   return pulsewidth;
 }
@@ -254,15 +521,17 @@ uint16_t Servo1::readMicroseconds(){
 // Stopping TCA doesn't make much sense in the case of AVR timers, since there is no easy way to take
 // back the timer via something opposite to "TakeOverTCA".
 // Detach is therefore of little use. To stop output pulses, a better way is to call constantOutput().
+// Once the last servo of the timer is detached, the pulses stop as well: the Compare Units are cleared
+// before the interrupt is switched off (a constant high level is kept).
 //******************************************************************************************************
 void Servo1::detach() {
-  channels[myServo].isActive = false;
+  clearServoBits(ActiveServos, 1 << myServo);
   if (isTimerActive() == false) {finISR();}
 }
 
 
 bool Servo1::attached() {
-  return channels[myServo].isActive;
+  return (ActiveServos & (1 << myServo));
 }
 
 
@@ -278,12 +547,124 @@ bool Servo1::attached() {
 bool Servo1::acceptsNewValue() {
   bool ready = false;
   uint8_t index = myServo;
-  if ((index != INVALID_SERVO)) {ready = channels[index].CMPisSet;}  
+  if ((index != INVALID_SERVO)) {ready = (CommittedServos & (1 << index));}  
   return ready;
 }
 
 void Servo1::waitTillNextPulse() {
-  channels[myServo].CMPisSet = false;               // Flag cleared by the main program 
+  uint8_t bit = (1 << myServo);
+  if ((CommittedServos & bit) && (ActiveServos & bit)) countLatency(myServo);
+  clearServoBits(CommittedServos, bit);             // Flag cleared by the main program 
+}
+
+
+uint8_t Servo1::getServoIndex() {
+  return myServo;
+}
+
+
+// readyServos() returns the bits of mask that the ISR has set, and clears only these; other callers
+// (a second group, for instance) keep their bits. The read and clear must be atomic, to avoid that a
+// bit set by the ISR in between gets lost.
+uint8_t Servo1::readyServos(uint8_t mask) {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint8_t ready = ReadyServos & mask;
+  ReadyServos &= ~mask;
+  SREG = oldSREG;
+  return ready;
+}
+
+
+// The frame counter is 16 bit, so it must be read with interrupts disabled.
+uint16_t Servo1::getFrame() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t frame = Frames;
+  SREG = oldSREG;
+  return frame;
+}
+
+// The ISR has already switched CurrentCompareUnit to the slot after the running one. A single byte
+// is read, so interrupts need not be disabled.
+uint8_t Servo1::getSlotServo(uint8_t ahead) {
+  uint8_t unit = CurrentCompareUnit;
+  if (Following && (_TIMER.INTFLAGS & TCA_SINGLE_OVF_bm)) ahead++;   // The UPDATE after followSlotTCA1() has passed
+  if (ahead == 0) unit = (unit == 0) ? 2 : unit - 1;
+  else if (ahead == 2) unit = (unit == 2) ? 0 : unit + 1;
+  switch (unit) {
+    case 0: return compareUnit0;
+    case 1: return compareUnit1;
+    default: return compareUnit2;
+  }
+}
+
+// pinIsFree() only reads the usedPort and compareUnitN variables, which the ISR doesn't change
+bool Servo1::canAttach(uint8_t pin) {
+  return pinIsFree(pin);
+}
+
+uint16_t Servo1::getPulseFrame() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t frame = channels[myServo].pulseFrame;
+  SREG = oldSREG;
+  return frame;
+}
+
+
+//******************************************************************************************************
+// Statistics. missedFrames is maintained by the ISR, so all counters are read and reset with
+// interrupts disabled.
+//******************************************************************************************************
+void Servo1::getStats(servoStats_t &stats) {
+  uint8_t oldSREG = SREG;
+  cli();
+  stats.missedFrames = channels[myServo].missedFrames;
+  stats.overwrittenValues = channels[myServo].overwrittenValues;
+  stats.maxLatency = channels[myServo].maxLatency;
+  SREG = oldSREG;
+}
+
+void Servo1::resetStats() {
+  uint8_t oldSREG = SREG;
+  cli();
+  channels[myServo].missedFrames = 0;
+  channels[myServo].overwrittenValues = 0;
+  channels[myServo].maxLatency = 0;
+  SREG = oldSREG;
+}
+
+// The totals over all servos of this timer; maxLatency is the maximum of all servos.
+void Servo1::getTimerStats(servoStats_t &stats) {
+  stats.missedFrames = 0;
+  stats.overwrittenValues = 0;
+  stats.maxLatency = 0;
+  uint8_t oldSREG = SREG;
+  cli();
+  for (uint8_t i = 0; i < MAX_SERVOS; i++) {
+    stats.missedFrames += channels[i].missedFrames;
+    stats.overwrittenValues += channels[i].overwrittenValues;
+    if (channels[i].maxLatency > stats.maxLatency) stats.maxLatency = channels[i].maxLatency;
+  }
+  SREG = oldSREG;
+}
+
+uint16_t Servo1::getLatencyCount(uint8_t bucket) {
+  if (bucket >= LATENCY_BUCKETS) return 0;
+  return LatencyHistogram[bucket];
+}
+
+void Servo1::resetTimerStats() {
+  uint8_t oldSREG = SREG;
+  cli();
+  for (uint8_t i = 0; i < MAX_SERVOS; i++) {
+    channels[i].missedFrames = 0;
+    channels[i].overwrittenValues = 0;
+    channels[i].maxLatency = 0;
+  }
+  for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) LatencyHistogram[i] = 0;
+  SREG = oldSREG;
 }
 
 
@@ -298,45 +679,226 @@ void Servo1::waitTillNextPulse() {
 // detach() method. However, after a detach(), a new attach() would be required.
 //******************************************************************************************************
 void Servo1::constantOutput(uint8_t on_off) {
-  if (on_off == 0) {channels[myServo].ticks = 0;}
-  else {channels[myServo].ticks = OUT_HIGH;}        // This value ensures a continuous high output
-  channels[myServo].CMPisSet = false;               // Flag for the compare buffer 
+  uint8_t oldSREG = SREG;
+  cli();
+  if (on_off == 0) {ChannelTicks[myServo] = 0;}
+  else {ChannelTicks[myServo] = OUT_HIGH;}          // This value ensures a continuous high output
+  CommittedServos &= ~(1 << myServo);               // Flag for the compare buffer 
+  SlewingServos &= ~(1 << myServo);                 // A running slew would overwrite the constant output
+  ConstantServos |= (1 << myServo);
+  SREG = oldSREG;
+  resumeISR();
+}
+
+
+//******************************************************************************************************
+// The ISR is only needed to switch the Compare Units between the slots. Once all attached servos
+// output a constant level (see constantOutput()), the Compare Units keep that level without the ISR,
+// so the ISR switches its own interrupt off (suspendISR()) after SERVOS_PER_TIMER + 1 quiet slots;
+// by then every Compare Unit has copied its constant value from the buffer. The timer keeps running,
+// so the slot boundaries don't move. A write(), writeMicroseconds(), constantOutput() or attach()
+// switches the interrupt on again (resumeISR()); the new value is loaded by the ISR, thus into the
+// buffer, and reaches the output at a slot boundary.
+// While the ISR is suspended, the frame counters stop: acceptsNewValue(), readyServos(), getFrame()
+// and getPulseFrame() don't change. needFrames(true) tells that the main loop relies on these for
+// this servo, also while its output is constant; the ISR then keeps running. ServoMoba uses it for
+// everything that counts frames, such as the power steps after a movement.
+// The ISR is not suspended while the frames are synchronised (see syncFrames()).
+//******************************************************************************************************
+void Servo1::needFrames(bool need) {
+  if (myServo == INVALID_SERVO) return;
+  if (need) {
+    setServoBits(FrameServos, 1 << myServo);
+    resumeISR();
+  }
+  else clearServoBits(FrameServos, 1 << myServo);
+}
+
+
+bool Servo1::isSuspended() {
+  return Suspended;
+}
+
+
+static inline void suspendISR() {
+  if ((ActiveServos & (~ConstantServos | PendingServos | FrameServos)) || SyncEvctrl) QuietSlots = 0;
+  else if (++QuietSlots > SERVOS_PER_TIMER) {          // All Compare Units hold their constant level
+    _TIMER.INTCTRL = 0;
+    Suspended = true;
+  }
+}
+
+
+//******************************************************************************************************
+// syncFrames() locks the frames of this timer to an external event, such as the sync pulse of a camera
+// or the frames of another controller. The event must arrive every REFRESH_INTERVAL (about 20 ms).
+// The slots are shortened to SYNC_PERIOD, such that three slots take SYNC_MARGIN less than a frame.
+// The sync event restarts the counter (EVACTB = RESTART_POSEDGE), which stretches slot 0 by the time
+// that had passed since its start. Once locked, the event thus arrives SYNC_MARGIN after the start of
+// slot 0, when its pulse is long over, and slot 0 becomes SYNC_MARGIN longer than the other slots.
+// The ISR enables the event input at the start of slot 0 and disables it at the start of slot 1.
+// An event that arrives in slot 1 or 2 is therefore ignored: without events the frames are three
+// slots long (about 16 ms), and the position of the event within the frame moves by SYNC_MARGIN per
+// frame, until it arrives in slot 0 again.
+// A restart doesn't cause an UPDATE, so no ISR is called, and the Compare Units are not reloaded.
+// syncFrames() only arms the event input and returns; isSynced() tells if the timer has locked.
+// It compares the counter with that of the previous call: a counter that goes back without an
+// overflow has been restarted. A restart is thus only seen if two calls fall in the same slot, so
+// isSynced() should be called often (every loop(), or every 50 us while waiting). It doesn't wait,
+// so it also works with interrupts disabled. An event that arrives during the pulse of slot 0 (while
+// locking) lengthens that pulse, so syncFrames() should be called before attach().
+// syncFrames(SYNC_OFF) switches the synchronisation off.
+//******************************************************************************************************
+bool Servo1::syncFrames(uint8_t eventChannel) {
+#if defined(TCA_SINGLE_EVACTB_RESTART_POSEDGE_gc)
+  if (Following) return false;                      // The slots are those of TCA0
+  if (IsNotRunning) {initTCA();}
+  uint8_t oldSREG = SREG;
+  cli();
+  SyncEvctrl = 0;
+  Synced = false;
+  _TIMER.EVCTRL = 0;
+  SyncUser = 0;                                     // EVSYS_USER_OFF_gc
+  SREG = oldSREG;
+  if (eventChannel == SYNC_OFF) {
+    _TIMER.PERBUF = usToTicks(ISR_PERIOD);
+    return false;
+  }
+  SyncUser = eventChannel + 1;                      // EVSYS_USER_CHANNELn_gc
+  _TIMER.PERBUF = usToTicks(SYNC_PERIOD);
+  SyncEvctrl = TCA_SINGLE_CNTBEI_bm | TCA_SINGLE_EVACTB_RESTART_POSEDGE_gc;
+  SyncCount = 0;                                    // The first isSynced() can't see a restart
+  resumeISR();                                      // The ISR switches the event input
+  return true;
+#endif
+  return false;
+}
+
+
+bool Servo1::isSynced() {
+  if (!SyncEvctrl) return false;
+  if (Synced) return true;
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t count = _TIMER.CNT;
+  uint16_t slots = Slots;
+  bool overflow = (_TIMER.INTFLAGS & TCA_SINGLE_OVF_bm);
+  SREG = oldSREG;
+  if ((slots == SyncSlots) && !overflow && (count < SyncCount)) Synced = true;
+  SyncCount = count;
+  SyncSlots = slots;
+  return Synced;
 }
 
 
 //******************************************************************************************************
 // The interrupt service routine is called every 20/3 ms. It's job is to activate the compare unit
 // that belongs to the current servo and silence the two other compare units (by setting CMPBUF = 0)
+// While TCA1 follows TCA0, the ISR of TCA0 does the same via followSlotTCA1().
 //******************************************************************************************************
-ISR(ServoHandler) {
-  // An Update has just past, and triggered the execution of this ISR. This occurs every 20/3 ms
-  _TIMER.INTFLAGS = TCA_SINGLE_OVF_bm;                 // The interrupt flag has to be cleared manually
+static inline void nextSlot() {
+  Slots++;                                             // Before newPulse(), which stores the current slot
   // With each ISR invocation we configure the next Compare Unit. 
   switch (CurrentCompareUnit) { 
     case 0:                                            // Handle Compare Unit 0
+      if (SyncEvctrl) _TIMER.EVCTRL = SyncEvctrl;      // Slot 0 has started: accept the sync event
       if (_TIMER.CMP0 != OUT_HIGH) _TIMER.CMP0BUF = 0; // We nust test the entire 16 bit register (testing only CMPH doesn't work)
-      if ((compareUnit1 != NO_CHANNEL) && (channels[compareUnit1].isActive)) {_TIMER.CMP1BUF = channels[compareUnit1].ticks;}
+      if ((compareUnit1 != NO_CHANNEL) && (ActiveServos & (1 << compareUnit1))) {_TIMER.CMP1BUF = nextTicks(compareUnit1); TRACE_PULSE(compareUnit1);}
       if (_TIMER.CMP2 != OUT_HIGH) _TIMER.CMP2BUF = 0;      
-      channels[compareUnit1].CMPisSet = true;
+      if (compareUnit1 != NO_CHANNEL) newPulse(compareUnit1);
     break;
     case 1: 
+      if (SyncEvctrl) _TIMER.EVCTRL = 0;               // Slot 1 has started: ignore the sync event
       if (_TIMER.CMP0 != OUT_HIGH) _TIMER.CMP0BUF = 0;
       if (_TIMER.CMP1 != OUT_HIGH) _TIMER.CMP1BUF = 0;
-      if ((compareUnit2 != NO_CHANNEL) && (channels[compareUnit2].isActive)) {_TIMER.CMP2BUF = channels[compareUnit2].ticks;}
-      channels[compareUnit2].CMPisSet = true;
+      if ((compareUnit2 != NO_CHANNEL) && (ActiveServos & (1 << compareUnit2))) {_TIMER.CMP2BUF = nextTicks(compareUnit2); TRACE_PULSE(compareUnit2);}
+      if (compareUnit2 != NO_CHANNEL) newPulse(compareUnit2);
     break;
     case 2:
-      if ((compareUnit0 != NO_CHANNEL) && (channels[compareUnit0].isActive)) {_TIMER.CMP0BUF = channels[compareUnit0].ticks;}
+      if ((compareUnit0 != NO_CHANNEL) && (ActiveServos & (1 << compareUnit0))) {_TIMER.CMP0BUF = nextTicks(compareUnit0); TRACE_PULSE(compareUnit0);}
       if (_TIMER.CMP1 != OUT_HIGH) _TIMER.CMP1BUF = 0;      
       if (_TIMER.CMP2 != OUT_HIGH) _TIMER.CMP2BUF = 0;      
-      channels[compareUnit0].CMPisSet = true;
+      if (compareUnit0 != NO_CHANNEL) newPulse(compareUnit0);
     break;
   }  
   switch (CurrentCompareUnit) {                     // A switch statement is much faster than a Modulo 3 statement
     case 0: CurrentCompareUnit = 1; break;
     case 1: CurrentCompareUnit = 2; break;
-    case 2: CurrentCompareUnit = 0; break;  
+    case 2: CurrentCompareUnit = 0; Frames++; break;  
+  }
+}
+
+ISR(ServoHandler) {
+  // An Update has just past, and triggered the execution of this ISR. This occurs every 20/3 ms
+  _TIMER.INTFLAGS = TCA_SINGLE_OVF_bm;                 // The interrupt flag has to be cleared manually
+  nextSlot();
+  suspendISR();
+}
+
+
+//******************************************************************************************************
+// followTCA0() runs TCA1 in step with TCA0, such that one ISR handles the slots of both timers. Both
+// timers run from the same clock, with the same prescaler and period, so once their counters have
+// been set they keep their distance: TCA1 is set offset us behind TCA0, with both timers stopped for
+// a moment. The interrupt of TCA1 is switched off, and the ISR of TCA0 calls followSlotTCA1() after
+// it has handled its own slot (see Servo::setFollower()). followSlotTCA1() writes the buffers of TCA1,
+// which are loaded at the next UPDATE of TCA1, offset us after that of TCA0. Compare Unit n of TCA1
+// thus starts its pulse offset us after Compare Unit n of TCA0, and the ISR must have written the
+// buffers before then; that is why the offset is at least FOLLOW_MIN_OFFSET.
+// The overflow flag of TCA1 is cleared by followSlotTCA1(), so a set flag tells that the slot
+// written by followSlotTCA1() has started (see getSlotServo() and countLatency()).
+// Changing the counter disturbs the pulse that TCA1 outputs at that moment, so followTCA0() should
+// be called before attach(), or while the servos of TCA1 output a constant level.
+// followTCA0(FOLLOW_OFF) gives TCA1 its own interrupt again; the slots keep their position.
+//******************************************************************************************************
+// followSlotTCA1() is called by the ISR of TCA0, and therefore has external linkage.
+void followSlotTCA1(uint8_t unit) {                    // unit: its slot has just started on TCA0
+  _TIMER.INTFLAGS = TCA_SINGLE_OVF_bm;
+  CurrentCompareUnit = (unit == 0) ? 2 : unit - 1;     // nextSlot() then prepares unit
+  nextSlot();
+}
+
+
+bool Servo1::followTCA0(uint16_t offset) {
+  uint8_t oldSREG = SREG;
+  if (offset == FOLLOW_OFF) {
+    cli();
+    if (Following) {
+      Following = false;
+      Servo::setFollower(false);
+      if (_TIMER.INTFLAGS & TCA_SINGLE_OVF_bm) {       // An UPDATE after followSlotTCA1(): its ISR is due
+        _TIMER.INTFLAGS = TCA_SINGLE_OVF_bm;
+        nextSlot();
+      }
+      _TIMER.INTCTRL = TCA_SINGLE_OVF_bm;
+    }
+    SREG = oldSREG;
+    return false;
+  }
+  if (offset < FOLLOW_MIN_OFFSET) offset = FOLLOW_MIN_OFFSET;
+  if (offset > ISR_PERIOD - FOLLOW_MIN_OFFSET) offset = ISR_PERIOD - FOLLOW_MIN_OFFSET;
+  if (IsNotRunning) {initTCA();}
+  if (SyncEvctrl) syncFrames(SYNC_OFF);
+  cli();
+  if (!Servo::setFollower(true)) {                     // TCA0 doesn't run, or is synchronised
+    SREG = oldSREG;
+    return false;
   }
+  Following = true;
+  _TIMER.INTCTRL = 0;
+  Suspended = false;
+  QuietSlots = 0;
+  TCA0.SINGLE.CTRLA &= ~TCA_SINGLE_ENABLE_bm;
+  _TIMER.CTRLA &= ~TCA_SINGLE_ENABLE_bm;
+  uint16_t ticks = usToTicks(offset);
+  uint16_t count = TCA0.SINGLE.CNT;
+  _TIMER.PER = TCA0.SINGLE.PER;
+  _TIMER.CNT = (count >= ticks) ? count - ticks : count + TCA0.SINGLE.PER + 1 - ticks;
+  _TIMER.INTFLAGS = TCA_SINGLE_OVF_bm;
+  _TIMER.CTRLA |= TCA_SINGLE_ENABLE_bm;
+  TCA0.SINGLE.CTRLA |= TCA_SINGLE_ENABLE_bm;
+  SREG = oldSREG;
+  return true;
 }
 
 
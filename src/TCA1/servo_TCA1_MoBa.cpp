@@ -13,86 +13,243 @@
 #include <EEPROM.h>
 #include "../Servo_TCA1_MoBa.h"
 #include "../TCA_MobaCurves/curves.h"
+#include "../TCA_MobaPower/power.h"
+#include "../TCA_MobaConfig/config.h"
+#include "../TCA_MobaJournal/journal.h"
+#include "../TCA_Trace/trace.h"
+#include "../TCA_MobaFeedback/feedback.h"
+
+#if defined(SERVO_TRACE)
+  #define TRACE(event, value) ServoTrace::add(getFrame(), getServoIndex() + SERVOS_PER_TIMER, event, value)
+#else
+  #define TRACE(event, value)
+#endif
+
+
+//******************************************************************************************************
+// Storage per servoIndex for the optional features, outside the servo objects. Each array is only
+// referenced by the method(s) that switch the feature on, which set the pointer next to it; all other
+// methods use that pointer. If a feature is not used, its array is not linked and takes no RAM.
+// - queues: set by queueMove(). Since queueMove() may be called from an ISR, the pointer is read
+//   and set with interrupts disabled.
+// - journals: set by initJournal()
+// - feedbacks: set by initFeedback(), setSettle() and setStall()
+//******************************************************************************************************
+static MoveQueue queueStorage[SERVOS_PER_TIMER];
+static MoveQueue *queues = 0;
+static PositionJournal journalStorage[SERVOS_PER_TIMER];
+static PositionJournal *journals = 0;
+static servoFeedback_t feedbackStorage[SERVOS_PER_TIMER];
+static servoFeedback_t *feedbacks = 0;
+
+static MoveQueue *queueOf(uint8_t servo) {
+  if (servo >= SERVOS_PER_TIMER) return 0;
+  uint8_t oldSREG = SREG;
+  cli();
+  MoveQueue *queue = queues;
+  SREG = oldSREG;
+  return (queue) ? queue + servo : 0;
+}
+
+static PositionJournal *journalOf(uint8_t servo) {
+  if ((journals == 0) || (servo >= SERVOS_PER_TIMER)) return 0;
+  return journals + servo;
+}
+
+static servoFeedback_t *feedbackOf(uint8_t servo) {
+  if ((feedbacks == 0) || (servo >= SERVOS_PER_TIMER)) return 0;
+  return feedbacks + servo;
+}
+
+static servoFeedback_t *useFeedback(uint8_t servo) {
+  feedbacks = feedbackStorage;
+  return feedbackOf(servo);
+}
+
+// Frames in which checkServo() was not called, still to be skipped by the state methods. checkServo()
+// sets it for the servo it handles, so a single variable serves all servos of this timer.
+static uint8_t framesLate;
 
-#define IDLE_ON    digitalWriteFast(PIN_PD4,1); digitalWriteFast(PIN_PD5,0); digitalWriteFast(PIN_PD6,0); digitalWriteFast(PIN_PD7,0);
-#define START_ON   digitalWriteFast(PIN_PD4,0); digitalWriteFast(PIN_PD5,1); digitalWriteFast(PIN_PD6,0); digitalWriteFast(PIN_PD7,0);
-#define MOVING_ON  digitalWriteFast(PIN_PD4,0); digitalWriteFast(PIN_PD5,0); digitalWriteFast(PIN_PD6,1); digitalWriteFast(PIN_PD7,0);
-#define FINISH_ON  digitalWriteFast(PIN_PD4,0); digitalWriteFast(PIN_PD5,0); digitalWriteFast(PIN_PD6,0); digitalWriteFast(PIN_PD7,1);
 
 //******************************************************************************************************
-// moveServoAlongCurve() moves the servo along the curve that has been stored in the myCurve array.
+// moveServoAlongCurve() moves the servo along the curve that has been loaded before.
 // It has one parameter: direction.
 // 
-// Before the first servo movement, or of we want to change to a different curve, we have to fill the 
-// myCurve array, and set the timeStretch factor. The myCurve array can be filled from EEPROM,
-// or from PROGMEM / RAM.
+// Before the first servo movement, or of we want to change to a different curve, we have to load 
+// the curve, and set the timeStretch factor. The curve can be loaded from EEPROM, or from 
+// PROGMEM / RAM.
 //
-// To fill from EEPROM, we have to call initCurveFromEEPROM(). That call has two parameters:
+// To load from EEPROM, we have to call initCurveFromEEPROM(). That call has two parameters:
 // - the EEPROM address of the first curve point
 // - the timeStretch factor.
 // 
-// To fill from PROGMEM / RAM, we have to call initCurveFromPROGMEM(). That call has two parameters:
+// To load from PROGMEM / RAM, we have to call initCurveFromPROGMEM(). That call has two parameters:
 // - the index to identify the curve. The predefined curves can be found in curves.cpp
+// For a curve of the sketch itself (see curveGenerator.h), initCurveFromTable() should be called.
 // - the timeStretch factor.
+//
+// Curves are not copied into the object: the servo reads the points where they are stored, so 
+// servos that use the same curve share it. Only a curve in RAM is copied (see initCurveFromRAM()).
+//
+// An optional second parameter of moveServoAlongCurve() delays the start of the movement by a 
+// number of 20 ms steps.
 //******************************************************************************************************
 void ServoMoba1::moveServoAlongCurve(uint8_t direction) {
-  servoDirection = direction;
-  if (powerOnBeforeMoving >= pulseOnBeforeMoving) {
-    countServo = powerOnBeforeMoving;
-    countPulse = powerOnBeforeMoving - pulseOnBeforeMoving;
-    countPower = 0;
-  }
-  else {
-    countServo = pulseOnBeforeMoving;
-    countPulse = 0;
-    countPower = pulseOnBeforeMoving - powerOnBeforeMoving;
-  };
+  moveServoAlongCurve(direction, 0);
+};
+
+
+void ServoMoba1::moveServoAlongCurve(uint8_t direction, uint8_t delay) {
+  // The start state lasts as long as the longest of powerOnBeforeMoving and pulseOnBeforeMoving,
+  // plus the (optional) delay. The pulse and power counters count down to their own moment within
+  // that period. Note that the total is limited to 255 steps.
+  uint8_t lead = getStartDuration();
+  if (delay > (255 - lead)) countServo = 255;
+    else countServo = lead + delay;
+  const servoConfig_t &settings = ServoConfig::get(config);
+  countPulse = countServo - settings.pulseOnBeforeMoving;
+  countPower = countServo - settings.powerOnBeforeMoving;
+  servoDirection = (direction != 0);
   ticks = 0;
   index = 0;
   servoState = start;
   movementCompleted = false;
+  needFrames(true);                            // The ISR may have been suspended while idle
+  lastPulseFrame = getPulseFrame();
+  framesLate = 0;
+  servoFeedback_t *state = feedbackOf(getServoIndex());
+  if (state) state->stallCount = 0;
+  if (stalled) {                               // stopStalled() has cut the power
+    stalled = false;
+    if (!idlePowerIsOff) powerOn();
+  }
+  TRACE(traceMove, direction);
   servoStart();
+  waitTillNextPulse();                         // servoStart() was this frame's action
 };
 
 
+//******************************************************************************************************
+// queueMove() stores a movement in the queue; it will be executed once the servo has become idle.
+// Different from moveServoAlongCurve(), a movement that is running will thus not be interrupted.
+// queueMove() may be called from an interrupt service routine. The parameters are:
+// - the index of the curve (see curves.cpp and SKETCH_CURVES()), or KEEP_CURVE for the loaded curve
+// - the direction (see moveServoAlongCurve()) 
+// - the timeStretch factor (ignored in case of KEEP_CURVE)
+// - the dwell time: number of 20 ms steps to wait before the movement starts
+// Returns false if the queue is full, in which case the movement is ignored.
+//******************************************************************************************************
+bool ServoMoba1::queueMove(uint8_t curveNumber, uint8_t direction, uint8_t stretch, uint8_t dwell) {
+  uint8_t servo = getServoIndex();
+  if (servo >= SERVOS_PER_TIMER) return false;
+  uint8_t oldSREG = SREG;
+  cli();
+  queues = queueStorage;
+  SREG = oldSREG;
+  if (!queueStorage[servo].push(curveNumber, direction, stretch, dwell)) return false;
+  needFrames(true);                            // servoIdle() pops it in the next frame
+  return true;
+}
+
+uint8_t ServoMoba1::movesQueued() {
+  MoveQueue *queue = queueOf(getServoIndex());
+  return (queue) ? queue->count() : 0;
+}
+
+void ServoMoba1::clearQueue() {
+  MoveQueue *queue = queueOf(getServoIndex());
+  if (queue) queue->clear();
+}
+
+
+//******************************************************************************************************
+// Loading a curve. EEPROM is read directly (on the processors supported by this library EEPROM is 
+// mapped in the data space, so EEPROM.read() is as fast as a RAM access), at every curve step. A change
+// of the EEPROM thus affects a running movement from the next frame on. lastPoint and curveEnd are
+// determined here, so if the number of points or the last time changes, initCurveFromEEPROM() should
+// be called again. A curve without end marker ends after SIZE_SERVO_CURVE - 1 points.
+//******************************************************************************************************
 void ServoMoba1::initCurveFromEEPROM(uint8_t curveNumber, uint8_t stretch, int adresEeprom) {
-  if (stretch > 0) timeStretch = stretch;
-    else timeStretch = 1;
-  uint8_t i = 0;                                 // index into the myCurve array
-  bool ready = false;
+  curveSource = inEeprom;
+  curveEeprom = adresEeprom;
+  initCurve(stretch);
+  previousCurve = curveNumber;
+}
+
+void ServoMoba1::initCurveFromPROGMEM(uint8_t curveNumber, uint8_t stretch) {
+  const curvePoint_t *table = curveByIndex(curveNumber & 0b00111111);   // Predefined or sketch curve
+  if (table) {
+    initCurveFromTable(table, stretch);
+    previousCurve = curveNumber;
+  }
+}
+
+
+void ServoMoba1::initCurveFromTable(const curvePoint_t *curve, uint8_t stretch) {
+  curveSource = inFlash;
+  this->curve = curve;
+  initCurve(stretch);
+  previousCurve = USER_CURVE;
+}
+
+
+// A curve in RAM, such as the receive buffer of ServoProtocol, may be overwritten after this call. 
+// It is therefore copied, into storage per servoIndex that only exists if this method is used.
+static curvePoint_t ramCurves[SERVOS_PER_TIMER][SIZE_SERVO_CURVE];
+
+void ServoMoba1::initCurveFromRAM(const curvePoint_t *curve, uint8_t stretch) {
+  uint8_t servo = getServoIndex();
+  if (servo >= SERVOS_PER_TIMER) return;
+  uint8_t i = 0;
   do {
-    myCurve[i].time = EEPROM.read(adresEeprom);
-    myCurve[i].position = EEPROM.read(adresEeprom + 1);
-    adresEeprom = adresEeprom + 2;
-    if ((i > 0) && (myCurve[i].time == 0)) ready = true;
-    if (i >= SIZE_SERVO_CURVE) ready = true; // protection against erronuous CV values 
+    ramCurves[servo][i] = curve[i];
     i++;
-  } while (!ready);                          // i is now 2 above the last curve element
-  firstCurvePosition = valueTo_us(myCurve[0].position);
-  lastCurvePosition = valueTo_us(myCurve[i-2].position); 
-  previousCurve = curveNumber;
+  } while ((i < SIZE_SERVO_CURVE) && ((i == 1) || (curve[i - 1].time != 0)));
+  curveSource = inRam;
+  this->curve = ramCurves[servo];
+  initCurve(stretch);
+  previousCurve = USER_CURVE;
 }
 
 
-void ServoMoba1::initCurveFromPROGMEM(uint8_t curveNumber, uint8_t stretch) {
+curvePoint_t ServoMoba1::curvePoint(uint8_t i) {
+  curvePoint_t point = {0, 0};
+  if (i > lastPoint) return point;
+  switch (curveSource) {
+    case inFlash: {
+      const curvePoint_t *src = curve + i;
+      point.time = lookupTime;                   // is a #define
+      point.position = lookupPosition;           // is a #define
+    }
+    break;
+    case inRam:
+      point = curve[i];
+    break;
+    case inEeprom:
+      point.time = EEPROM.read(curveEeprom + 2 * i);
+      point.position = EEPROM.read(curveEeprom + 2 * i + 1);
+    break;
+    default:
+    break;
+  }
+  return point;
+}
+
+
+// The curve ends at the first point (after the first) with time 0, or after SIZE_SERVO_CURVE - 1 points
+void ServoMoba1::initCurve(uint8_t stretch) {
   if (stretch > 0) timeStretch = stretch;
     else timeStretch = 1;
-  uint8_t arrayIndex = curveNumber & 0b00111111;
-  if (arrayIndex <= NUMBER_OF_LAST_CURVE) {
-    const curvePoint_t *src = PredefinedCurves[arrayIndex];  
-    uint8_t i = 0;
-    bool ready = false;
-    do {
-      myCurve[i].time = lookupTime;            // is a #define
-      myCurve[i].position = lookupPosition;    // is a #define
-      if ((i > 0) && (myCurve[i].time == 0)) ready = true;
-      src++;
-      i++;
-    } while (!ready);                          // i is now 2 above the last curve element
-    firstCurvePosition = valueTo_us(myCurve[0].position);
-    lastCurvePosition = valueTo_us(myCurve[i-2].position); 
-    previousCurve = curveNumber;
+  lastPoint = SIZE_SERVO_CURVE - 2;
+  for (uint8_t i = 1; i < SIZE_SERVO_CURVE - 1; i++) {
+    if (curvePoint(i).time == 0) {
+      lastPoint = i - 1;
+      break;
+    }
   }
+  curveDirection = servoDirection;
+  curveEnd = curvePoint(lastPoint).time;
+  curveFrames = curveEnd * timeStretch;
 }
 
 
@@ -103,6 +260,14 @@ void ServoMoba1::checkServo() {
   // If 20 ms have passed, we may switch on/off power, or do something that is 
   // specific for the state we are in. 
   if (acceptsNewValue()) {                     // A pulse has just been initialised
+    // If the main loop was late, one or more frames have been missed. The state methods skip these
+    // frames, so the movement (and the power and pulse steps around it) keep their duration.
+    uint16_t elapsed = getPulseFrame() - lastPulseFrame;
+    lastPulseFrame += elapsed;
+    if (elapsed > 256) framesLate = 255;
+      else framesLate = (elapsed > 0) ? elapsed - 1 : 0;
+    PositionJournal *journal = journalOf(getServoIndex());
+    if (hasFeedback) checkFeedback(feedbackOf(getServoIndex()));
     if (PowerOnNextTick) powerOn();
     if (PowerOffNextTick) powerOff();  
     if (PulseOffNextTick) pulseOff();
@@ -116,6 +281,11 @@ void ServoMoba1::checkServo() {
       case finish: servoFinish();
       break;
     };
+    if (journal) journal->step();              // writes (at most) one byte of a journal record
+    // Once nothing is left that counts frames, the ISR may be suspended (see Servo::needFrames())
+    MoveQueue *queue = queueOf(getServoIndex());   // queueMove() may just have made the queues
+    needFrames((servoState != idle) || PowerOnNextTick || PowerOffNextTick || PulseOffNextTick
+      || (journal && journal->busy()) || hasFeedback || (queue && (queue->count() > 0)));
     waitTillNextPulse();                       // check again in 20 ms from now.
   };
 }
@@ -125,12 +295,25 @@ void ServoMoba1::checkServo() {
 // Internal subroutines, one for each of the four possible states
 //******************************************************************************************************
 void ServoMoba1::servoIdle() {
-//  IDLE_ON;                                                          // TIJDELIJK
+  moveCommand_t command;
+  MoveQueue *queue = queueOf(getServoIndex());
+  if (queue && queue->pop(command)) {          // Is another movement waiting?
+    TRACE(traceQueuePop, command.curve);
+    if (command.curve != KEEP_CURVE) initCurveFromPROGMEM(command.curve, command.timeStretch);
+    moveServoAlongCurve(command.direction, command.dwell);
+  }
 };
 
 
 void ServoMoba1::servoStart() {
-//  START_ON;                                                         // TIJDELIJK
+  if (!hasCurrent) {                           // Wait till the current budget allows us to start
+    if (!ServoPower::requestCurrent(ServoConfig::get(config).moveCurrent * 10)) return;
+    hasCurrent = true;
+  }
+  countPulse = (countPulse > framesLate) ? countPulse - framesLate : 0;
+  countPower = (countPower > framesLate) ? countPower - framesLate : 0;
+  countServo = (countServo > framesLate) ? countServo - framesLate : 0;
+  framesLate = 0;
   if (countPulse > 0) countPulse--;
     else writeMicroseconds(lastPulseWidth);
   if (countPower > 0) countPower--; 
@@ -138,33 +321,60 @@ void ServoMoba1::servoStart() {
   if (countServo > 0) countServo--;
     else {
       servoState = moving;
+      TRACE(traceStart, lastPulseWidth);
       servoMoving();    
     }
 }
 
 
 void ServoMoba1::servoMoving() {
-//  MOVING_ON;
-  if ((myCurve[index].time * timeStretch) == (ticks)) {  // new segment
+  // Move to the next segment once ticks has reached the end of the current segment. If the curve 
+  // has been compressed in time (see setCurveDuration()), several curve points may fall within the
+  // same frame; the segments in between are then skipped. The same happens if frames were missed.
+  ticks += framesLate;
+  framesLate = 0;
+  while ((index == 0) ||
+         ((index <= lastPoint) && ((int16_t)ticks >= (int16_t)curveTimeToFrames(curvePoint(index).time)))) {
     index++;
-    fillSegment(index);
-    // Serial1.printf("%u: (%u, %u) => (%u, %u)\n",index, segment.xFrom, segment.yFrom, segment.xTo, segment.yTo);
+    TRACE(traceSegment, index);
   }
-  lastPulseWidth = positionIn_us(ticks);
+  if (index > lastPoint) lastPulseWidth = valueTo_us(curvePoint(lastPoint).position);  // the last curve point
+    else lastPulseWidth = positionIn_us(ticks);
   writeMicroseconds(lastPulseWidth);
-  // Serial1.printf(" %u: %u us\n",ticks, lastPulseWidth);
   ticks++;
-  if ((index > 0) && (myCurve[index].time == 0)) {          // we have had all segments
-    countPulse = pulseOffAfterMoving;
-    countPower = powerOffAfterMoving;
+  if (index > lastPoint) {                                           // we have had all segments
+    const servoConfig_t &settings = ServoConfig::get(config);
+    ServoPower::releaseCurrent(settings.moveCurrent * 10);
+    hasCurrent = false;
+    servoFeedback_t *state = feedbackOf(getServoIndex());
+    if (state && (settings.settleTolerance > 0)) {                   // The sample we expect at the end
+      if (treshold2 == treshold1) state->settleTarget = state->atTreshold1;
+        else state->settleTarget = state->atTreshold1 + ((int16_t)lastPulseWidth - treshold1)
+                                   * (long)(state->atTreshold2 - state->atTreshold1) / (treshold2 - treshold1);
+    }
+    countPulse = settings.pulseOffAfterMoving;
+    countPower = settings.powerOffAfterMoving;
     servoState = finish;
+    TRACE(traceFinish, lastPulseWidth);
     servoFinish();
   };
 };
 
 
 void ServoMoba1::servoFinish() {
-//  FINISH_ON;
+  countPulse = (countPulse > framesLate) ? countPulse - framesLate : 0;
+  countPower = (countPower > framesLate) ? countPower - framesLate : 0;
+  framesLate = 0;
+  uint8_t tolerance = ServoConfig::get(config).settleTolerance;
+  servoFeedback_t *state = feedbackOf(getServoIndex());
+  if (state && (tolerance > 0) && ((countPulse > 0) || (countPower > 0))) {
+    int16_t difference = (int16_t)state->latest - state->settleTarget;
+    if ((difference >= -tolerance) && (difference <= tolerance)) {
+      countPulse = 0;                          // The servo is there: no need to wait any longer
+      countPower = 0;
+      TRACE(traceSettle, state->latest);
+    }
+  }
   bool move2idle = ((countPulse == 0) && (countPower == 0));
   if (countPulse > 0) countPulse--;
     else PulseOffNextTick = true;
@@ -175,6 +385,12 @@ void ServoMoba1::servoFinish() {
   if (move2idle) {
     servoState = idle;
     movementCompleted = true;
+    PositionJournal *journal = journalOf(getServoIndex());
+    if (journal && journal->active()) {
+      journalEntry_t entry = {lastPulseWidth, treshold1, treshold2};
+      journal->write(entry);
+    }
+    TRACE(traceIdle, lastPulseWidth);
     servoIdle();
   }
 };
@@ -183,27 +399,35 @@ void ServoMoba1::servoFinish() {
 //******************************************************************************************************
 // Support methods for the moving state
 //******************************************************************************************************
-// Create the X-coordinate. Mapping function for within individual segments:
+// Create the X-coordinate. Mapping function for within the segment between the curve points index - 1
+// and index. The segment is not stored, but derived from both curve points at each step.
 uint16_t ServoMoba1::positionIn_us(uint16_t xValue) {
-  return ((xValue - segment.xFrom) * (long)(segment.yDelta) / segment.xDelta + segment.yFrom);
+  curvePoint_t from = curvePoint(index - 1);
+  curvePoint_t to = curvePoint(index);
+  int16_t xFrom = curveTimeToFrames(from.time);
+  int16_t xTo = curveTimeToFrames(to.time);                      // xTo - xFrom is the length of the segment
+  int16_t yFrom = valueTo_us(from.position);
+  int16_t yDelta = valueTo_us(to.position) - yFrom;
+  return ((xValue - xFrom) * (long)(yDelta) / (xTo - xFrom) + yFrom);
 };
 
 // Create the Y-coordinate. Mapping function can be used for all X-coordinates
 // Treshold1 and treshold2 should be signed integers, to allow their difference to be negative
 uint16_t ServoMoba1::valueTo_us(uint8_t yValue) {
-  if (servoDirection == 0) return (yValue * (long)(treshold2 - treshold1) / 255 + treshold1);
+  return valueTo_us(yValue, servoDirection);
+};
+
+uint16_t ServoMoba1::valueTo_us(uint8_t yValue, uint8_t direction) {
+  if (direction == 0) return (yValue * (long)(treshold2 - treshold1) / 255 + treshold1);
   else return (yValue * (long)(treshold1 - treshold2) / 255 + treshold2);
 };
 
-// Fill the segment values for a given index
-void ServoMoba1::fillSegment(uint8_t index){
-  segment.index = index;
-  segment.xFrom = myCurve[index-1].time * timeStretch;
-  segment.xTo = myCurve[index].time * timeStretch;
-  segment.xDelta = segment.xTo - segment.xFrom;
-  segment.yFrom = valueTo_us(myCurve[index-1].position);
-  segment.yTo = valueTo_us(myCurve[index].position);
-  segment.yDelta = segment.yTo - segment.yFrom;
+// Convert the time of a curve point into the number of frames (ticks) since the start of the curve.
+// Normally the curve lasts curveEnd * timeStretch frames, in which case this is a simple multiplication.
+// After setCurveDuration() the curve may last any number of frames.
+uint16_t ServoMoba1::curveTimeToFrames(uint8_t time) {
+  if (curveFrames == (uint16_t)(curveEnd * timeStretch)) return time * timeStretch;
+  return ((uint32_t)time * curveFrames) / curveEnd;
 }
 
 
@@ -212,40 +436,80 @@ void ServoMoba1::fillSegment(uint8_t index){
 //******************************************************************************************************
 ServoMoba1::ServoMoba1() {
   servoState = idle;
+  servoDirection = 0;
+  curveSource = noCurve;
+  curveDirection = 0;
+  lastPoint = 0;
   timeStretch = 1;
+  curveEnd = 0;
+  curveFrames = 0;
   treshold1 = 1400;
   treshold2 = 1600;
+  config = 0;                          // The default settings (see config.h)
+  powerRail = NO_RAIL;
   // Pulse specific attributes
   idlePulseDefault = continuous;
-  pulseOnBeforeMoving = 0;
-  pulseOffAfterMoving = 0;
   // Power specific attributes
-  powerOnBeforeMoving = 0;
-  powerOffAfterMoving = 0;
   idlePowerIsOff = false;
+  powerIsOn = false;
   PowerOnNextTick = false;
   PowerOffNextTick = false;
+  hasCurrent = false;
+  PulseOffNextTick = false;
   // counters
   countServo = 0;
   countPulse = 0;
   countPower = 0;
+  lastPulseFrame = 0;
+  // feedback
+  hasFeedback = false;
+}
+
+// Settings are changed via a copy, since other servos may share the entry (see config.h). The table
+// has room for SERVOS_PER_TIMER servos per timer; a servo beyond these has no slot, and can't move.
+void ServoMoba1::changeConfig(const servoConfig_t &value) {
+  if (getServoIndex() >= SERVOS_PER_TIMER) return;
+  config = ServoConfig::change(config, value);
 }
 
 //******************************************************************************************************
-void ServoMoba1::initPulse(          // Need not be called in case of a continuous pulse
-  uint8_t idleOutput,                // 0 is low, rest is high
-  uint8_t pulseBeforeMoving,         // 0.255. Steps are in 20 ms
-  uint8_t pulseAfterMoving,          // 0.255. Steps are in 20 ms
-  uint16_t initialPulseWidth) {      // Pulse width where the servo starts from (after power on)
-if (idleOutput) idlePulseDefault = high;
-else idlePulseDefault = low;
-if (idleOutput && (pulseBeforeMoving < 255)) pulseBeforeMoving++;
-pulseOnBeforeMoving = pulseBeforeMoving;
-pulseOffAfterMoving = pulseAfterMoving;
-constantOutput(idleOutput);          // sets the idle pulse signal low (0V) or high (3,3 or 5V)
-lastPulseWidth = initialPulseWidth;  // This is the pulse width to be used after startup
+void ServoMoba1::initPulse(             // Need not be called in case of a continuous pulse
+    uint8_t idleOutput,                // 0 is low, rest is high
+    uint8_t pulseBeforeMoving,         // 0.255. Steps are in 20 ms
+    uint8_t pulseAfterMoving,          // 0.255. Steps are in 20 ms
+    uint16_t initialPulseWidth) {      // Pulse width where the servo starts from (after power on)
+  if (idleOutput) idlePulseDefault = high;
+  else idlePulseDefault = low;
+  if (idleOutput && (pulseBeforeMoving < 255)) pulseBeforeMoving++;
+  servoConfig_t settings = ServoConfig::get(config);
+  settings.pulseOnBeforeMoving = pulseBeforeMoving;
+  settings.pulseOffAfterMoving = pulseAfterMoving;
+  changeConfig(settings);
+  constantOutput(idleOutput);          // sets the idle pulse signal low (0V) or high (3,3 or 5V)
+  lastPulseWidth = initialPulseWidth;  // This is the pulse width to be used after startup
 }
 
+//******************************************************************************************************
+// initJournal() restores the position and tresholds of before the last power-down, and from now on
+// stores them after each movement (see TCA_MobaJournal/journal.h). It should be called after
+// initPulse() and setTreshold1/2(), since these overwrite the restored values, and before attach().
+// Each servo needs its own EEPROM block, which should not overlap with curves stored in EEPROM.
+// The block holds 2..127 records; with less than 2 records no journal is kept and false is returned.
+//******************************************************************************************************
+bool ServoMoba1::initJournal(int adresEeprom, uint8_t records) {
+  uint8_t servo = getServoIndex();
+  if (servo >= SERVOS_PER_TIMER) return false;
+  journals = journalStorage;
+  journalEntry_t entry;
+  if (!journalStorage[servo].init(adresEeprom, records, entry)) return false;
+  treshold1 = entry.treshold1;
+  treshold2 = entry.treshold2;
+  lastPulseWidth = entry.pulseWidth;
+  if (idlePulseDefault == continuous) writeMicroseconds(lastPulseWidth);
+  return true;
+}
+
+
 //******************************************************************************************************
 void ServoMoba1::initPower(
   boolean idleDefault,               // should power be switch off while idle?
@@ -254,34 +518,120 @@ void ServoMoba1::initPower(
   uint8_t stepsBeforeMoving,         // 0.255. Steps are in 20 ms
   uint8_t stepsAfterMoving) {        // 0.255. Steps are in 20 ms
   idlePowerIsOff = idleDefault;
-  powerEnablePin = pin;
-  powerEnableValue = enableValue;
+  servoConfig_t settings = ServoConfig::get(config);
   if (idlePowerIsOff) {
     if (stepsAfterMoving < 255) stepsAfterMoving++;
-    powerOnBeforeMoving = stepsBeforeMoving;
-    powerOffAfterMoving = stepsAfterMoving;
+    settings.powerOnBeforeMoving = stepsBeforeMoving;
+    settings.powerOffAfterMoving = stepsAfterMoving;
   }
   else {
-    powerOnBeforeMoving = 0;
-    powerOffAfterMoving = 0;
+    settings.powerOnBeforeMoving = 0;
+    settings.powerOffAfterMoving = 0;
   }
-  // If this method is called, we have hardware to switch the servo 5V power on/off
-  pinMode(powerEnablePin, OUTPUT);
+  // If this method is called, we have hardware to switch the servo 5V power on/off.
+  // Servos that use the same pin share the same power rail; the rail is on as long as at least
+  // one of these servos needs power.
+  if (powerIsOn) powerOff();
+  powerRail = ServoPower::attachRail(pin, enableValue);
+  changeConfig(settings);
   // Set the 5V power to the desired value
-  if (idlePowerIsOff) digitalWrite(powerEnablePin, !powerEnableValue);
-    else digitalWrite(powerEnablePin, powerEnableValue);
+  if (!idlePowerIsOff) powerOn();
 }
 
 void ServoMoba1::powerOn() {
-  digitalWrite(powerEnablePin, powerEnableValue);
+  if (!powerIsOn) {
+    ServoPower::railOn(powerRail);
+    TRACE(tracePowerOn, powerRail);
+  }
+  powerIsOn = true;
   PowerOnNextTick = false;
 }
 
 void ServoMoba1::powerOff() {
-  digitalWrite(powerEnablePin, !powerEnableValue);
+  if (powerIsOn) {
+    ServoPower::railOff(powerRail);
+    TRACE(tracePowerOff, powerRail);
+  }
+  powerIsOn = false;
   PowerOffNextTick = false;
 }
 
+// The current (in mA) this servo needs while it is starting and moving. See power.h
+void ServoMoba1::setMoveCurrent(uint16_t current) {
+  servoConfig_t settings = ServoConfig::get(config);
+  if (current > 2550) settings.moveCurrent = 255;
+    else settings.moveCurrent = (current + 9) / 10;
+  changeConfig(settings);
+}
+
+//******************************************************************************************************
+// Feedback. initFeedback() lets the servo be sampled once per frame, at a fixed moment within its
+// slot (see TCA_MobaFeedback/feedback.h). The samples can be used in two ways:
+// - Settling (position feedback, such as the potentiometer of the servo): the finish state normally
+//   lasts pulseOffAfterMoving / powerOffAfterMoving frames, which must be long enough for the slowest
+//   movement. With setSettle() the finish state ends as soon as the feedback is within the tolerance
+//   of the sample that belongs to the last curve position. The curve itself is always followed, since
+//   it determines the speed of the movement.
+// - Stall detection (current feedback, for example over a shunt resistor): if the sample stays above
+//   the limit during a movement for a number of frames, the servo is blocked. Pulses and power are
+//   then switched off at once, queued movements are removed, and the stalled flag is set. The next
+//   movement clears the flag. No journal record is written, since the position is unknown.
+// initFeedback() must be called after attach(); it returns false if sampling is not possible.
+//******************************************************************************************************
+bool ServoMoba1::initFeedback(uint8_t analogPin) {
+  if (useFeedback(getServoIndex()) == 0) return false;
+  hasFeedback = ServoFeedback::attach(1, getServoIndex(), analogPin, &Servo1::getSlotServo);
+  return hasFeedback;
+}
+
+uint16_t ServoMoba1::getFeedback() {
+  servoFeedback_t *state = feedbackOf(getServoIndex());
+  return (state) ? state->latest : 0;
+}
+
+void ServoMoba1::setSettle(uint16_t atTreshold1, uint16_t atTreshold2, uint8_t tolerance) {
+  servoFeedback_t *state = useFeedback(getServoIndex());
+  if (state == 0) return;
+  state->atTreshold1 = (int16_t)atTreshold1;
+  state->atTreshold2 = (int16_t)atTreshold2;
+  servoConfig_t settings = ServoConfig::get(config);
+  settings.settleTolerance = tolerance;
+  changeConfig(settings);
+}
+
+void ServoMoba1::setStall(uint16_t limit, uint8_t frames) {
+  servoFeedback_t *state = useFeedback(getServoIndex());
+  if (state == 0) return;
+  state->stallCount = 0;
+  servoConfig_t settings = ServoConfig::get(config);
+  settings.stallLimit = limit;
+  settings.stallFrames = (frames > 0) ? frames : 1;
+  changeConfig(settings);
+}
+
+void ServoMoba1::checkFeedback(servoFeedback_t *state) {
+  if (!ServoFeedback::get(getServoIndex(), state->latest)) return; // No new sample
+  const servoConfig_t &settings = ServoConfig::get(config);
+  if ((settings.stallLimit == 0) || (servoState == idle)) return;
+  if (state->latest <= settings.stallLimit) state->stallCount = 0;
+    else if (++state->stallCount >= settings.stallFrames) stopStalled();
+}
+
+void ServoMoba1::stopStalled() {
+  TRACE(traceStall, getFeedback());
+  if (hasCurrent) {
+    ServoPower::releaseCurrent(ServoConfig::get(config).moveCurrent * 10);
+    hasCurrent = false;
+  }
+  clearQueue();
+  powerOff();
+  pulseOff();
+  PowerOnNextTick = false;
+  servoState = idle;
+  stalled = true;
+  movementCompleted = true;
+}
+
 void ServoMoba1::pulseOff() {
   if (idlePulseDefault == low) constantOutput(0);
   if (idlePulseDefault == high) constantOutput(1);
@@ -305,12 +655,41 @@ uint16_t ServoMoba1::getTreshold2() {
   return (uint16_t)treshold2;
 }
 
+// As calculated at the moment the curve was loaded
 uint16_t ServoMoba1::getFirstCurvePosition() {
-  return firstCurvePosition;
+  return valueTo_us(curvePoint(0).position, curveDirection);
 }
 
 uint16_t ServoMoba1::getLastCurvePosition() {
-  return lastCurvePosition;
+  return valueTo_us(curvePoint(lastPoint).position, curveDirection);
+}
+
+uint8_t ServoMoba1::getServoState() {
+  return servoState;
+}
+
+
+//******************************************************************************************************
+// The duration of a movement, in 20 ms steps. 
+// getStartDuration() is the time between moveServoAlongCurve() and the start of the curve, which 
+// depends on initPulse() and initPower(). getCurveDuration() is the time between the first and last
+// curve point. By default this is the time of the last curve point multiplied by timeStretch, but
+// setCurveDuration() may stretch or compress the loaded curve to any number of steps. 
+// This is used by ServoGroup::moveTogether(), to let servos with different curves reach the end of 
+// their curve at the same frame. Loading a new curve restores the default duration.
+//******************************************************************************************************
+uint8_t ServoMoba1::getStartDuration() {
+  const servoConfig_t &settings = ServoConfig::get(config);
+  if (settings.powerOnBeforeMoving >= settings.pulseOnBeforeMoving) return settings.powerOnBeforeMoving;
+  return settings.pulseOnBeforeMoving;
+}
+
+uint16_t ServoMoba1::getCurveDuration() {
+  return curveFrames;
+}
+
+void ServoMoba1::setCurveDuration(uint16_t frames) {
+  if (curveEnd > 0) curveFrames = frames;
 }
 
 
@@ -318,14 +697,10 @@ uint16_t ServoMoba1::getLastCurvePosition() {
 // Code for debugging and testing
 //======================================================================================================
 void ServoMoba1::printCurve() {
-  uint8_t i = 0;
-  bool ready = false;
-  do {
+  for (uint8_t i = 0; i <= lastPoint + 1; i++) {
     Serial1.print("Time: ");
-    Serial1.print(myCurve[i].time);
+    Serial1.print(curvePoint(i).time);
     Serial1.print(" - Position: ");
-    Serial1.println(myCurve[i].position);
-    if ((i > 0) && (myCurve[i].time == 0)) ready = true;
-    i++;
-  } while (!ready);
+    Serial1.println(curvePoint(i).position);
+  }
 }
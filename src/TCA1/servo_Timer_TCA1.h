@@ -21,12 +21,13 @@
 #define takeOverTCA() takeOverTCA1()            // Used in the .cpp file
 #define resumeTCA()   resumeTCA1()              // Used in the .cpp file
 #define ServoHandler  TCA1_OVF_vect             // Used in the .cpp file
+#define SyncUser      EVSYS.USERTCA1CNTB        // Used in the .cpp file (frame synchronisation)
 
 //******************************************************************************************************
 // The initialisation of the multplexer depends on the processor being used.
 // DxCore and MEGACOREX processors require that all pins belong to the same port
 //******************************************************************************************************
-static boolean initMultiplexer(uint8_t port) {
+static boolean initMultiplexer(uint8_t port, boolean apply = true) {   // apply = false: only test the port
   boolean configured = false;
   // DxCore will preset the PORTMUX to a certain port during startup. 
   // Therefore we have to clear the TCA1 bits before we can set it with new values. 
@@ -70,59 +71,59 @@ static boolean initMultiplexer(uint8_t port) {
     default:                                     // PA, PD, PF
     break;
   }  
-  if (configured) PORTMUX.TCAROUTEA = tcaroutea; // write the temp variable back to the register.
+  if (configured && apply) PORTMUX.TCAROUTEA = tcaroutea;   // write the temp variable back to the register.
   return configured;
 }
 
 
-static boolean enableCompareUnit(byte pin, uint8_t servoIndex) {
-  boolean enabled = false;
+// The pins of each Compare Unit. For the TCA1 timer the number of options is relatively low, which
+// means that a case statement can be used. See also tca1CompareUnit() in TCA_Pins/pinMap.h
+static uint8_t pinToCompareUnit(byte pin) {
   switch (pin) { 
     case PIN_PB0:
     case PIN_PC4:
-      compareUnit0 = servoIndex;                                    // index into the channels array
-      channels[servoIndex].CompareUnit = 0;                         // attach the channel to the Compare Unit
-      _TIMER.CTRLB |= TCA_SINGLE_CMP0EN_bm;                         // enable Compare Unit 0
-      enabled = true;
-    break;
+    #if _AVR_PINCOUNT == 64
+    case PIN_PE4:
+    case PIN_PG0:
+    #endif
+      return 0;
     case PIN_PB1: 
     case PIN_PC5:
-      compareUnit1 = servoIndex;
-      channels[servoIndex].CompareUnit = 1;
-      _TIMER.CTRLB |= TCA_SINGLE_CMP1EN_bm;                         // enable Compare Unit 1
-      enabled = true;
-    break;
+    #if _AVR_PINCOUNT == 64
+    case PIN_PE5: 
+    case PIN_PG1:
+    #endif
+      return 1;
     case PIN_PB2: 
     case PIN_PC6:
-      compareUnit2 = servoIndex;
-      channels[servoIndex].CompareUnit = 2;
-      _TIMER.CTRLB |= TCA_SINGLE_CMP2EN_bm;                         // enable Compare Unit 2     
-      enabled = true;
-    break;
-    //
     #if _AVR_PINCOUNT == 64
-    case PIN_PE4:
-    case PIN_PG0:
+    case PIN_PE6: 
+    case PIN_PG2:
+    #endif
+      return 2;
+  }
+  return NO_COMPARE_UNIT;
+}
+
+
+static boolean enableCompareUnit(uint8_t compareUnit, uint8_t servoIndex) {
+  boolean enabled = false;
+  switch (compareUnit) { 
+    case 0:                                                         // Compare Unit 0
       compareUnit0 = servoIndex;                                    // index into the channels array
-      channels[servoIndex].CompareUnit = 0;                         // attach the channel to the Compare Unit
       _TIMER.CTRLB |= TCA_SINGLE_CMP0EN_bm;                         // enable Compare Unit 0
       enabled = true;
     break;
-    case PIN_PE5: 
-    case PIN_PG1:
+    case 1: 
       compareUnit1 = servoIndex;
-      channels[servoIndex].CompareUnit = 1;
       _TIMER.CTRLB |= TCA_SINGLE_CMP1EN_bm;                         // enable Compare Unit 1
       enabled = true;
     break;
-    case PIN_PE6: 
-    case PIN_PG2:
+    case 2: 
       compareUnit2 = servoIndex;
-      channels[servoIndex].CompareUnit = 2;
       _TIMER.CTRLB |= TCA_SINGLE_CMP2EN_bm;                         // enable Compare Unit 2     
       enabled = true;
     break;
-    #endif
   }
   return enabled;
 }
@@ -136,9 +137,7 @@ static boolean enableCompareUnit(byte pin, uint8_t servoIndex) {
 //    If we know the port, the port multiplexer can be configured.
 //    digitalPinToPort() is used to determine the port to which a specific pin belongs:  
 //    Px0 becomes 0, Px1 becomes 1 etc
-// 2) Enablermine the compare unit, that is attached to that pin. 
-//    For the TCA1 timer the number of options is relatively low, which means that a case statement
-//    can be used.
+// 2) Determine and enable the compare unit, that is attached to that pin (see pinToCompareUnit()).
 //******************************************************************************************************
 #define NO_PORT 255
 static uint8_t usedPort = NO_PORT;                                     // Set during 1st initCompareUnit
@@ -148,12 +147,45 @@ static boolean initCompareUnit(byte pin, uint8_t servoIndex) {
   uint8_t newPort = digitalPinToPort(pin);
   if ((usedPort != NO_PORT) && (usedPort != newPort)) return false;
   if (!initMultiplexer(newPort)) return false;
-  if (!enableCompareUnit(pin, servoIndex)) return false;
+  if (!enableCompareUnit(pinToCompareUnit(pin), servoIndex)) return false;
   pinMode(pin, OUTPUT);                                             // Set the pin as output
   usedPort = newPort;
   return true;
 }
 
 
+//******************************************************************************************************
+// For attach<pin>(), which writes PORTMUX and CTRLB itself (see servo_TCA1.h): the compiler has
+// already determined (and checked) the port and Compare Unit of the pin, see TCA_Pins/pinMap.h.
+// As initCompareUnit(), all servos must use the same port.
+//******************************************************************************************************
+static boolean claimCompareUnit(uint8_t port, uint8_t compareUnit, uint8_t servoIndex) {
+  if ((usedPort != NO_PORT) && (usedPort != port)) return false;
+  usedPort = port;
+  if (compareUnit == 0) compareUnit0 = servoIndex;                  // index into the channels array
+  else if (compareUnit == 1) compareUnit1 = servoIndex;
+  else compareUnit2 = servoIndex;
+  return true;
+}
+
+
+//******************************************************************************************************
+// pinIsFree() tells if initCompareUnit() would accept the pin, without changing any register: the pin
+// belongs to the port in use (or, for the first servo, to a port the multiplexer supports), and its
+// Compare Unit has not yet been taken by another servo. Used by Servo1::canAttach().
+//******************************************************************************************************
+static boolean pinIsFree(byte pin) {
+  uint8_t newPort = digitalPinToPort(pin);
+  if ((usedPort != NO_PORT) && (usedPort != newPort)) return false;
+  if (!initMultiplexer(newPort, false)) return false;
+  switch (pinToCompareUnit(pin)) {
+    case 0: return (compareUnit0 == NO_CHANNEL);
+    case 1: return (compareUnit1 == NO_CHANNEL);
+    case 2: return (compareUnit2 == NO_CHANNEL);
+  }
+  return false;
+}
+
+
 //======================================================================================================
 #endif
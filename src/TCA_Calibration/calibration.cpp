@@ -0,0 +1,114 @@
+//******************************************************************************************************
+//
+// file:      calibration.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Optional per-servo calibration for the Servo (TCA0) and Servo1 (TCA1) classes.
+//            See calibration.h for details.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "calibration.h"
+
+static uint8_t checksum(const int8_t *correction) {
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < CALIBRATION_POINTS; i++) sum += correction[i];
+  return ~sum;                                   // Erased EEPROM (all 0xFF) is invalid
+}
+
+
+ServoCalibration::ServoCalibration() {
+  clear();
+}
+
+
+void ServoCalibration::clear() {
+  for (uint8_t i = 0; i < CALIBRATION_POINTS; i++) setCorrection(i, 0);
+}
+
+
+void ServoCalibration::update(uint8_t point) {
+  uint16_t us = CALIBRATION_FIRST + (point << CALIBRATION_SHIFT) + correction[point];
+  ticks[point] = ServoTicks::usToTicks(us);
+}
+
+
+void ServoCalibration::setCorrection(uint8_t point, int8_t value) {
+  if (point >= CALIBRATION_POINTS) return;
+  correction[point] = value;
+  update(point);
+}
+
+
+int8_t ServoCalibration::getCorrection(uint8_t point) {
+  if (point >= CALIBRATION_POINTS) return 0;
+  return correction[point];
+}
+
+
+//******************************************************************************************************
+// fromPoints() interpolates the corrections of the measurements at each point of the table. This is
+// only done once, so divisions are fine here.
+//******************************************************************************************************
+bool ServoCalibration::fromPoints(const calibrationPoint_t *points, uint8_t count) {
+  bool withinLimits = true;
+  if (count == 0) return false;
+  for (uint8_t i = 0; i < CALIBRATION_POINTS; i++) {
+    int32_t us = CALIBRATION_FIRST + (i << CALIBRATION_SHIFT);
+    int32_t value;
+    uint8_t j = 0;
+    while ((j < count) && (points[j].wanted < us)) j++;
+    if (j == 0) value = (int32_t)points[0].measured - points[0].wanted;
+    else if (j == count) value = (int32_t)points[count - 1].measured - points[count - 1].wanted;
+    else {
+      const calibrationPoint_t &a = points[j - 1];
+      const calibrationPoint_t &b = points[j];
+      int32_t correctionA = (int32_t)a.measured - a.wanted;
+      int32_t correctionB = (int32_t)b.measured - b.wanted;
+      value = correctionA + (correctionB - correctionA) * (us - a.wanted) / (b.wanted - a.wanted);
+    }
+    if (value > 127) {value = 127; withinLimits = false;}
+    if (value < -127) {value = -127; withinLimits = false;}
+    setCorrection(i, value);
+  }
+  return withinLimits;
+}
+
+
+bool ServoCalibration::load(int adresEeprom) {
+  int8_t value[CALIBRATION_POINTS];
+  for (uint8_t i = 0; i < CALIBRATION_POINTS; i++) value[i] = EEPROM.read(adresEeprom + i);
+  if (EEPROM.read(adresEeprom + CALIBRATION_POINTS) != checksum(value)) {
+    clear();
+    return false;
+  }
+  for (uint8_t i = 0; i < CALIBRATION_POINTS; i++) setCorrection(i, value[i]);
+  return true;
+}
+
+
+void ServoCalibration::save(int adresEeprom) {
+  for (uint8_t i = 0; i < CALIBRATION_POINTS; i++) EEPROM.update(adresEeprom + i, correction[i]);
+  EEPROM.update(adresEeprom + CALIBRATION_POINTS, checksum(correction));
+}
+
+
+//******************************************************************************************************
+// Called for each write. Between two points the ticks are interpolated; outside the table the
+// correction of the first or last point is used.
+//******************************************************************************************************
+uint16_t ServoCalibration::toTicks(uint16_t us) {
+  if (us < CALIBRATION_FIRST) {
+    int16_t value = us + correction[0];
+    return ServoTicks::usToTicks((value > 0) ? value : 0);
+  }
+  if (us >= CALIBRATION_LAST) return ServoTicks::usToTicks(us + correction[CALIBRATION_POINTS - 1]);
+  uint16_t offset = us - CALIBRATION_FIRST;
+  uint8_t point = offset >> CALIBRATION_SHIFT;
+  uint8_t fraction = offset & ((1 << CALIBRATION_SHIFT) - 1);
+  uint16_t delta = ticks[point + 1] - ticks[point];   // Points are further apart than 2 * 127 us
+  uint32_t step = (uint32_t)delta * fraction + (1 << (CALIBRATION_SHIFT - 1));
+  return ticks[point] + (uint16_t)(step >> CALIBRATION_SHIFT);
+}
@@ -0,0 +1,66 @@
+//******************************************************************************************************
+//
+// file:      calibration.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Optional per-servo calibration for the Servo (TCA0) and Servo1 (TCA1) classes.
+//            write() maps angles linearly onto the pulse width, and ServoMoba maps curve positions
+//            linearly between both tresholds. Real servos, however, are not linear, and often not
+//            even symmetric around the centre. The same curve therefore looks different on servos
+//            of different brands. A calibration corrects this: every pulse width that is written
+//            (by write(), writeMicroseconds() and thus also by every curve step of ServoMoba) is
+//            replaced by the pulse width that this specific servo needs for that position.
+//
+// The calibration is a piecewise linear function, given by the correction (in us) at
+// CALIBRATION_POINTS pulse widths: 512, 768, 1024 ... 2560 us. Corrections may be -127..127 us.
+// Below the first and above the last point, the correction of that point is used.
+//
+// Such table can be filled from a few measurements with fromPoints(). Each measurement tells which
+// pulse width (measured) the servo actually needs, to reach the position that an ideal servo would
+// reach with another pulse width (wanted). For example, if an ideal servo is at 45 degrees with
+// 1000 us, but this servo needs 1040 us to get there: {1000, 1040}. Between the measurements the
+// corrections are interpolated.
+//
+// Per servo the table takes CALIBRATION_POINTS + 1 bytes in EEPROM (corrections plus a checksum).
+// In RAM the table is kept as timer ticks per point, so the only costs per write are a subtraction,
+// a shift and one 16 x 8 bit multiplication.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+#include "../TCA_Clock/tickScale.h"
+
+#define CALIBRATION_POINTS      9                // Number of points in the table
+#define CALIBRATION_FIRST     512                // Pulse width (us) of the first point
+#define CALIBRATION_SHIFT       8                // 2^8 = 256 us between points
+#define CALIBRATION_LAST      (CALIBRATION_FIRST + ((CALIBRATION_POINTS - 1) << CALIBRATION_SHIFT))
+#define CALIBRATION_EEPROM_SIZE (CALIBRATION_POINTS + 1)
+
+typedef struct {                                 // A measurement, see fromPoints()
+  uint16_t wanted;                               // The pulse width (us) for an ideal servo
+  uint16_t measured;                             // The pulse width (us) this servo needs
+} calibrationPoint_t;
+
+
+class ServoCalibration {
+
+  public:
+    ServoCalibration();                          // constructor: no corrections
+    void clear();                                // Removes all corrections
+    bool fromPoints(                             // Fills the table from measurements
+      const calibrationPoint_t *points,          // sorted on wanted
+      uint8_t count                              // 1..255
+    );                                           // returns false if a correction had to be limited
+    void setCorrection(uint8_t point, int8_t correction);   // in us
+    int8_t getCorrection(uint8_t point);
+    bool load(int adresEeprom);                  // returns false (and clears) if the table is invalid
+    void save(int adresEeprom);                  // CALIBRATION_EEPROM_SIZE bytes; only at start-up / setup!
+
+    uint16_t toTicks(uint16_t us);               // The calibrated pulse width, in timer ticks
+
+  private:
+    int8_t correction[CALIBRATION_POINTS];       // in us
+    uint16_t ticks[CALIBRATION_POINTS];          // The calibrated pulse width of each point
+    void update(uint8_t point);                  // Calculates ticks[point]
+};
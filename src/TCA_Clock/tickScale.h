@@ -0,0 +1,131 @@
+//******************************************************************************************************
+//
+// file:      tickScale.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Compile-time (constexpr) conversion between microseconds, timer ticks and angles, for
+//            the Servo (TCA0) and Servo1 (TCA1) classes.
+//            The number of timer ticks per microsecond is F_CPU / (1000000 * PRESCALER). Calculated
+//            as integer, this truncates 7.5 ticks/us at 30 MHz into 7; pulses would then be 7%
+//            too short. Here the compiler reduces this ratio into an exact fraction num / den, and
+//            turns each conversion into a multiplication followed by a shift. At run time there
+//            are no divisions.
+//
+// - usToTicks(us):          us * num / den, rounded. Since F_CPU is a whole number of MHz and the
+//                           prescaler a power of 2, den is always a power of 2; this conversion is
+//                           therefore exact. With den = 1 (most clocks) it is a single multiplication.
+// - ticksToUs(ticks):       ticks * den / num, rounded to the nearest microsecond. The multiplier is
+//                           chosen as precise as possible, without overflowing 32 bits for any tick
+//                           value (0..65535). The compiler checks that every pulse width up to
+//                           TICK_SCALE_CHECK_US survives usToTicks() followed by ticksToUs().
+// - angleToUs(angle, lo, hi): as map(angle, 0, 180, lo, hi), but with a multiplication by the
+//                           reciprocal of 180. In 32 bits no reciprocal is precise enough for all
+//                           products angle * span; the quotient may then be 1 too high, which is
+//                           corrected by a multiplication by 180 and a compare. The result equals
+//                           that of map(); the compiler checks this for all angles 0..180 and all
+//                           spans up to ANGLE_MAX_SPAN (see angleToUsIsExact()).
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+#define TICK_SCALE_CHECK_US  4096                // Round trip is checked for 0 .. 4095 us
+#define ANGLE_SHIFT            20                // angle * span * ANGLE_MUL must fit in 32 bits
+#define ANGLE_MUL            (((1UL << ANGLE_SHIFT) + 179) / 180)
+#define ANGLE_MAX_SPAN       2876                // (MAX_PULSE_WIDTH + 127 * 4) - (MIN_PULSE_WIDTH - 128 * 4)
+
+static_assert(180UL * ANGLE_MAX_SPAN * ANGLE_MUL < 0xFFFFFFFFUL, "angleToUs() would overflow");
+
+constexpr uint32_t tickScaleGcd(uint32_t a, uint32_t b) {
+  while (b != 0) {
+    uint32_t rest = a % b;
+    a = b;
+    b = rest;
+  }
+  return a;
+}
+
+constexpr uint8_t tickScaleLog2(uint32_t value) {
+  uint8_t result = 0;
+  while (value > 1) {value >>= 1; result++;}
+  return result;
+}
+
+constexpr uint32_t tickScaleUsMul(uint32_t num, uint32_t den, uint8_t shift) {
+  return (((uint64_t)den << shift) + num / 2) / num;
+}
+
+// The largest shift (max 24) for which ticksToUs(65535) still fits in 32 bits
+constexpr uint8_t tickScaleUsShift(uint32_t num, uint32_t den) {
+  uint8_t shift = 0;
+  while ((shift < 24) && (65535ULL * tickScaleUsMul(num, den, shift + 1) + (1ULL << shift) < 0x100000000ULL)) {
+    shift++;
+  }
+  return shift;
+}
+
+
+template <uint32_t cpu, uint8_t prescaler>
+struct TickScale {
+  // Ticks per microsecond, as the fraction num / den
+  static constexpr uint32_t divider = 1000000UL * prescaler;
+  static constexpr uint32_t num = cpu / tickScaleGcd(cpu, divider);
+  static constexpr uint32_t den = divider / tickScaleGcd(cpu, divider);
+  static_assert((den & (den - 1)) == 0, "F_CPU should be a whole number of MHz");
+  static constexpr uint8_t denShift = tickScaleLog2(den);
+
+  // ticksToUs(): ticks * usMul / 2^usShift, with usMul as close as possible to den * 2^usShift / num
+  static constexpr uint8_t usShift = tickScaleUsShift(num, den);
+  static constexpr uint32_t usMul = tickScaleUsMul(num, den, usShift);
+  static constexpr uint32_t usRound = (usShift > 0) ? (1UL << (usShift - 1)) : 0;
+
+  static constexpr uint16_t usToTicks(uint16_t us) {
+    return (den == 1) ? (uint16_t)(us * (uint16_t)num)
+                      : (uint16_t)(((uint32_t)us * num + (den >> 1)) >> denShift);
+  }
+
+  static constexpr uint16_t ticksToUs(uint16_t ticks) {
+    return (num == 1 && den == 1) ? ticks
+                                  : (uint16_t)(((uint32_t)ticks * usMul + usRound) >> usShift);
+  }
+
+  // Should be checked with a static_assert by the user of this class
+  static constexpr bool roundTripIsExact() {
+    for (uint16_t us = 0; us < TICK_SCALE_CHECK_US; us++) {
+      if (ticksToUs(usToTicks(us)) != us) return false;
+    }
+    return true;
+  }
+};
+
+
+// The TCA prescaler for a certain clock; must be the same as PRESCALER in servo_TCA0/1.cpp
+constexpr uint8_t tcaPrescaler(uint32_t cpu) {
+  return (cpu > 36000000) ? 8 : (cpu > 16000000) ? 4 : (cpu > 8000000) ? 2 : 1;
+}
+
+typedef TickScale<F_CPU, tcaPrescaler(F_CPU)> ServoTicks;   // For code outside servo_TCA0/1.cpp
+
+
+// angle * span / 180, truncated as by map()
+constexpr uint16_t angleScale(uint8_t angle, uint16_t span) {
+  uint32_t product = (uint32_t)angle * span;
+  uint32_t quotient = (product * ANGLE_MUL) >> ANGLE_SHIFT;
+  return (uint16_t)((quotient * 180 > product) ? quotient - 1 : quotient);
+}
+
+// As map(angle, 0, 180, lo, hi); angle should be 0..180
+constexpr uint16_t angleToUs(uint8_t angle, uint16_t lo, uint16_t hi) {
+  return (hi >= lo) ? lo + angleScale(angle, hi - lo) : lo - angleScale(angle, lo - hi);
+}
+
+// Should be checked with a static_assert by the user of angleToUs()
+constexpr bool angleToUsIsExact() {
+  for (uint16_t angle = 0; angle <= 180; angle++) {
+    for (uint16_t span = 0; span <= ANGLE_MAX_SPAN; span++) {
+      if (angleScale(angle, span) != (uint32_t)angle * span / 180) return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,63 @@
+//******************************************************************************************************
+//
+// file:      config.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Configuration shared by the ServoMoba and ServoMoba1 objects.
+//            See config.h for details.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include "config.h"
+
+servoConfig_t ServoConfig::configs[MAX_SERVO_CONFIGS] = {
+  {0, 0, 0, 0, 0, 0, 1, 0}                       // Entry 0: the defaults
+};
+uint8_t ServoConfig::configUsers[MAX_SERVO_CONFIGS];
+
+
+//******************************************************************************************************
+// change() is called by a servo that uses entry "config", and wants to use "value" instead.
+// The entry that is returned may be the same entry (changed in place, if no other servo uses it),
+// another entry with the same settings, or an unused entry. Since the table has an entry for each servo
+// (see config.h), an unused entry is always left.
+//******************************************************************************************************
+static bool sameConfig(const servoConfig_t &a, const servoConfig_t &b) {
+  return (a.pulseOnBeforeMoving == b.pulseOnBeforeMoving) && (a.pulseOffAfterMoving == b.pulseOffAfterMoving)
+      && (a.powerOnBeforeMoving == b.powerOnBeforeMoving) && (a.powerOffAfterMoving == b.powerOffAfterMoving)
+      && (a.moveCurrent == b.moveCurrent) && (a.settleTolerance == b.settleTolerance)
+      && (a.stallFrames == b.stallFrames) && (a.stallLimit == b.stallLimit);
+}
+
+uint8_t ServoConfig::change(uint8_t config, const servoConfig_t &value) {
+  uint8_t found = MAX_SERVO_CONFIGS;
+  for (uint8_t i = 0; i < MAX_SERVO_CONFIGS; i++) {
+    if (((i == 0) || (configUsers[i] > 0)) && sameConfig(configs[i], value)) {
+      found = i;                                                   // Share an entry with the same settings
+      break;
+    }
+  }
+  if (found == MAX_SERVO_CONFIGS) {
+    if ((config > 0) && (configUsers[config] == 1)) found = config; // Not shared: change it in place
+      else for (uint8_t i = 1; i < MAX_SERVO_CONFIGS; i++) {
+        if (configUsers[i] == 0) {
+          found = i;
+          break;
+        }
+      }
+    if (found == MAX_SERVO_CONFIGS) return config;                 // Not possible, see config.h
+    configs[found] = value;
+  }
+  if (found != config) {
+    if (config > 0) configUsers[config]--;
+    if (found > 0) configUsers[found]++;
+  }
+  return found;
+}
+
+
+uint8_t ServoConfig::users(uint8_t config) {
+  if (config >= MAX_SERVO_CONFIGS) return 0;
+  return configUsers[config];
+}
@@ -0,0 +1,49 @@
+//******************************************************************************************************
+//
+// file:      config.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Configuration shared by the ServoMoba and ServoMoba1 objects.
+//            The pulse and power timing, the current while moving and the limits for
+//            settling and stall detection are normally the same for all servos of a decoder, or for
+//            all servos of the same type. Instead of a copy in each servo object, these settings are
+//            kept in a small table; each servo holds the index of its entry. Servos with the same
+//            settings share an entry.
+//
+// Entry 0 holds the default settings, and is used by each servo until one of its settings is
+// changed (with initPulse(), initPower(), setMoveCurrent(), setSettle() or setStall()). change()
+// then looks for an entry with the new settings; if there is none, an entry that is no longer used
+// gets these settings. The table is sized for the worst case: each servo of TCA0 and TCA1 can have
+// settings of its own, so a free entry is always found. Each entry takes 10 bytes of RAM.
+// The power rail is not part of the entry, but kept by each servo: the rail is a pin of that servo.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+#define MAX_SERVO_CONFIGS   7                    // 2 * SERVOS_PER_TIMER + 1 (entry 0, the defaults)
+
+typedef struct {
+  uint8_t pulseOnBeforeMoving;                   // 0.255. Steps are in 20 ms
+  uint8_t pulseOffAfterMoving;                   // 0.255. Steps are in 20 ms
+  uint8_t powerOnBeforeMoving;                   // 0.255. Steps are in 20 ms
+  uint8_t powerOffAfterMoving;                   // 0.255. Steps are in 20 ms
+  uint8_t moveCurrent;                           // Current while moving, in steps of 10 mA
+  uint8_t settleTolerance;                       // 0: no settling
+  uint8_t stallFrames;                           // Frames above stallLimit before the servo is stopped
+  uint16_t stallLimit;                           // 0: no stall detection
+} servoConfig_t;
+
+
+class ServoConfig {
+
+  public:
+    static const servoConfig_t &get(uint8_t config) {return configs[config];}
+    static uint8_t change(uint8_t config, const servoConfig_t &value); // returns the entry to use
+    static uint8_t users(uint8_t config);        // Number of servos that use this entry (0 for entry 0)
+
+  private:
+    static servoConfig_t configs[MAX_SERVO_CONFIGS];
+    static uint8_t configUsers[MAX_SERVO_CONFIGS];
+};
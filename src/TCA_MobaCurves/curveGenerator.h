@@ -0,0 +1,233 @@
+//******************************************************************************************************
+//
+// file:      curveGenerator.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Compile-time (constexpr) generation of servo curves.
+//            This file builds curve tables from a mathematical description. It is used for the
+//            predefined curves in curves.cpp that follow such description, and allows a sketch to
+//            build its own curves in the same way.
+//            The curve table is calculated entirely by the compiler, and stored in FLASH_MEMORY;
+//            there are no costs in terms of run time CPU or RAM. Since such curve is defined in
+//            the sketch, only the curves that the sketch actually uses will be linked.
+//
+// Usage:
+//   constexpr auto myCurve FLASH_MEMORY = makeCurve<curveEase, 24, 0, 255, 2>();
+//   servo.initCurveFromTable(myCurve.points, timeStretch);
+// or, to select the curve by index (for queueMove() and ServoProtocol), list it (see curves.h):
+//   SKETCH_CURVES(myCurve.points);
+//   servo.queueMove(sketchCurve(0), direction, timeStretch, dwell);
+//
+// makeCurve() has the following template parameters:
+// - shape:    the mathematical description of the curve (see curveShape_t below)
+// - duration: the time of the last curve point (1..255), in the same units as the predefined curves
+// - from:     the position at the start of the curve (0..255)
+// - to:       the target position of the curve (0..255)
+// - maxError: the maximum deviation (in position units) between the generated curve and the exact
+//             mathematical curve. Default is 2.
+// The curve points are placed such that the deviation remains within maxError, using as few points
+// as possible. If more than SIZE_SERVO_CURVE - 1 points would be needed, a static_assert fails;
+// maxError should then be increased.
+//
+// The available shapes are:
+// - curveLinear:     straight line from "from" to "to"
+// - curveEase:       cosine shaped; starts and stops smoothly (like move_A / move_B)
+// - curveParabola:   from "from" to "to" and back again (like whip_A / whip_B)
+// - curveDampedSine: from "from" to "to", overshoots and settles at "to" (like sig_hp0 / sig_hp1)
+// - curveSine:       half a sine period, from "from" to "to" and back again (sine_A / sine_B)
+// - curveSineWave:   a full sine period: from "from" to "to", to the other side and back (sine_AB)
+//
+// makeCurveAt<shape, from, to, times...>() calculates the positions at the given times, instead of
+// choosing the times itself; the last time is the duration. The predefined curves use it, since their
+// times are fixed by the golden traces of the host model (extras/HostModel/golden). mirrorCurve()
+// returns a curve with each position p replaced by around - p (whip_B is whip_A, mirrored); around - p
+// should stay within 0..255.
+//
+// Note: the constexpr functions below require C++14, which DxCore, megaTinyCore and MegaCoreX provide.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+#include "curves.h"
+
+enum curveShape_t {
+  curveLinear,
+  curveEase,
+  curveParabola,
+  curveDampedSine,
+  curveSine,
+  curveSineWave
+};
+
+#define CURVE_SAMPLES 4                          // Error check per 1/4 time unit
+
+template <uint16_t N>                            // A curve table with N points and the {0, 0} end marker
+struct curveTable_t {
+  curvePoint_t points[N + 1];
+};
+
+
+//******************************************************************************************************
+// constexpr math. The standard cos() and exp() are not constexpr, and therefore can't be used.
+//******************************************************************************************************
+#define CURVE_PI 3.14159265358979
+
+constexpr double curveCos(double x) {            // Taylor series, after reduction to -pi..pi
+  while (x > CURVE_PI) x -= 2 * CURVE_PI;
+  while (x < -CURVE_PI) x += 2 * CURVE_PI;
+  double term = 1;
+  double sum = 1;
+  for (uint8_t i = 1; i < 12; i++) {
+    term = -term * x * x / ((2 * i - 1) * (2 * i));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double curveSin(double x) {
+  return curveCos(x - CURVE_PI / 2);
+}
+
+constexpr double curveExp(double x) {            // Taylor series; 1 / exp(-x) for negative x
+  bool negative = (x < 0);
+  if (negative) x = -x;
+  double term = 1;
+  double sum = 1;
+  for (uint8_t i = 1; i < 30; i++) {
+    term = term * x / i;
+    sum += term;
+  }
+  return negative ? 1 / sum : sum;
+}
+
+
+//******************************************************************************************************
+// The shapes. u runs from 0 (start of the curve) to 1 (end of the curve)
+//******************************************************************************************************
+constexpr double curveShapeValue(curveShape_t shape, double u, uint8_t from, uint8_t to) {
+  double range = (double)to - from;
+  switch (shape) {
+    case curveLinear:     return from + range * u;
+    case curveEase:       return from + range * (1 - curveCos(CURVE_PI * u)) / 2;
+    case curveParabola:   return from + range * (1 - (2 * u - 1) * (2 * u - 1));
+    case curveDampedSine: return to - range * (curveExp(-5 * u) - curveExp(-5)) / (1 - curveExp(-5))
+                                                * curveCos(3 * CURVE_PI * u);
+    case curveSine:       return from + range * curveSin(CURVE_PI * u);
+    case curveSineWave:   return from + range * curveSin(2 * CURVE_PI * u);
+  }
+  return from;
+}
+
+constexpr double curveClamped(curveShape_t shape, double u, uint8_t from, uint8_t to) {
+  double y = curveShapeValue(shape, u, from, to);  // An overshoot may go beyond 0..255
+  if (y < 0) return 0;
+  if (y > 255) return 255;
+  return y;
+}
+
+constexpr uint8_t curvePosition(curveShape_t shape, double u, uint8_t from, uint8_t to) {
+  return (uint8_t)(curveClamped(shape, u, from, to) + 0.5);
+}
+
+
+//******************************************************************************************************
+// Point placement. Starting at the previous point, the next point is placed as far as possible,
+// such that the straight line between both points stays within maxError of the exact curve.
+//******************************************************************************************************
+constexpr bool curveSegmentFits(curveShape_t shape, uint8_t duration, uint8_t from, uint8_t to,
+                                uint8_t maxError, uint8_t t0, uint8_t t1) {
+  double y0 = curvePosition(shape, (double)t0 / duration, from, to);
+  double y1 = curvePosition(shape, (double)t1 / duration, from, to);
+  for (uint16_t i = 1; i < (t1 - t0) * CURVE_SAMPLES; i++) {
+    double t = t0 + (double)i / CURVE_SAMPLES;
+    double line = y0 + (y1 - y0) * (t - t0) / (t1 - t0);
+    double error = line - curveClamped(shape, t / duration, from, to);
+    if ((error > maxError) || (error < -maxError)) return false;
+  }
+  return true;
+}
+
+constexpr uint8_t curveNextTime(curveShape_t shape, uint8_t duration, uint8_t from, uint8_t to,
+                                uint8_t maxError, uint8_t t0) {
+  uint8_t t1 = t0 + 1;
+  while ((t1 < duration) && curveSegmentFits(shape, duration, from, to, maxError, t0, t1 + 1)) t1++;
+  return t1;
+}
+
+constexpr uint16_t curvePointsNeeded(curveShape_t shape, uint8_t duration, uint8_t from, uint8_t to,
+                                     uint8_t maxError) {
+  uint16_t points = 1;
+  for (uint8_t t = 0; t < duration; t = curveNextTime(shape, duration, from, to, maxError, t)) points++;
+  return points;
+}
+
+
+//******************************************************************************************************
+// makeCurve() returns the curve table. All points, including the end marker, are calculated by
+// the compiler.
+//******************************************************************************************************
+template <curveShape_t shape, uint8_t duration, uint8_t from, uint8_t to, uint8_t maxError = 2>
+constexpr curveTable_t<curvePointsNeeded(shape, duration, from, to, maxError)> makeCurve() {
+  static_assert(duration > 0, "The curve duration should be at least 1");
+  static_assert(curvePointsNeeded(shape, duration, from, to, maxError) < SIZE_SERVO_CURVE,
+    "The curve needs too many points: increase maxError");
+  curveTable_t<curvePointsNeeded(shape, duration, from, to, maxError)> table = {};
+  uint8_t i = 0;
+  uint8_t t = 0;
+  while (t < duration) {
+    table.points[i].time = t;
+    table.points[i].position = curvePosition(shape, (double)t / duration, from, to);
+    t = curveNextTime(shape, duration, from, to, maxError, t);
+    i++;
+  }
+  table.points[i].time = duration;
+  table.points[i].position = curvePosition(shape, 1, from, to);
+  table.points[i + 1].time = 0;                  // End marker
+  table.points[i + 1].position = 0;
+  return table;
+}
+
+
+//******************************************************************************************************
+// makeCurveAt() returns the curve table with points at the given times. The end marker follows from
+// the initialisation of the table.
+//******************************************************************************************************
+constexpr bool curveTimesIncrease(uint8_t) {
+  return true;
+}
+
+template <typename... T>
+constexpr bool curveTimesIncrease(uint8_t previous, uint8_t next, T... rest) {
+  return (next > previous) && curveTimesIncrease(next, rest...);
+}
+
+template <curveShape_t shape, uint8_t from, uint8_t to, uint8_t first, uint8_t... times>
+constexpr curveTable_t<sizeof...(times) + 1> makeCurveAt() {
+  static_assert(first == 0, "The first time should be 0");
+  static_assert((sizeof...(times) > 0) && (sizeof...(times) + 1 < SIZE_SERVO_CURVE),
+    "A curve has 2 .. SIZE_SERVO_CURVE - 1 points");
+  static_assert(curveTimesIncrease(first, times...), "The times should increase");
+  const uint8_t time[] = {first, times...};
+  const uint8_t duration = time[sizeof...(times)];
+  curveTable_t<sizeof...(times) + 1> table = {};
+  for (uint8_t i = 0; i <= sizeof...(times); i++) {
+    table.points[i].time = time[i];
+    table.points[i].position = curvePosition(shape, (double)time[i] / duration, from, to);
+  }
+  return table;
+}
+
+
+//******************************************************************************************************
+// mirrorCurve() takes a curve with N points plus the end marker
+//******************************************************************************************************
+template <uint16_t N>
+constexpr curveTable_t<N - 1> mirrorCurve(const curvePoint_t (&curve)[N], uint16_t around) {
+  curveTable_t<N - 1> table = {};
+  for (uint16_t i = 0; i < N - 1; i++) {
+    table.points[i].time = curve[i].time;
+    table.points[i].position = around - curve[i].position;
+  }
+  return table;
+}
@@ -44,21 +44,16 @@
 //******************************************************************************************************
 #include <Arduino.h>
 #include "curves.h"
+#include "curveGenerator.h"
 
-
-const curvePoint_t FLASH_MEMORY lin_A[] = {
-  { 0 , 0 },
-  { 2 , 128 },
-  { 4 , 255 },
-  { 0 , 0 },
-};
-
-const curvePoint_t FLASH_MEMORY lin_B[] = { 
-  { 0 , 255 },
-  { 2 , 128 },
-  { 4 , 0 },
-  { 0 , 0 },
-};
+// -----------------------------------------------------------------------------------------------
+// Curves that follow a mathematical description are calculated by the compiler (see curveGenerator.h),
+// at the times of the original tables; the result equals these tables, as the golden traces of the
+// host model confirm. The other curves (move, whip and the semaphore curves) are OpenDCC data that no
+// formula reproduces exactly, and are kept as tables; changing them would change the movement.
+//
+constexpr auto lin_A FLASH_MEMORY = makeCurveAt<curveLinear, 0, 255, 0, 2, 4>();
+constexpr auto lin_B FLASH_MEMORY = makeCurveAt<curveLinear, 255, 0, 0, 2, 4>();
 
 
 const curvePoint_t FLASH_MEMORY move_A[] = { 
@@ -146,41 +141,11 @@ const curvePoint_t FLASH_MEMORY sig_hp1[] = {
   { 0 , 0 },
 };
 
-const curvePoint_t FLASH_MEMORY sine_A[] = { 
-  { 0 , 128 },
-  { 3 , 186 },
-  { 5 , 218 },
-  { 7 , 241 },
-  { 8 , 249 },
-  { 9 , 253 },
-  { 10 , 255 },
-  { 11 , 253 },
-  { 12 , 249 },
-  { 13 , 241 },
-  { 15 , 218 },
-  { 17 , 186 },
-  { 20 , 128 },
-  { 0 , 0 },
-};
+constexpr auto sine_A FLASH_MEMORY = makeCurveAt<curveSine, 128, 255, 0, 3, 5, 7, 8, 9, 10, 11, 12, 13, 15, 17, 20>();
 
-const curvePoint_t FLASH_MEMORY sine_B[] = { 
-  { 0 , 128 },
-  { 3 , 70 },
-  { 5 , 38 },
-  { 7 , 15 },
-  { 8 , 7 },
-  { 9 , 3 },
-  { 10 , 1 },
-  { 11 , 3 },
-  { 12 , 7 },
-  { 13 , 15 },
-  { 15 , 38 },
-  { 17 , 70 },
-  { 20 , 128 },
-  { 0 , 0 },
-};
+constexpr auto sine_B FLASH_MEMORY = makeCurveAt<curveSine, 128, 1, 0, 3, 5, 7, 8, 9, 10, 11, 12, 13, 15, 17, 20>();
    
-const curvePoint_t FLASH_MEMORY whip_A[] = { 
+constexpr curvePoint_t whip_A[] FLASH_MEMORY = { 
   { 0 , 128 },
   { 1 , 135 },
   { 2 , 145 },
@@ -199,24 +164,7 @@ const curvePoint_t FLASH_MEMORY whip_A[] = {
   { 0 , 0 },
 };
 
-const curvePoint_t FLASH_MEMORY whip_B[] = { 
-  {  0 , 128 },
-  {  1 , 121 },
-  {  2 , 111 },
-  {  3 , 99 },
-  {  4 , 84 },
-  {  5 , 67 },
-  {  6 , 48 },
-  {  8 , 1 },
-  { 10 , 48 },
-  { 11 , 67 },
-  { 12 , 84 },
-  { 13 , 99 },
-  { 14 , 111 },
-  { 15 , 121 },
-  { 16 , 128 },
-  { 0 , 0 },
-};
+constexpr auto whip_B FLASH_MEMORY = mirrorCurve(whip_A, 256);
 
 const curvePoint_t FLASH_MEMORY hp0[] = { 
   { 0 , 230 },
@@ -299,49 +247,42 @@ const curvePoint_t FLASH_MEMORY hp1p[] = {
   { 0 , 0 },
 };
 
-const curvePoint_t FLASH_MEMORY sine_AB[] = { 
-  { 0 , 128 },
-  { 3 , 186 },
-  { 5 , 218 },
-  { 7 , 241 },
-  { 9 , 253 },
-  { 10 , 255 },
-  { 11 , 253 },
-  { 13 , 241 },
-  { 15 , 218 },
-  { 17 , 186 },
-  { 20 , 128 },
-  { 23 , 70 },
-  { 25 , 38 },
-  { 27 , 15 },
-  { 29 , 3 },
-  { 30 , 1 },
-  { 31 , 3 },
-  { 33 , 15 },
-  { 35 , 38 },
-  { 37 , 70 },
-  { 40 , 128 },
-  { 0 , 0 },
-};
+constexpr auto sine_AB FLASH_MEMORY = makeCurveAt<curveSineWave, 128, 255,
+  0, 3, 5, 7, 9, 10, 11, 13, 15, 17, 20, 23, 25, 27, 29, 30, 31, 33, 35, 37, 40>();
 
 // -----------------------------------------------------------------------------------------------
 // The array with (pointers to) the predefined curves differs from that of OpenDCC - OpenDecoder2.
 // In contrast to OpenDCC, the array below does NOT include the EEPROM curves.
-// If the array below gets modified, dom't forget to modify NUMBER_OF_LAST_CURVE in curves.h as well
+// The compiler checks the number of curves against NUMBER_OF_PREDEFINED_CURVES in curves.h.
+// For curves that are specific to a sketch, see curveGenerator.h and SKETCH_CURVES() in curves.h
 //
 // - 2025/04/27: sine_AB added (may be used for testing purposes)
 //
 const curvePoint_t *PredefinedCurves[] = {
-  lin_A,    // 0
-  lin_B,    // 1
-  move_A,   // 2
-  move_B,   // 3
-  sine_A,   // 4
-  sine_B,   // 5
-  whip_A,   // 6
-  whip_B,   // 7
-  sig_hp0,  // 8
-  sig_hp1,  // 9
-  hp1p,     // 10
-  sine_AB,  // 11
+  lin_A.points,    // 0
+  lin_B.points,    // 1
+  move_A,          // 2
+  move_B,          // 3
+  sine_A.points,   // 4
+  sine_B.points,   // 5
+  whip_A,          // 6
+  whip_B.points,   // 7
+  sig_hp0,         // 8
+  sig_hp1,         // 9
+  hp1p,            // 10
+  sine_AB.points,  // 11
 };
+
+static_assert(sizeof(PredefinedCurves) / sizeof(PredefinedCurves[0]) == NUMBER_OF_PREDEFINED_CURVES,
+  "NUMBER_OF_PREDEFINED_CURVES (curves.h) differs from PredefinedCurves[]");
+
+// -----------------------------------------------------------------------------------------------
+// The curves of the sketch (see SKETCH_CURVES() in curves.h) follow the predefined ones. Without
+// SKETCH_CURVES(), the weak reference to numberOfSketchCurves has address 0.
+//
+const curvePoint_t *curveByIndex(uint8_t index) {
+  if (index < NUMBER_OF_PREDEFINED_CURVES) return PredefinedCurves[index];
+  index -= NUMBER_OF_PREDEFINED_CURVES;
+  if ((&numberOfSketchCurves != 0) && (index < numberOfSketchCurves)) return SketchCurves[index];
+  return 0;
+}
@@ -45,7 +45,10 @@
 
 
 #define SIZE_SERVO_CURVE 24                      // Maximum number of curve points withi a curve
-#define NUMBER_OF_LAST_CURVE 11                  // For PROGMEM! Should match the number in curves.cpp.
+#define NUMBER_OF_PREDEFINED_CURVES 12           // Checked by the compiler against PredefinedCurves[]
+#define NUMBER_OF_LAST_CURVE (NUMBER_OF_PREDEFINED_CURVES - 1)
+#define USER_CURVE 254                           // previousCurve, if the curve was not a predefined one
+#define MAX_SKETCH_CURVES (64 - NUMBER_OF_PREDEFINED_CURVES) // Curve indices are 6 bits (0..63)
 
 typedef struct {                                 // A servo curve consists of a sequence of points
   uint8_t time;                                  // counter for the number of 20ms ticks
@@ -53,3 +56,25 @@ typedef struct {                                 // A servo curve consists of a
 } curvePoint_t;
 
 extern const curvePoint_t *PredefinedCurves[];   // The collection of all predefined curves
+
+// Curves of the sketch, such as those from makeCurve() (see curveGenerator.h), get an index after the
+// predefined curves if the sketch lists them, once, at file level:
+//   SKETCH_CURVES(myCurve.points, otherCurve.points);
+// sketchCurve(0) is then the index of myCurve, sketchCurve(1) that of otherCurve. These indices are
+// known to the compiler, and can be used wherever a predefined curve is selected: initCurveFromPROGMEM(),
+// queueMove() and the CMD_CURVE / CMD_QUEUE commands of ServoProtocol. The curves must be stored in
+// FLASH_MEMORY, as the predefined curves are. The list takes no RAM besides its pointers, and without
+// SKETCH_CURVES() there is no list at all: the library refers to it with a weak reference.
+extern const curvePoint_t * const SketchCurves[] __attribute__((weak));
+extern const uint8_t numberOfSketchCurves __attribute__((weak));
+
+#define SKETCH_CURVES(...)                                                                        \
+  const curvePoint_t * const SketchCurves[] = {__VA_ARGS__};                                      \
+  const uint8_t numberOfSketchCurves = sizeof(SketchCurves) / sizeof(SketchCurves[0]);            \
+  static_assert(sizeof(SketchCurves) / sizeof(SketchCurves[0]) <= MAX_SKETCH_CURVES, "Too many curves in SKETCH_CURVES()")
+
+constexpr uint8_t sketchCurve(uint8_t n) {       // Index of the n-th curve of SKETCH_CURVES()
+  return NUMBER_OF_PREDEFINED_CURVES + n;
+}
+
+const curvePoint_t *curveByIndex(uint8_t index); // Predefined or sketch curve; 0 if there is none
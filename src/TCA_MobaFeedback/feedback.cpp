@@ -0,0 +1,204 @@
+//******************************************************************************************************
+//
+// file:      feedback.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Frame-synchronised ADC sampling for the ServoMoba and ServoMoba1 classes.
+//            See feedback.h for details.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include "feedback.h"
+#include "../TCA_Clock/tickScale.h"
+
+// Only DxCore has a TCB that can be clocked by the TCA, and generators that fit any event channel.
+// Of these parts, the EA and EB have another ADC, with a RESULT register and without event input.
+#if defined(SERVO_FEEDBACK) && !defined(MEGATINYCORE_SERIES) && !defined(MEGACOREX) && defined(ADC0_RES)
+
+#define NO_TIMER                255
+#define NO_INPUT                255
+#define NO_SERVO                255
+#define BUFFER_MASK            (FEEDBACK_BUFFER_SIZE - 1)
+
+static uint8_t timer = NO_TIMER;                 // The TCA whose servos are sampled
+static uint8_t (*slotServo)(uint8_t ahead);      // getSlotServo() of that timer
+static uint16_t offset = FEEDBACK_DEFAULT_OFFSET;
+static uint8_t muxpos[FEEDBACK_SERVOS] = {NO_INPUT, NO_INPUT, NO_INPUT};
+static volatile uint8_t muxedServo = NO_SERVO;   // The servo for which MUXPOS is currently set
+static volatile uint16_t latest[FEEDBACK_SERVOS];
+static volatile uint8_t fresh = 0;               // Bit n: latest[n] has not yet been read by get()
+static void (*callback)(uint8_t servo, uint16_t value) = 0;
+
+static feedbackSample_t buffer[FEEDBACK_BUFFER_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint16_t lostSamples = 0;
+
+
+//******************************************************************************************************
+// Start and stop of the chain TCA overflow -> TCB single shot -> ADC0 start
+//******************************************************************************************************
+static void startSampling() {
+  FEEDBACK_TCB.CTRLA = 0;
+  FEEDBACK_TCB.CCMP = ServoTicks::usToTicks(offset);
+  FEEDBACK_TCB.CTRLB = TCB_CNTMODE_SINGLE_gc;
+  FEEDBACK_TCB.EVCTRL = TCB_CAPTEI_bm;
+  FEEDBACK_TCB.INTCTRL = 0;
+  // The generator values of the CHANNEL0 names are the same for all channels
+#if defined(TCA1)
+  if (timer == 1) {
+    FEEDBACK_TCB.CTRLA = TCB_CLKSEL_TCA1_gc | TCB_ENABLE_bm;
+    (&EVSYS.CHANNEL0)[FEEDBACK_EVENT_CHANNEL] = EVSYS_CHANNEL0_TCA1_OVF_LUNF_gc;
+  }
+  else
+#endif
+  {
+    FEEDBACK_TCB.CTRLA = TCB_CLKSEL_TCA0_gc | TCB_ENABLE_bm;
+    (&EVSYS.CHANNEL0)[FEEDBACK_EVENT_CHANNEL] = EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc;
+  }
+  (&EVSYS.CHANNEL0)[FEEDBACK_EVENT_CHANNEL + 1] = FEEDBACK_TCB_GENERATOR;
+  EVSYS.FEEDBACK_TCB_USER = FEEDBACK_EVENT_CHANNEL + 1;       // EVSYS_USER_CHANNELn_gc is n + 1
+  EVSYS.USERADC0START = FEEDBACK_EVENT_CHANNEL + 2;
+  muxedServo = NO_SERVO;                         // The first conversion is discarded
+  ADC0.MUXPOS = ADC_MUXPOS_GND_gc;
+  ADC0.INTFLAGS = ADC_RESRDY_bm;
+  ADC0.EVCTRL = ADC_STARTEI_bm;
+  ADC0.INTCTRL = ADC_RESRDY_bm;
+  ADC0.CTRLA |= ADC_ENABLE_bm;
+}
+
+static void stopSampling() {
+  ADC0.INTCTRL = 0;
+  ADC0.EVCTRL = 0;
+  EVSYS.USERADC0START = 0;
+  EVSYS.FEEDBACK_TCB_USER = 0;
+  FEEDBACK_TCB.CTRLA = 0;
+  timer = NO_TIMER;
+}
+
+
+//******************************************************************************************************
+// The ADC interrupt runs once per slot, after the TCA interrupt of that slot (the TCA overflow
+// vector has the higher priority, and the offset plus conversion time ends within the slot).
+// getSlotServo() therefore tells which servo the result belongs to.
+//******************************************************************************************************
+ISR(ADC0_RESRDY_vect) {
+  uint16_t value = ADC0.RES;
+  ADC0.INTFLAGS = ADC_RESRDY_bm;
+  uint8_t servo = slotServo(0);
+  uint8_t next = slotServo(1);
+  bool valid = (servo < FEEDBACK_SERVOS) && (servo == muxedServo);
+  // Select the input for the conversion in the next slot
+  if ((next < FEEDBACK_SERVOS) && (muxpos[next] != NO_INPUT)) {
+    ADC0.MUXPOS = muxpos[next];
+    muxedServo = next;
+  }
+  else {
+    ADC0.MUXPOS = ADC_MUXPOS_GND_gc;
+    muxedServo = NO_SERVO;
+  }
+  if (!valid) return;
+  latest[servo] = value;
+  fresh |= (1 << servo);
+  if ((uint8_t)(head - tail) < FEEDBACK_BUFFER_SIZE) {
+    buffer[head & BUFFER_MASK].servo = servo;
+    buffer[head & BUFFER_MASK].value = value;
+    head++;
+  }
+  else lostSamples++;
+  if (callback) callback(servo, value);
+}
+
+
+//******************************************************************************************************
+bool ServoFeedback::attach(uint8_t timerNumber, uint8_t servo, uint8_t analogPin,
+                           uint8_t (*getSlotServo)(uint8_t ahead)) {
+  if (servo >= FEEDBACK_SERVOS) return false;
+  uint8_t input = digitalPinToAnalogInput(analogPin);
+  if (input == NOT_A_PIN) return false;
+  if ((timer != NO_TIMER) && (timer != timerNumber)) return false;   // One ADC, one timer
+#if !defined(TCA1)
+  if (timerNumber != 0) return false;
+#endif
+  uint8_t oldSREG = SREG;
+  cli();
+  muxpos[servo] = input;
+  if (timer == NO_TIMER) {
+    timer = timerNumber;
+    slotServo = getSlotServo;
+    startSampling();
+  }
+  SREG = oldSREG;
+  return true;
+}
+
+
+void ServoFeedback::detach(uint8_t servo) {
+  if (servo >= FEEDBACK_SERVOS) return;
+  uint8_t oldSREG = SREG;
+  cli();
+  muxpos[servo] = NO_INPUT;
+  fresh &= ~(1 << servo);
+  bool used = false;
+  for (uint8_t i = 0; i < FEEDBACK_SERVOS; i++) if (muxpos[i] != NO_INPUT) used = true;
+  if (!used && (timer != NO_TIMER)) stopSampling();
+  SREG = oldSREG;
+}
+
+
+void ServoFeedback::setOffset(uint16_t value) {
+  offset = (value > FEEDBACK_MAX_OFFSET) ? FEEDBACK_MAX_OFFSET : value;
+  if (timer != NO_TIMER) FEEDBACK_TCB.CCMP = ServoTicks::usToTicks(offset);
+}
+
+
+void ServoFeedback::onSample(void (*function)(uint8_t servo, uint16_t value)) {
+  uint8_t oldSREG = SREG;
+  cli();
+  callback = function;
+  SREG = oldSREG;
+}
+
+
+// latest[] is 16 bit, and the flag must be read and cleared together, so interrupts are disabled
+bool ServoFeedback::get(uint8_t servo, uint16_t &value) {
+  if (servo >= FEEDBACK_SERVOS) return false;
+  uint8_t oldSREG = SREG;
+  cli();
+  value = latest[servo];
+  bool isNew = fresh & (1 << servo);
+  fresh &= ~(1 << servo);
+  SREG = oldSREG;
+  return isNew;
+}
+
+
+bool ServoFeedback::read(feedbackSample_t &sample) {
+  if (tail == head) return false;
+  sample = buffer[tail & BUFFER_MASK];           // The ISR does not touch this entry until tail moves
+  tail++;
+  return true;
+}
+
+
+uint16_t ServoFeedback::lost() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t value = lostSamples;
+  SREG = oldSREG;
+  return value;
+}
+
+
+#else   // Switched off, or not available on megaTinyCore, MegaCoreX and the AVR EA / EB
+
+bool ServoFeedback::attach(uint8_t, uint8_t, uint8_t, uint8_t (*)(uint8_t)) {return false;}
+void ServoFeedback::detach(uint8_t) {}
+void ServoFeedback::setOffset(uint16_t) {}
+void ServoFeedback::onSample(void (*)(uint8_t, uint16_t)) {}
+bool ServoFeedback::get(uint8_t, uint16_t &) {return false;}
+bool ServoFeedback::read(feedbackSample_t &) {return false;}
+uint16_t ServoFeedback::lost() {return 0;}
+
+#endif
@@ -0,0 +1,95 @@
+//******************************************************************************************************
+//
+// file:      feedback.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Frame-synchronised ADC sampling for the ServoMoba and ServoMoba1 classes.
+//            Some servos have a feedback line (the voltage of their potentiometer), and the current
+//            of a servo can be measured with a small shunt resistor. Reading such signals with
+//            analogRead() from the main loop gives samples at random moments within the 20 ms
+//            frame; a current sample may then fall before, during or after the motor drive that
+//            follows each pulse. Here each servo is sampled once per frame, at the same moment
+//            within its own slot (see servo_TCA0.h), without any CPU involvement:
+//
+//            TCA overflow (slot start) --EVSYS--> TCB single shot (offset) --EVSYS--> ADC0 start
+//
+//            The TCB is clocked by the TCA clock, so the offset is in the same ticks as the pulses.
+//            Its CAPT event starts the conversion; once the result is ready the ADC interrupt stores
+//            it for the servo whose slot is running, and selects the input of the servo of the next
+//            slot. Conversions for slots without a servo (or without a feedback input) are discarded.
+//
+// The samples can be used in three ways:
+// - get(): the latest sample of a servo. ServoMoba uses this for settling and stall detection (see
+//   ServoMoba::setSettle() and ServoMoba::setStall()).
+// - read(): all samples, in order, from a small ring buffer. If the buffer is full, new samples are
+//   dropped and counted (see lost()).
+// - onSample(): a callback, called from the ADC interrupt. It should be very short.
+//
+// Feedback sampling is switched off by default. Arduino links every object file of a library, and the
+// ADC result interrupt would otherwise be part of each sketch, which then can't have an ADC interrupt
+// of its own. To switch it on, remove the comment before the #define SERVO_FEEDBACK below (or add
+// -DSERVO_FEEDBACK to the compiler flags). If it is off, attach() returns false.
+//
+// Restrictions:
+// - DxCore only, on parts whose ADC has a RES register and can be started by an event (AVR DA, DB
+//   and DD): the TCB must be clocked by the TCA (TCB_CLKSEL_TCA0 / TCA1), and the event system
+//   must be able to route TCA and TCB events to any channel. On other parts attach() returns false.
+//   Servos on TCA1 can only be sampled on parts that have TCA1.
+// - There is only one ADC: the feedback inputs must all belong to servos on the same TCA timer.
+// - The ADC is used with the settings of the core (resolution, reference and prescaler, see
+//   analogReadResolution() and analogReference()). analogRead() should not be used by the sketch
+//   while feedback sampling is active.
+// - The TCB and the two event channels below should not be used by the sketch, and the TCB must not
+//   be the one used for millis().
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+// #define SERVO_FEEDBACK                        // Uncomment to switch feedback sampling on
+
+#ifndef FEEDBACK_TCB                             // The TCB, its event user and its CAPT generator
+#define FEEDBACK_TCB              TCB1
+#define FEEDBACK_TCB_USER         USERTCB1CAPT
+#define FEEDBACK_TCB_GENERATOR    EVSYS_CHANNEL0_TCB1_CAPT_gc   // The same for all channels
+#endif
+#ifndef FEEDBACK_EVENT_CHANNEL
+#define FEEDBACK_EVENT_CHANNEL    4              // This channel, and the next
+#endif
+#define FEEDBACK_SERVOS           3              // SERVOS_PER_TIMER
+#define FEEDBACK_BUFFER_SIZE      8              // Samples in the ring buffer. Must be a power of 2
+#define FEEDBACK_DEFAULT_OFFSET   2500           // us after the start of the slot
+#define FEEDBACK_MAX_OFFSET       6000           // The conversion must finish within the slot (6666 us)
+
+typedef struct {
+  uint8_t servo;                                 // servoIndex: 0..2
+  uint16_t value;                                // ADC result
+} feedbackSample_t;
+
+typedef struct {                                 // Settling and stall state of a ServoMoba servo
+  uint16_t latest;                               // The latest sample, as seen by checkServo()
+  int16_t atTreshold1;                           // Sample at treshold1
+  int16_t atTreshold2;                           // Sample at treshold2
+  int16_t settleTarget;                          // Sample at the end of the current movement
+  uint8_t stallCount;                            // Consecutive frames above the stall limit
+} servoFeedback_t;
+
+
+class ServoFeedback {
+
+  public:
+    static bool attach(                          // Called by ServoMoba::initFeedback()
+      uint8_t timer,                             // 0 = TCA0, 1 = TCA1
+      uint8_t servo,                             // servoIndex
+      uint8_t analogPin,
+      uint8_t (*slotServo)(uint8_t ahead)        // Servo::getSlotServo or Servo1::getSlotServo
+    );                                           // returns false if not possible (see above)
+    static void detach(uint8_t servo);
+    static void setOffset(uint16_t offset);      // In us after the start of the slot, 0..FEEDBACK_MAX_OFFSET
+    static void onSample(void (*callback)(uint8_t servo, uint16_t value));   // 0 removes the callback
+
+    static bool get(uint8_t servo, uint16_t &value); // Latest sample; returns true if it is new
+    static bool read(feedbackSample_t &sample);  // From the ring buffer; returns false if empty
+    static uint16_t lost();                      // Samples dropped because the ring buffer was full
+};
@@ -0,0 +1,117 @@
+//******************************************************************************************************
+//
+// file:      servo_TCA_Group.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   A group of ServoMoba / ServoMoba1 objects, that is serviced by a single call from the 
+//            main loop. See Servo_TCA_Group.h for details.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include "../Servo_TCA_Group.h"
+
+
+ServoGroup::ServoGroup() {
+  membersTCA0 = 0;
+  #if defined(TCA1)
+  membersTCA1 = 0;
+  #endif
+}
+
+
+uint8_t ServoGroup::add(ServoMoba &servo) {
+  uint8_t index = servo.getServoIndex();
+  if (index >= SERVOS_PER_TIMER) return INVALID_SERVO;
+  servoTCA0[index] = &servo;
+  membersTCA0 |= (1 << index);
+  return index;
+}
+
+
+#if defined(TCA1)
+uint8_t ServoGroup::add(ServoMoba1 &servo) {
+  uint8_t index = servo.getServoIndex();
+  if (index >= SERVOS_PER_TIMER) return INVALID_SERVO;
+  servoTCA1[index] = &servo;
+  membersTCA1 |= (1 << index);
+  return index + SERVOS_PER_TIMER;
+}
+#endif
+
+
+uint8_t ServoGroup::getMembers() {
+  uint8_t members = membersTCA0;
+  #if defined(TCA1)
+  members |= (membersTCA1 << SERVOS_PER_TIMER);
+  #endif
+  return members;
+}
+
+
+//******************************************************************************************************
+// checkServos() replaces the individual checkServo() calls. Only the servos whose bit has been set 
+// by the ISR are serviced; if no frame has started since the previous call, the costs are limited 
+// to reading the two bit masks.
+//******************************************************************************************************
+uint8_t ServoGroup::checkServos() {
+  uint8_t ready = Servo::readyServos(membersTCA0);
+  uint8_t serviced = ready;
+  for (uint8_t i = 0; ready; i++) {
+    if (ready & 1) servoTCA0[i]->checkServo();
+    ready >>= 1;
+  }
+  #if defined(TCA1)
+  ready = Servo1::readyServos(membersTCA1);
+  serviced |= (ready << SERVOS_PER_TIMER);
+  for (uint8_t i = 0; ready; i++) {
+    if (ready & 1) servoTCA1[i]->checkServo();
+    ready >>= 1;
+  }
+  #endif
+  return serviced;
+}
+
+
+//******************************************************************************************************
+// moveTogether() determines the longest start phase and the longest curve of all selected servos. 
+// All curves are then set to that longest duration, and servos with a shorter start phase get an 
+// additional delay. Since all moveServoAlongCurve() calls are made here, within the same 20ms 
+// frame, all curves start at the same frame and therefore also end at the same frame.
+//******************************************************************************************************
+uint16_t ServoGroup::moveTogether(uint8_t members, uint8_t directions) {
+  uint8_t maxStart = 0;
+  uint16_t maxCurve = 0;
+  uint8_t selected = members & membersTCA0;
+  for (uint8_t i = 0; i < SERVOS_PER_TIMER; i++) {
+    if (selected & (1 << i)) {
+      if (servoTCA0[i]->getStartDuration() > maxStart) maxStart = servoTCA0[i]->getStartDuration();
+      if (servoTCA0[i]->getCurveDuration() > maxCurve) maxCurve = servoTCA0[i]->getCurveDuration();
+    }
+  }
+  #if defined(TCA1)
+  uint8_t selected1 = (members >> SERVOS_PER_TIMER) & membersTCA1;
+  for (uint8_t i = 0; i < SERVOS_PER_TIMER; i++) {
+    if (selected1 & (1 << i)) {
+      if (servoTCA1[i]->getStartDuration() > maxStart) maxStart = servoTCA1[i]->getStartDuration();
+      if (servoTCA1[i]->getCurveDuration() > maxCurve) maxCurve = servoTCA1[i]->getCurveDuration();
+    }
+  }
+  #endif
+  for (uint8_t i = 0; i < SERVOS_PER_TIMER; i++) {
+    if (selected & (1 << i)) {
+      servoTCA0[i]->setCurveDuration(maxCurve);
+      servoTCA0[i]->moveServoAlongCurve((directions >> i) & 1, maxStart - servoTCA0[i]->getStartDuration());
+    }
+  }
+  #if defined(TCA1)
+  for (uint8_t i = 0; i < SERVOS_PER_TIMER; i++) {
+    if (selected1 & (1 << i)) {
+      servoTCA1[i]->setCurveDuration(maxCurve);
+      servoTCA1[i]->moveServoAlongCurve((directions >> (i + SERVOS_PER_TIMER)) & 1, 
+        maxStart - servoTCA1[i]->getStartDuration());
+    }
+  }
+  #endif
+  return maxStart + maxCurve;
+}
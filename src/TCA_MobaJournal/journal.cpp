@@ -0,0 +1,99 @@
+//******************************************************************************************************
+//
+// file:      journal.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Persistent position journal for the ServoMoba and ServoMoba1 classes.
+//            See journal.h for details.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "journal.h"
+
+static uint8_t checksum(const uint8_t *record) {
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < JOURNAL_RECORD_SIZE - 1; i++) sum += record[i];
+  return ~sum;                                   // Erased (0xFF) or cleared (0x00) records are invalid
+}
+
+
+//******************************************************************************************************
+// init() scans the block once. The newest valid record is returned via entry; the next record will
+// be written in the slot that follows it. A block with less than two records is not used.
+//******************************************************************************************************
+bool PositionJournal::init(uint16_t address, uint8_t records, journalEntry_t &entry) {
+  if (records < JOURNAL_MIN_RECORDS) {
+    this->records = 0;                           // No journal
+    toWrite = 0;
+    return false;
+  }
+  if (records > JOURNAL_MAX_RECORDS) records = JOURNAL_MAX_RECORDS;
+  this->address = address;
+  this->records = records;
+  toWrite = 0;
+  hasNewest = false;
+  slot = records - 1;                            // Without valid records, start with slot 0
+  sequence = 0xFF;
+  uint8_t record[JOURNAL_RECORD_SIZE];
+  for (uint8_t i = 0; i < records; i++) {
+    uint16_t recordAddress = address + i * JOURNAL_RECORD_SIZE;
+    for (uint8_t j = 0; j < JOURNAL_RECORD_SIZE; j++) record[j] = EEPROM.read(recordAddress + j);
+    if (record[JOURNAL_RECORD_SIZE - 1] != checksum(record)) continue;
+    if (hasNewest && ((uint8_t)(record[0] - sequence) >= 128)) continue;   // Older than the newest
+    hasNewest = true;
+    slot = i;
+    sequence = record[0];
+    newest.pulseWidth = record[1] | (record[2] << 8);
+    newest.treshold1 = record[3] | (record[4] << 8);
+    newest.treshold2 = record[5] | (record[6] << 8);
+  }
+  if (hasNewest) entry = newest;
+  return hasNewest;
+}
+
+
+//******************************************************************************************************
+// write() prepares the record; step() writes it. If the previous record has not been written
+// completely, its slot is reused. The record is not kept as a byte array: step() derives each byte
+// from sequence and newest, which saves 8 bytes of RAM per servo.
+//******************************************************************************************************
+void PositionJournal::write(const journalEntry_t &entry) {
+  if (records == 0) return;
+  if (hasNewest && (entry.pulseWidth == newest.pulseWidth) && (entry.treshold1 == newest.treshold1)
+      && (entry.treshold2 == newest.treshold2)) return;
+  if (toWrite == 0) {
+    slot++;
+    if (slot >= records) slot = 0;
+    sequence++;
+  }
+  newest = entry;
+  hasNewest = true;
+  toWrite = JOURNAL_RECORD_SIZE;
+}
+
+
+void PositionJournal::step() {
+  if (toWrite == 0) return;
+  if (NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm) return;  // An earlier write has not yet finished
+  uint8_t i = JOURNAL_RECORD_SIZE - toWrite;
+  EEPROM.update(address + slot * JOURNAL_RECORD_SIZE + i, recordByte(i));
+  toWrite--;
+}
+
+
+uint8_t PositionJournal::recordByte(uint8_t i) {
+  switch (i) {
+    case 0: return sequence;
+    case 1: return newest.pulseWidth & 0xFF;
+    case 2: return newest.pulseWidth >> 8;
+    case 3: return newest.treshold1 & 0xFF;
+    case 4: return newest.treshold1 >> 8;
+    case 5: return newest.treshold2 & 0xFF;
+    case 6: return newest.treshold2 >> 8;
+  }
+  uint8_t record[JOURNAL_RECORD_SIZE];
+  for (uint8_t j = 0; j < JOURNAL_RECORD_SIZE - 1; j++) record[j] = recordByte(j);
+  return checksum(record);
+}
@@ -0,0 +1,71 @@
+//******************************************************************************************************
+//
+// file:      journal.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Persistent position journal for the ServoMoba and ServoMoba1 classes.
+//            After power-up a servo should get pulses for exactly the position it had before power
+//            was switched off; otherwise it jumps. Instead of moving each servo to a known position
+//            at start-up (which is slow and visible), the position that was reached at the end of
+//            each movement is stored in EEPROM, together with both tresholds. At start-up the
+//            journal is read, and the pulses can resume at the last position without any movement.
+//
+// Each servo has its own journal: a block of EEPROM with room for a number of records. Records are
+// written one after the other, and the block is used as a ring; this spreads the wear over all
+// records in the block. Each record contains:
+// - byte 0:    sequence number. The newest record is the one with the highest sequence number
+//              (modulo 256). Since a block holds less than 128 records, this is unambiguous.
+// - byte 1..2: the pulse width (in us) at the end of the movement
+// - byte 3..4: treshold1
+// - byte 5..6: treshold2
+// - byte 7:    checksum. A record that was only partially written (power failed during writing)
+//              or erased EEPROM (0xFF) thus never counts as a valid record.
+// The journal is read with a single scan over its block at start-up. Its duration depends on the
+// block size only, and is in the order of a few microseconds per record.
+//
+// Writing an EEPROM byte takes several milliseconds. To avoid that checkServo() has to wait, step()
+// writes a single byte, and only if the EEPROM is not busy with an earlier write. checkServo() calls
+// step() once per 20 ms frame, so a record is written within 8 frames (if there are no other EEPROM
+// writes). Bytes that already have the right value are not written again.
+// The record that is being written is never the newest valid one, so a block needs at least two
+// records. init() rejects a smaller block (and returns false); a larger block is limited to
+// JOURNAL_MAX_RECORDS.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+#define JOURNAL_RECORD_SIZE   8                  // bytes per record
+#define JOURNAL_MIN_RECORDS   2                  // With one record, a power failure while writing it loses all
+#define JOURNAL_MAX_RECORDS 127                  // See the explanation of the sequence number above
+
+typedef struct {                                 // The content of a journal record
+  uint16_t pulseWidth;                           // in us
+  int16_t treshold1;
+  int16_t treshold2;
+} journalEntry_t;
+
+
+class PositionJournal {
+
+  // There is no constructor: the journals are static arrays of servo_TCA0/1_MoBa.cpp, and start with
+  // records and toWrite 0. Without constructor, they are not linked if initJournal() is not used.
+  public:
+    bool init(uint16_t address, uint8_t records, journalEntry_t &entry); // true if a valid record was found,
+                                                 // false if none was found or records < JOURNAL_MIN_RECORDS
+    void write(const journalEntry_t &entry);     // Stores entry, unless it equals the newest record
+    void step();                                 // Writes the next byte, if the EEPROM is ready
+    bool busy() {return (toWrite > 0);}          // Not all bytes of the latest record have been written
+    bool active() {return (records > 0);}        // init() has been called
+
+  private:
+    uint16_t address;                            // First byte of the block
+    uint8_t records;                             // Number of records in the block (0: no journal)
+    uint8_t slot;                                // The record that is (or was last) written
+    uint8_t sequence;                            // Sequence number of that record
+    uint8_t toWrite;                             // Bytes still to write (0: nothing to do)
+    journalEntry_t newest;                       // The content of the newest record
+    bool hasNewest;
+    uint8_t recordByte(uint8_t i);               // Byte i of the record as it should appear in EEPROM
+};
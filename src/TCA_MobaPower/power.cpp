@@ -0,0 +1,97 @@
+//******************************************************************************************************
+//
+// file:      power.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Management of the servo power, shared by the ServoMoba and ServoMoba1 classes.
+//            See power.h for details.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include "power.h"
+
+uint8_t ServoPower::numberOfRails = 0;
+uint8_t ServoPower::railPin[MAX_POWER_RAILS];
+PORT_t *ServoPower::railPort[MAX_POWER_RAILS];
+uint8_t ServoPower::railMask[MAX_POWER_RAILS];
+uint8_t ServoPower::railEnableValue = 0;
+uint8_t ServoPower::railCount[MAX_POWER_RAILS];
+uint16_t ServoPower::budget = 0;
+uint16_t ServoPower::inUse = 0;
+
+
+//******************************************************************************************************
+// Rails
+// attachRail() returns the existing rail if the pin is already in use; otherwise a new rail is made,
+// with its pin set as output and the power switched off. 
+//******************************************************************************************************
+uint8_t ServoPower::attachRail(uint8_t pin, uint8_t enableValue) {
+  for (uint8_t rail = 0; rail < numberOfRails; rail++) {
+    if (railPin[rail] == pin) return rail;
+  }
+  if (numberOfRails >= MAX_POWER_RAILS) return NO_RAIL;
+  if (digitalPinToBitMask(pin) == 0) return NO_RAIL;               // Not a valid pin
+  uint8_t rail = numberOfRails++;
+  railPin[rail] = pin;
+  railPort[rail] = digitalPinToPortStruct(pin);
+  railMask[rail] = digitalPinToBitMask(pin);
+  railCount[rail] = 0;
+  if (enableValue) railEnableValue |= (1 << rail);
+  // Switch power off, before the pin becomes an output
+  if (enableValue) railPort[rail]->OUTCLR = railMask[rail];
+    else railPort[rail]->OUTSET = railMask[rail];
+  railPort[rail]->DIRSET = railMask[rail];
+  return rail;
+}
+
+
+void ServoPower::railOn(uint8_t rail) {
+  if (rail >= numberOfRails) return;
+  if (railCount[rail]++ > 0) return;                               // Power is already on
+  if (railEnableValue & (1 << rail)) railPort[rail]->OUTSET = railMask[rail];
+    else railPort[rail]->OUTCLR = railMask[rail];
+}
+
+
+void ServoPower::railOff(uint8_t rail) {
+  if (rail >= numberOfRails) return;
+  if (railCount[rail] == 0) return;
+  if (--railCount[rail] > 0) return;                               // Other servos still need power
+  if (railEnableValue & (1 << rail)) railPort[rail]->OUTCLR = railMask[rail];
+    else railPort[rail]->OUTSET = railMask[rail];
+}
+
+
+uint8_t ServoPower::railUsers(uint8_t rail) {
+  if (rail >= numberOfRails) return 0;
+  return railCount[rail];
+}
+
+
+//******************************************************************************************************
+// Current budget
+//******************************************************************************************************
+void ServoPower::setBudget(uint16_t current) {
+  budget = current;
+}
+
+
+// A servo that on its own needs more than the budget, is allowed to move if no other servo is moving.
+// Otherwise it would wait forever.
+bool ServoPower::requestCurrent(uint16_t current) {
+  if ((budget > 0) && (inUse > 0) && (inUse + current > budget)) return false;
+  inUse += current;
+  return true;
+}
+
+
+void ServoPower::releaseCurrent(uint16_t current) {
+  if (current > inUse) inUse = 0;
+    else inUse -= current;
+}
+
+
+uint16_t ServoPower::getCurrentInUse() {
+  return inUse;
+}
@@ -0,0 +1,54 @@
+//******************************************************************************************************
+//
+// file:      power.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Management of the servo power, shared by the ServoMoba and ServoMoba1 classes.
+//
+// 1) Power rails
+//    In practice several servos often share a single (MOSFET switched) power rail. If each servo 
+//    would switch that rail on its own, switching off the rail for one servo could cut the power of 
+//    another servo that is still moving. Therefore each power enable pin becomes a "rail", which
+//    keeps count of the servos that need power. The rail is switched on by the first servo that
+//    needs power, and switched off once the last servo has released it. 
+//    Rails are switched by writing directly to the port's OUTSET / OUTCLR registers.
+// 2) Current budget
+//    Starting many servos at the same moment may cause brown-outs on small 5V supplies. With 
+//    setBudget() the total current for all servos that are starting or moving can be limited. 
+//    A servo that would exceed the budget waits in its start state, and retries every 20ms frame;
+//    starts beyond the budget are therefore staggered frame by frame. 
+//    The current that a servo needs while moving is set with ServoMoba::setMoveCurrent().
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+#define MAX_POWER_RAILS     6                   // One per servo is the maximum that makes sense
+#define NO_RAIL           255                   // The servo has no power enable pin
+
+
+class ServoPower {
+
+  public:
+    static uint8_t attachRail(uint8_t pin, uint8_t enableValue); // returns the rail, or NO_RAIL
+    static void railOn(uint8_t rail);            // One more servo needs power
+    static void railOff(uint8_t rail);           // One servo less needs power
+    static uint8_t railUsers(uint8_t rail);      // Number of servos that need power from this rail
+
+    static void setBudget(uint16_t current);     // In mA. 0 means: no limit
+    static bool requestCurrent(uint16_t current);// In mA. Returns true if the budget allows it
+    static void releaseCurrent(uint16_t current);// In mA. 
+    static uint16_t getCurrentInUse();           // In mA
+
+  private:
+    // The rails are stored as parallel arrays
+    static uint8_t numberOfRails;
+    static uint8_t railPin[MAX_POWER_RAILS];     // Used to find an existing rail
+    static PORT_t *railPort[MAX_POWER_RAILS];    // The port the enable pin belongs to
+    static uint8_t railMask[MAX_POWER_RAILS];    // The bit within that port
+    static uint8_t railEnableValue;              // Bit n: rail n is enabled with a HIGH signal
+    static uint8_t railCount[MAX_POWER_RAILS];   // Number of servos that need power
+    static uint16_t budget;
+    static uint16_t inUse;
+};
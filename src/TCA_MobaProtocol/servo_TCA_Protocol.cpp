@@ -0,0 +1,321 @@
+//******************************************************************************************************
+//
+// file:      servo_TCA_Protocol.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Compact binary command and telemetry protocol for ServoMoba / ServoMoba1 objects.
+//            See Servo_TCA_Protocol.h for details.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include "../Servo_TCA_Protocol.h"
+
+static uint8_t crc8(uint8_t crc, uint8_t data) {   // Polynomial x^8 + x^2 + x + 1 (0x07)
+  crc ^= data;
+  for (uint8_t i = 0; i < 8; i++) {
+    if (crc & 0x80) crc = (crc << 1) ^ 0x07;
+      else crc <<= 1;
+  }
+  return crc;
+}
+
+
+ServoProtocol::ServoProtocol(ServoTransport &transport): transport(transport) {
+  for (uint8_t i = 0; i < SERVOS_PER_TIMER; i++) {
+    servoTCA0[i] = 0;
+    #if defined(TCA1)
+    servoTCA1[i] = 0;
+    #endif
+  }
+  rxState = waitSync;
+  rxCount = 0;
+  txLength = 0;
+  txSent = 0;
+  frames = 0;
+  errors = 0;
+}
+
+
+uint8_t ServoProtocol::add(ServoMoba &servo) {
+  uint8_t index = servo.getServoIndex();
+  if (index >= SERVOS_PER_TIMER) return INVALID_SERVO;
+  servoTCA0[index] = &servo;
+  return index;
+}
+
+
+#if defined(TCA1)
+uint8_t ServoProtocol::add(ServoMoba1 &servo) {
+  uint8_t index = servo.getServoIndex();
+  if (index >= SERVOS_PER_TIMER) return INVALID_SERVO;
+  servoTCA1[index] = &servo;
+  return index + SERVOS_PER_TIMER;
+}
+#endif
+
+
+uint16_t ServoProtocol::getFrames() {
+  return frames;
+}
+
+
+uint16_t ServoProtocol::getErrors() {
+  return errors;
+}
+
+
+//******************************************************************************************************
+// poll() first continues sending the previous reply. As long as that reply has not been sent
+// completely, no new frame is received; the transport (or the controller) has to wait.
+//******************************************************************************************************
+bool ServoProtocol::poll() {
+  sendReply();
+  if (txLength > 0) return false;
+  for (uint8_t i = 0; i < PROTOCOL_BYTES_PER_POLL; i++) {
+    if (transport.available() <= 0) return false;
+    int data = transport.read();
+    if (data < 0) return false;
+    uint8_t c = data;
+    switch (rxState) {
+      case waitSync:
+        if (c == PROTOCOL_SYNC) rxState = waitLength;
+      break;
+      case waitLength:
+        if (c > PROTOCOL_MAX_PAYLOAD) {rxState = waitSync; errors++; break;}
+        rx[0] = c;
+        rxCrc = crc8(0, c);
+        rxCount = 0;
+        rxState = waitCommand;
+      break;
+      case waitCommand:
+        rx[1] = c;
+        rxCrc = crc8(rxCrc, c);
+        rxState = (rx[0] > 0) ? waitPayload : waitCrc;
+      break;
+      case waitPayload:
+        rx[2 + rxCount++] = c;
+        rxCrc = crc8(rxCrc, c);
+        if (rxCount == rx[0]) rxState = waitCrc;
+      break;
+      case waitCrc:
+        rxState = waitSync;
+        if (c != rxCrc) {errors++; break;}
+        frames++;
+        execute();
+        sendReply();
+        return true;
+    }
+  }
+  return false;
+}
+
+
+//******************************************************************************************************
+// Execution of the commands. The payload is used where it is, in the receive buffer.
+//******************************************************************************************************
+void ServoProtocol::execute() {
+  uint8_t length = rx[0];
+  uint8_t command = rx[1];
+  const uint8_t *payload = &rx[2];
+  tx[2] = command | PROTOCOL_REPLY;
+  switch (command) {
+    case CMD_WRITE:
+      reply(executeWrite(payload, length));
+    break;
+    case CMD_CURVE:
+    case CMD_MOVE:
+    case CMD_QUEUE:
+    case CMD_UPLOAD:
+      reply(executeServo(command, payload, length));
+    break;
+    case CMD_STATUS:
+      if (length != 0) {reply(PROTOCOL_BAD_LENGTH); break;}
+      reply(PROTOCOL_OK);
+      for (uint8_t servo = 0; servo < PROTOCOL_SERVOS; servo++) addStatus(servo);
+    break;
+    case CMD_STATS: {
+      if (length != 0) {reply(PROTOCOL_BAD_LENGTH); break;}
+      servoStats_t stats;
+      reply(PROTOCOL_OK);
+      Servo::getTimerStats(stats);
+      addStats(stats, Servo::getLatencyCount);
+      #if defined(TCA1)
+      Servo1::getTimerStats(stats);
+      addStats(stats, Servo1::getLatencyCount);
+      #else
+      stats.missedFrames = 0;
+      stats.overwrittenValues = 0;
+      stats.maxLatency = 0;
+      addStats(stats, 0);
+      #endif
+      add16(frames);
+      add16(errors);
+    }
+    break;
+    case CMD_RESET_STATS:
+      if (length != 0) {reply(PROTOCOL_BAD_LENGTH); break;}
+      Servo::resetTimerStats();
+      #if defined(TCA1)
+      Servo1::resetTimerStats();
+      #endif
+      reply(PROTOCOL_OK);
+    break;
+    default:
+      reply(PROTOCOL_BAD_COMMAND);
+  }
+}
+
+
+// All servos are checked before the first value is written, so the batch is executed completely
+// or not at all.
+uint8_t ServoProtocol::executeWrite(const uint8_t *payload, uint8_t length) {
+  if ((length == 0) || (length % 3)) return PROTOCOL_BAD_LENGTH;
+  for (uint8_t i = 0; i < length; i += 3) {
+    uint8_t servo = payload[i];
+    if (servo >= PROTOCOL_SERVOS) return PROTOCOL_BAD_SERVO;
+    if ((servo < SERVOS_PER_TIMER) && (servoTCA0[servo] == 0)) return PROTOCOL_BAD_SERVO;
+    #if defined(TCA1)
+    if ((servo >= SERVOS_PER_TIMER) && (servoTCA1[servo - SERVOS_PER_TIMER] == 0)) return PROTOCOL_BAD_SERVO;
+    #else
+    if (servo >= SERVOS_PER_TIMER) return PROTOCOL_BAD_SERVO;
+    #endif
+  }
+  for (uint8_t i = 0; i < length; i += 3) {
+    uint8_t servo = payload[i];
+    uint16_t pulse = payload[i + 1] | (payload[i + 2] << 8);
+    if (servo < SERVOS_PER_TIMER) servoTCA0[servo]->writeMicroseconds(pulse);
+    #if defined(TCA1)
+      else servoTCA1[servo - SERVOS_PER_TIMER]->writeMicroseconds(pulse);
+    #endif
+  }
+  return PROTOCOL_OK;
+}
+
+
+// ServoMoba and ServoMoba1 are different classes, with the same methods
+template <typename T>
+static uint8_t executeOn(T *servo, uint8_t command, const uint8_t *payload, uint8_t length) {
+  switch (command) {
+    case CMD_CURVE:
+      if (length != 3) return PROTOCOL_BAD_LENGTH;
+      if (curveByIndex(payload[1]) == 0) return PROTOCOL_BAD_VALUE;              // Predefined or sketch curve
+      servo->initCurveFromPROGMEM(payload[1], payload[2]);
+    break;
+    case CMD_MOVE:
+      if (length != 3) return PROTOCOL_BAD_LENGTH;
+      servo->moveServoAlongCurve(payload[1], payload[2]);
+    break;
+    case CMD_QUEUE:
+      if (length != 5) return PROTOCOL_BAD_LENGTH;
+      if ((curveByIndex(payload[1]) == 0) && (payload[1] != KEEP_CURVE)) return PROTOCOL_BAD_VALUE;
+      if (!servo->queueMove(payload[1], payload[2], payload[3], payload[4])) return PROTOCOL_QUEUE_FULL;
+    break;
+    case CMD_UPLOAD: {                             // At least two points plus the end marker {0, 0}
+      uint8_t points = (length - 2) / 2;
+      if ((length < 8) || (length & 1) || (points > SIZE_SERVO_CURVE)) return PROTOCOL_BAD_LENGTH;
+      const curvePoint_t *curve = (const curvePoint_t *)&payload[2];
+      if ((curve[points - 1].time != 0) || (curve[points - 1].position != 0)) return PROTOCOL_BAD_VALUE;
+      for (uint8_t i = 1; i < points - 1; i++) {
+        if (curve[i].time == 0) return PROTOCOL_BAD_VALUE;      // Would end the curve too early
+      }
+      servo->initCurveFromRAM(curve, payload[1]);
+    }
+    break;
+  }
+  return PROTOCOL_OK;
+}
+
+
+uint8_t ServoProtocol::executeServo(uint8_t command, const uint8_t *payload, uint8_t length) {
+  if (length == 0) return PROTOCOL_BAD_LENGTH;
+  uint8_t servo = payload[0];
+  if ((servo < SERVOS_PER_TIMER) && servoTCA0[servo]) {
+    return executeOn(servoTCA0[servo], command, payload, length);
+  }
+  #if defined(TCA1)
+  if ((servo >= SERVOS_PER_TIMER) && (servo < PROTOCOL_SERVOS) && servoTCA1[servo - SERVOS_PER_TIMER]) {
+    return executeOn(servoTCA1[servo - SERVOS_PER_TIMER], command, payload, length);
+  }
+  #endif
+  return PROTOCOL_BAD_SERVO;
+}
+
+
+template <typename T>
+static void statusOf(T *servo, uint8_t &state, uint8_t &flags, uint8_t &queued, uint16_t &pulse) {
+  state = servo->getServoState();
+  flags = (servo->attached() ? 1 : 0) | (servo->movementCompleted ? 2 : 0);
+  queued = servo->movesQueued();
+  pulse = servo->readMicroseconds();
+}
+
+
+// Servos that have not been added are reported with state 255 and all other values 0
+void ServoProtocol::addStatus(uint8_t servo) {
+  uint8_t state = 255;
+  uint8_t flags = 0;
+  uint8_t queued = 0;
+  uint16_t pulse = 0;
+  if (servo < SERVOS_PER_TIMER) {
+    if (servoTCA0[servo]) statusOf(servoTCA0[servo], state, flags, queued, pulse);
+  }
+  #if defined(TCA1)
+  else if (servoTCA1[servo - SERVOS_PER_TIMER]) {
+    statusOf(servoTCA1[servo - SERVOS_PER_TIMER], state, flags, queued, pulse);
+  }
+  #endif
+  add8(state);
+  add8(flags);
+  add8(queued);
+  add16(pulse);
+}
+
+
+void ServoProtocol::addStats(const servoStats_t &stats, uint16_t (*latencyCount)(uint8_t)) {
+  add16(stats.missedFrames);
+  add16(stats.overwrittenValues);
+  add16(stats.maxLatency);
+  for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) add16(latencyCount ? latencyCount(i) : 0);
+}
+
+
+//******************************************************************************************************
+// The reply frame. tx[2] (the command) has been set by execute(); the payload starts at tx[3].
+// txLength is the frame length without CRC until sendReply() completes the frame.
+//******************************************************************************************************
+void ServoProtocol::reply(uint8_t result) {
+  tx[0] = PROTOCOL_SYNC;
+  tx[1] = 0;
+  txLength = 3;
+  txSent = 0;
+  add8(result);
+}
+
+
+void ServoProtocol::add8(uint8_t value) {
+  if (tx[1] >= PROTOCOL_MAX_PAYLOAD) return;
+  tx[txLength++] = value;
+  tx[1]++;
+}
+
+
+void ServoProtocol::add16(uint16_t value) {
+  add8(value & 0xFF);
+  add8(value >> 8);
+}
+
+
+void ServoProtocol::sendReply() {
+  if (txLength == 0) return;
+  if (txLength == tx[1] + 3) {                     // Complete the frame with its CRC
+    uint8_t crc = 0;
+    for (uint8_t i = 1; i < txLength; i++) crc = crc8(crc, tx[i]);
+    tx[txLength++] = crc;
+  }
+  txSent += transport.write(&tx[txSent], txLength - txSent);
+  if (txSent >= txLength) {
+    txLength = 0;
+    txSent = 0;
+  }
+}
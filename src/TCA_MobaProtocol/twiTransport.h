@@ -0,0 +1,103 @@
+//******************************************************************************************************
+//
+// file:      twiTransport.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   TWI (I2C) target transport for ServoProtocol. The controller writes request frames to
+//            the target address, and reads the reply frames. Since the controller decides when and
+//            how many bytes it reads, replies are buffered. Bytes that are read while no reply is
+//            available are padding (not 0xA5), which the controller's parser skips while it searches
+//            for the next SYNC byte. The controller should read in blocks of the Wire buffer size
+//            (32 bytes by default): bytes handed to Wire but not read by the controller are lost.
+//
+// The Wire callbacks run in interrupt context. They only copy bytes between the Wire buffers and
+// the two ring buffers below; all parsing and execution is done by ServoProtocol::poll() in the
+// main loop. Only one TwiTransport object can exist, since Wire has a single target address.
+// This file is not included by Servo_TCA_Protocol.h, so the Wire library is only linked in by
+// sketches that actually use this transport:
+//
+//   #include <Servo_TCA_Protocol.h>
+//   #include <TCA_MobaProtocol/twiTransport.h>
+//   TwiTransport twi;
+//   ServoProtocol protocol(twi);
+//   void setup() { twi.begin(0x40); ... }
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include "../Servo_TCA_Protocol.h"
+
+#define TWI_BUFFER_SIZE 64                       // Must be a power of 2, and at most 128
+
+class TwiTransport: public ServoTransport {
+
+  public:
+    TwiTransport() {rxHead = rxTail = txHead = txTail = 0;}
+
+    void begin(uint8_t address) {
+      instance() = this;
+      Wire.onReceive(onReceive);
+      Wire.onRequest(onRequest);
+      Wire.begin(address);
+    }
+
+    int available() {
+      return (uint8_t)(rxHead - rxTail);
+    }
+
+    int read() {
+      if (rxHead == rxTail) return -1;
+      uint8_t data = rxBuffer[rxTail & (TWI_BUFFER_SIZE - 1)];
+      rxTail++;
+      return data;
+    }
+
+    uint8_t write(const uint8_t *data, uint8_t length) {
+      uint8_t space = TWI_BUFFER_SIZE - (uint8_t)(txHead - txTail);
+      if (length > space) length = space;
+      for (uint8_t i = 0; i < length; i++) txBuffer[(txHead + i) & (TWI_BUFFER_SIZE - 1)] = data[i];
+      txHead += length;                          // Only now the ISR may send these bytes
+      return length;
+    }
+
+  private:
+    // Head and tail are free running; each is only changed by one side (ISR or main loop)
+    volatile uint8_t rxHead;
+    volatile uint8_t rxTail;
+    volatile uint8_t txHead;
+    volatile uint8_t txTail;
+    uint8_t rxBuffer[TWI_BUFFER_SIZE];
+    uint8_t txBuffer[TWI_BUFFER_SIZE];
+
+    static TwiTransport *&instance() {
+      static TwiTransport *transport = 0;
+      return transport;
+    }
+
+    // The controller has written bytes. Bytes that do not fit are dropped; the CRC catches that.
+    static void onReceive(int count) {
+      TwiTransport *t = instance();
+      while (Wire.available()) {
+        uint8_t data = Wire.read();
+        if ((uint8_t)(t->rxHead - t->rxTail) < TWI_BUFFER_SIZE) {
+          t->rxBuffer[t->rxHead & (TWI_BUFFER_SIZE - 1)] = data;
+          t->rxHead++;
+        }
+      }
+    }
+
+    // The controller reads. Hand over what we have; Wire itself limits the number of bytes.
+    static void onRequest() {
+      TwiTransport *t = instance();
+      if (t->txHead == t->txTail) {
+        Wire.write((uint8_t)0);
+        return;
+      }
+      while (t->txTail != t->txHead) {
+        if (Wire.write(t->txBuffer[t->txTail & (TWI_BUFFER_SIZE - 1)]) == 0) break;
+        t->txTail++;
+      }
+    }
+};
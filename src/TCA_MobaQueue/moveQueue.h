@@ -0,0 +1,77 @@
+//******************************************************************************************************
+//
+// file:      moveQueue.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Queue of move commands for the ServoMoba and ServoMoba1 classes.
+//            Without a queue, a call to moveServoAlongCurve() while the servo is still moving
+//            restarts the movement; commands that arrive in a burst (for example from a DCC
+//            command station) are therefore lost. With the queue, the commands are stored and
+//            executed one after the other.
+//
+// The queue is a (bounded) single-producer / single-consumer ring buffer:
+// - The producer is the code that calls ServoMoba::queueMove(). This may be the main loop, but also
+//   an interrupt service routine, such as that of a DCC decoder.
+// - The consumer is the servo state machine (checkServo()), which takes the next command from the
+//   queue at the start of a 20ms frame, once the servo is idle.
+// No locks are needed, since the producer only writes "head" and the consumer only writes "tail",
+// and both are single bytes (thus atomic on AVR). Note that this only holds if, per servo, there is
+// a single producer: do not call queueMove() for the same servo from the main loop AND from an ISR.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+#define MOVE_QUEUE_SIZE    4                     // Must be a power of 2
+#define KEEP_CURVE       255                     // Use the curve (and timeStretch) that is already loaded
+
+// A compiler barrier, to ensure the command is stored before head is moved (and read after tail)
+#define queueBarrier() __asm__ __volatile__("" ::: "memory")
+
+typedef struct {                                 // A move command
+  uint8_t curve;                                 // Predefined or sketch curve (see curves.h), or KEEP_CURVE
+  uint8_t direction;                             // See moveServoAlongCurve()
+  uint8_t timeStretch;                           // 1..255
+  uint8_t dwell;                                 // 0..255. Steps are in 20 ms: wait before moving
+} moveCommand_t;
+
+
+class MoveQueue {
+
+  // There is no constructor: the queues are static arrays of servo_TCA0/1_MoBa.cpp, and start empty,
+  // with head and tail 0. Without constructor, they are not linked if queueMove() is not used.
+  public:
+    // Producer side: may be called from the main loop or from an ISR
+    bool push(uint8_t curve, uint8_t direction, uint8_t timeStretch, uint8_t dwell) {
+      uint8_t h = head;
+      if ((uint8_t)(h - tail) >= MOVE_QUEUE_SIZE) return false;   // queue is full
+      moveCommand_t *command = &commands[h & (MOVE_QUEUE_SIZE - 1)];
+      command->curve = curve;
+      command->direction = direction;
+      command->timeStretch = timeStretch;
+      command->dwell = dwell;
+      queueBarrier();
+      head = h + 1;
+      return true;
+    }
+
+    // Consumer side: called by the servo state machine
+    bool pop(moveCommand_t &command) {
+      uint8_t t = tail;
+      if (head == t) return false;                                // queue is empty
+      queueBarrier();
+      command = commands[t & (MOVE_QUEUE_SIZE - 1)];
+      queueBarrier();
+      tail = t + 1;
+      return true;
+    }
+
+    void clear() {tail = head;}                                   // Consumer side
+    uint8_t count() {return (uint8_t)(head - tail);}
+
+  private:
+    moveCommand_t commands[MOVE_QUEUE_SIZE];
+    volatile uint8_t head;                       // Next free position. Written by the producer only
+    volatile uint8_t tail;                       // Oldest command. Written by the consumer only
+};
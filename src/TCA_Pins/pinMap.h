@@ -0,0 +1,231 @@
+//******************************************************************************************************
+//
+// file:      pinMap.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Compile-time (constexpr) map of the pins that the TCA0 and TCA1 Compare Units can drive,
+//            for the Servo (TCA0) and Servo1 (TCA1) classes.
+//            attach(pin) determines the port and Compare Unit of the pin at run time, via
+//            digitalPinToPort(), digitalPinToBitPosition() and a few switch statements; a pin that
+//            can't be used is only noticed once attach() returns INVALID_SERVO on the board.
+//            If the pin is a constant, attach<pin>() does the same check while compiling: an
+//            impossible pin gives a compiler error. The PORTMUX setting and the CTRLB bit of the pin
+//            are constants as well (tca0RouteMask() / tca0RouteValue() and tca1RouteValue()), and
+//            attach<pin>() writes them inline, without the switch statements of attach(pin).
+//
+// The map follows the same rules as initCompareUnit() in the timer headers, and depends on the same
+// definitions of the core and processor (ports that exist, PORTMUX options, _AVR_PINCOUNT):
+// - TCA0, DxCore (DA, DB, DD, DU, EA) and MegaCoreX: Px0, Px1 and Px2 of every port the PORTMUX
+//   can route TCA0 to. All servos must use the same port.
+// - TCA0, megaTinyCore (0, 1 and 2 series): PB0..PB2, or the alternatives PB3..PB5. On 8 pin
+//   processors PA3 (or PA7), PA1 and PA2.
+// - TCA1 (DA, DB, EA with 48 or 64 pins): PB0..PB2 or PC4..PC6; on 64 pin processors also PE4..PE6
+//   and PG0..PG2. All servos must use the same port.
+//
+// tca0PinsFit() and tca1PinsFit() check a complete set of pins: all on one port (where the timer
+// requires that), and each on a different Compare Unit. For example:
+//   static_assert(tca0PinsFit(PIN_PA0, PIN_PA1, PIN_PA2), "Servo pins don't fit on TCA0");
+//
+// The map requires that the core provides digitalPinToPortStatic() and digitalPinToBitPositionStatic().
+// If so, SERVO_PIN_MAP is defined, and a sketch can test on that.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+#define NO_COMPARE_UNIT        255               // The pin can't be driven by the timer
+
+#if defined(digitalPinToPortStatic) && defined(digitalPinToBitPositionStatic)
+#define SERVO_PIN_MAP                            // attach<pin>() and the functions below are available
+
+constexpr uint8_t pinMapPort(uint8_t pin) {return digitalPinToPortStatic(pin);}
+constexpr uint8_t pinMapBit(uint8_t pin) {return digitalPinToBitPositionStatic(pin);}
+
+
+//******************************************************************************************************
+// TCA0
+//******************************************************************************************************
+#if defined(MEGATINYCORE_SERIES)
+constexpr bool tca0OnePort() {return false;}     // Each Compare Unit has its own pin(s)
+
+constexpr uint8_t tca0CompareUnit(uint8_t pin) {
+  #if _AVR_PINCOUNT == 8
+  if (pinMapPort(pin) != PA) return NO_COMPARE_UNIT;
+  switch (pinMapBit(pin)) {
+    case 1: return 1;
+    case 2: return 2;
+    case 3:
+    case 7: return 0;
+  }
+  return NO_COMPARE_UNIT;
+  #else
+  if (pinMapPort(pin) != PB) return NO_COMPARE_UNIT;
+  return (pinMapBit(pin) <= 5) ? pinMapBit(pin) % 3 : NO_COMPARE_UNIT;
+  #endif
+}
+
+// The PORTMUX setting of attach<pin>(), as initCompareUnit(): each Compare Unit has its own bit, which
+// is set for the alternative pin (PB3..PB5, or PA7 on 8 pin processors)
+#if defined(PORTMUX_TCAROUTEA)                  // 2 series
+#define TCA0_ROUTE PORTMUX.TCAROUTEA
+#else                                            // 0 and 1 series
+#define TCA0_ROUTE PORTMUX.CTRLC
+#endif
+
+constexpr uint8_t tca0RouteMask(uint8_t pin) {
+  return (tca0CompareUnit(pin) == 0) ? PORTMUX_TCA0_0_bm :
+         (tca0CompareUnit(pin) == 1) ? PORTMUX_TCA0_1_bm : PORTMUX_TCA0_2_bm;
+}
+
+constexpr uint8_t tca0RouteValue(uint8_t pin) {
+  #if _AVR_PINCOUNT == 8
+  return (pinMapBit(pin) == 7) ? tca0RouteMask(pin) : 0;
+  #else
+  return (pinMapBit(pin) >= 3) ? tca0RouteMask(pin) : 0;
+  #endif
+}
+
+#else                                            // DxCore and MegaCoreX
+constexpr bool tca0OnePort() {return true;}
+
+constexpr bool tca0Routable(uint8_t port) {     // As initMultiplexer()
+  return (port == PA)
+    #ifdef PORTB
+    || (port == PB)
+    #endif
+    || (port == PC) || (port == PD)
+    #ifdef PORTE
+    || (port == PE)
+    #endif
+    || (port == PF)
+    #ifdef PORTG
+    || (port == PG)
+    #endif
+    ;
+}
+
+constexpr uint8_t tca0CompareUnit(uint8_t pin) {
+  if (!tca0Routable(pinMapPort(pin))) return NO_COMPARE_UNIT;
+  return (pinMapBit(pin) <= 2) ? pinMapBit(pin) : NO_COMPARE_UNIT;
+}
+
+// The PORTMUX setting of attach<pin>(), as initMultiplexer(): the TCA0 bits select the port
+#define TCA0_ROUTE PORTMUX.TCAROUTEA
+
+constexpr uint8_t tca0RouteMask(uint8_t pin) {return PORTMUX_TCA0_gm;}
+
+constexpr uint8_t tca0RouteValue(uint8_t pin) {
+  switch (pinMapPort(pin)) {
+    case PA: return PORTMUX_TCA0_PORTA_gc;
+    #ifdef PORTB
+    case PB: return PORTMUX_TCA0_PORTB_gc;
+    #endif
+    case PC: return PORTMUX_TCA0_PORTC_gc;
+    case PD: return PORTMUX_TCA0_PORTD_gc;
+    #ifdef PORTE
+    case PE: return PORTMUX_TCA0_PORTE_gc;
+    #endif
+    case PF: return PORTMUX_TCA0_PORTF_gc;
+    #ifdef PORTG
+    case PG: return PORTMUX_TCA0_PORTG_gc;
+    #endif
+  }
+  return 0;
+}
+#endif
+
+
+//******************************************************************************************************
+// TCA1
+//******************************************************************************************************
+#if defined(TCA1)
+constexpr bool tca1OnePort() {return true;}
+
+constexpr bool tca1Routable(uint8_t port) {     // As initMultiplexer()
+  return false
+    #ifdef PORTMUX_TCA1_PORTA_gc
+    || (port == PA)
+    #endif
+    || (port == PB) || (port == PC)
+    #ifdef PORTMUX_TCA1_PORTD_gc
+    || (port == PD)
+    #endif
+    #ifdef PORTMUX_TCA1_PORTE_gc
+    || (port == PE)
+    #endif
+    #ifdef PORTMUX_TCA1_PORTG_gc
+    || (port == PG)
+    #endif
+    ;
+}
+
+constexpr uint8_t tca1CompareUnit(uint8_t pin) {  // As enableCompareUnit()
+  if (!tca1Routable(pinMapPort(pin))) return NO_COMPARE_UNIT;
+  uint8_t first = NO_COMPARE_UNIT;               // Bit of Compare Unit 0 on this port
+  switch (pinMapPort(pin)) {
+    case PB: first = 0; break;
+    case PC: first = 4; break;
+    #if _AVR_PINCOUNT == 64
+    case PE: first = 4; break;
+    case PG: first = 0; break;
+    #endif
+  }
+  if ((first == NO_COMPARE_UNIT) || (pinMapBit(pin) < first) || (pinMapBit(pin) > first + 2)) {
+    return NO_COMPARE_UNIT;
+  }
+  return pinMapBit(pin) - first;
+}
+
+// The PORTMUX setting of attach<pin>(), as initMultiplexer(): the TCA1 bits select the port
+constexpr uint8_t tca1RouteValue(uint8_t pin) {
+  switch (pinMapPort(pin)) {
+    #ifdef PORTMUX_TCA1_PORTA_gc
+    case PA: return PORTMUX_TCA1_PORTA_gc;
+    #endif
+    case PB: return PORTMUX_TCA1_PORTB_gc;
+    case PC: return PORTMUX_TCA1_PORTC_gc;
+    #ifdef PORTMUX_TCA1_PORTD_gc
+    case PD: return PORTMUX_TCA1_PORTD_gc;
+    #endif
+    #ifdef PORTMUX_TCA1_PORTE_gc
+    case PE: return PORTMUX_TCA1_PORTE_gc;
+    #endif
+    #ifdef PORTMUX_TCA1_PORTG_gc
+    case PG: return PORTMUX_TCA1_PORTG_gc;
+    #endif
+  }
+  return 0;
+}
+#endif
+
+
+//******************************************************************************************************
+// Checks of a complete set of pins
+//******************************************************************************************************
+constexpr bool pinMapFits(const uint8_t *pins, const uint8_t *units, uint8_t count, bool onePort) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (units[i] == NO_COMPARE_UNIT) return false;
+    for (uint8_t j = 0; j < i; j++) {
+      if (units[i] == units[j]) return false;
+      if (onePort && (pinMapPort(pins[i]) != pinMapPort(pins[j]))) return false;
+    }
+  }
+  return true;
+}
+
+template <typename... P> constexpr bool tca0PinsFit(P... pin) {
+  const uint8_t pins[] = {(uint8_t)pin...};
+  const uint8_t units[] = {tca0CompareUnit(pin)...};
+  return pinMapFits(pins, units, sizeof...(pin), tca0OnePort());
+}
+
+#if defined(TCA1)
+template <typename... P> constexpr bool tca1PinsFit(P... pin) {
+  const uint8_t pins[] = {(uint8_t)pin...};
+  const uint8_t units[] = {tca1CompareUnit(pin)...};
+  return pinMapFits(pins, units, sizeof...(pin), tca1OnePort());
+}
+#endif
+
+#endif   // digitalPinToPortStatic
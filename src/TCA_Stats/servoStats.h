@@ -0,0 +1,36 @@
+//******************************************************************************************************
+//
+// file:      servoStats.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Service statistics for the Servo (TCA0) and Servo1 (TCA1) classes.
+//            If the main loop is too slow, problems remain hidden: ServoMoba moves slower along its
+//            curve if a 20 ms frame is missed, and if writeMicroseconds() is called more than once
+//            per frame, only the last value reaches the servo. The counters below show whether
+//            the main loop of a decoder is overloaded, long before sluggish turnouts are noticed.
+//
+// Per servo the following is counted:
+// - missedFrames:      the ISR started a new pulse, while the main loop had not yet reacted on the
+//                      previous one (by calling writeMicroseconds() or waitTillNextPulse())
+// - overwrittenValues: writeMicroseconds() replaced a value that the ISR had not yet used
+// - maxLatency:        the longest time (in us) between the start of a pulse and the reaction of the
+//                      main loop on that pulse
+// Per timer a latency histogram is kept, with the buckets below 1, 2, 5, 10 and 20 ms, plus a
+// bucket for 20 ms and more (which means that a frame was missed).
+//
+// The ISR only increments missedFrames; the rest is counted by writeMicroseconds() and
+// waitTillNextPulse(). The counters saturate at 65535. Note that these statistics are only
+// meaningful for sketches that react on every pulse, such as sketches that use ServoMoba.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+#define LATENCY_BUCKETS 6                        // < 1, < 2, < 5, < 10, < 20 and >= 20 ms
+
+typedef struct {
+  uint16_t missedFrames;                         // Pulses the main loop did not react on
+  uint16_t overwrittenValues;                    // Values written before the previous one was used
+  uint16_t maxLatency;                           // In us
+} servoStats_t;
@@ -0,0 +1,97 @@
+//******************************************************************************************************
+//
+// file:      trace.cpp
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Optional trace facility for the servo ISRs and the ServoMoba state machines.
+//            See trace.h for details
+//
+// The ring buffer is written by add(), and read by dump(). head is the position of the next record
+// to write, tail the oldest record that has not yet been dumped. If the buffer is full, the oldest
+// record is overwritten; dump() then continues with the oldest record that is still available.
+// Since add() may be called from an ISR as well as from the main loop, interrupts are disabled for
+// the few instructions needed to store a record.
+//
+//******************************************************************************************************
+#include <Arduino.h>
+#include "trace.h"
+
+#if defined(SERVO_TRACE)
+
+#define TRACE_MASK (SERVO_TRACE_SIZE - 1)
+#define MIN_OUTPUT_SPACE 24                      // Characters needed to print a single record
+
+static traceRecord_t records[SERVO_TRACE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint16_t lostRecords = 0;
+static volatile bool frozen = false;
+
+static const char *eventNames[] = {
+  "isr", "move", "pop", "start", "segment", "finish", "idle", "powerOn", "powerOff", "settle", "stall"
+};
+
+
+void ServoTrace::add(uint16_t frame, uint8_t servo, uint8_t event, uint16_t value) {
+  uint8_t oldSREG = SREG;
+  cli();
+  if (!frozen) {
+    traceRecord_t *record = &records[head & TRACE_MASK];
+    record->frame = frame;
+    record->servo = servo;
+    record->event = event;
+    record->value = value;
+    head++;
+    if ((uint8_t)(head - tail) > SERVO_TRACE_SIZE) {   // The oldest record has been overwritten
+      tail++;
+      lostRecords++;
+    }
+  }
+  SREG = oldSREG;
+}
+
+
+// dump() prints records as long as the output has room for them, so it never waits for the serial
+// port. It should be called from the main loop, when there is nothing else to do.
+uint8_t ServoTrace::dump(Print &output) {
+  uint8_t printed = 0;
+  while (available() && (output.availableForWrite() >= MIN_OUTPUT_SPACE)) {
+    uint8_t oldSREG = SREG;
+    cli();
+    traceRecord_t record = records[tail & TRACE_MASK];
+    tail++;
+    SREG = oldSREG;
+    output.print(record.frame);
+    output.print(' ');
+    output.print(record.servo);
+    output.print(' ');
+    if (record.event < sizeof(eventNames) / sizeof(eventNames[0])) output.print(eventNames[record.event]);
+      else output.print(record.event);
+    output.print(' ');
+    output.println(record.value);
+    printed++;
+  }
+  return printed;
+}
+
+
+uint8_t ServoTrace::available() {
+  return (uint8_t)(head - tail);
+}
+
+
+uint16_t ServoTrace::lost() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t result = lostRecords;
+  SREG = oldSREG;
+  return result;
+}
+
+
+void ServoTrace::freeze(bool on) {
+  frozen = on;
+}
+
+#endif
@@ -0,0 +1,75 @@
+//******************************************************************************************************
+//
+// file:      trace.h
+// author:    Aiko Pras
+// history:   2025-07-01 V1.0.0 ap initial version
+//
+// purpose:   Optional trace facility for the servo ISRs and the ServoMoba state machines.
+//            Serial prints within the ISR or the state machine take far too long, and change the
+//            timing that is being investigated. Instead, events are stored as small records in a
+//            ring buffer in RAM. The main loop may later, once it has nothing else to do, send these
+//            records to Serial (or any other Print object) using dump().
+//            Since the ring buffer keeps the most recent events, it is well suited to find out what
+//            happened just before a rare problem (such as a turnout that jerks once an hour).
+//
+// The trace facility is switched off by default, and costs nothing in that case: all calls to
+// ServoTrace::add() are then empty inline functions. To switch it on, remove the comment before the
+// #define SERVO_TRACE below (or add -DSERVO_TRACE to the compiler flags). Each record takes 6 bytes
+// of RAM; the number of records is set by SERVO_TRACE_SIZE.
+//
+// Each record contains:
+// - frame: the frame counter of the timer (see Servo::getFrame()); a frame lasts 20 ms
+// - servo: 0..2 for servos on TCA0, 3..5 for servos on TCA1
+// - event: see traceEvent_t below
+// - value: depends on the event. For traceIsrPulse the timer ticks, for most others the pulse in us
+//
+// ServoTrace::add() may be called from the main loop as well as from an ISR.
+//
+//******************************************************************************************************
+#pragma once
+#include <Arduino.h>
+
+// #define SERVO_TRACE                           // Uncomment to switch tracing on
+#ifndef SERVO_TRACE_SIZE
+#define SERVO_TRACE_SIZE 32                      // Number of records. Must be a power of 2
+#endif
+
+enum traceEvent_t {
+  traceIsrPulse,                                 // The ISR loaded a new (different) pulse width
+  traceMove,                                     // moveServoAlongCurve(); value is the direction
+  traceQueuePop,                                 // A queued move was started; value is the curve
+  traceStart,                                    // Moving along the curve starts
+  traceSegment,                                  // The next curve segment; value is the segment index
+  traceFinish,                                   // The last curve point has been reached
+  traceIdle,                                     // Back in idle state
+  tracePowerOn,
+  tracePowerOff,
+  traceSettle,                                   // Feedback reached the target; value is the sample
+  traceStall                                     // Stall detected, power cut; value is the sample
+};
+
+typedef struct {
+  uint16_t frame;
+  uint8_t servo;
+  uint8_t event;
+  uint16_t value;
+} traceRecord_t;
+
+
+class ServoTrace {
+
+  public:
+#if defined(SERVO_TRACE)
+    static void add(uint16_t frame, uint8_t servo, uint8_t event, uint16_t value);
+    static uint8_t dump(Print &output);          // Non blocking: returns the number of records printed
+    static uint8_t available();                  // Number of records not yet dumped
+    static uint16_t lost();                      // Records that were overwritten before being dumped
+    static void freeze(bool on);                 // While frozen, new events are ignored
+#else
+    static inline void add(uint16_t, uint8_t, uint8_t, uint16_t) {}
+    static inline uint8_t dump(Print &) {return 0;}
+    static inline uint8_t available() {return 0;}
+    static inline uint16_t lost() {return 0;}
+    static inline void freeze(bool) {}
+#endif
+};
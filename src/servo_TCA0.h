@@ -34,7 +34,8 @@
 // Attach initialises the TCA timer, if it was not already initialized during an earlier attach for
 // another servo object. Once initialised, the TCA timer will never be stopped, even if all servo
 // objects got detached. Therefore TCA timer interrupts keep occuring every 6,67 microseconds 
-// (= REFRESH_INTERVAL / SERVOS_PER_TIMER).
+// (= REFRESH_INTERVAL / SERVOS_PER_TIMER), except while all servos output a constant level (see
+// needFrames() below).
 //
 // Attach initialises the multiplexer, that connects the output of the Compare Unit to the 
 // port to which the specified pin belongs. For DxCore processors, all servos must use the same port.
@@ -45,6 +46,9 @@
 //******************************************************************************************************
 #pragma once
 #include <Arduino.h>
+#include "TCA_Stats/servoStats.h"
+#include "TCA_Calibration/calibration.h"
+#include "TCA_Pins/pinMap.h"
 
 
 //******************************************************************************************************
@@ -60,6 +64,9 @@
 #define REFRESH_INTERVAL       19999L   // minumim time to refresh servos in microseconds (UL is needed to avoid overflow)
 #define SERVOS_PER_TIMER           3     // the maximum number of servos controlled by one TCA timer
 #define INVALID_SERVO            255     // flag indicating an invalid servo index
+#define MAX_SLEW_SPEED          6000     // fastest speed (us per second) for setMaxSlew()
+#define SYNC_OFF                 255     // syncFrames(SYNC_OFF) switches the frame synchronisation off
+#define SYNC_MARGIN             4000     // time (us) between the start of slot 0 and the sync event
 
 #define MAX_SERVOS (SERVOS_PER_TIMER)    // Equals the number of Compare Units on TCA
 
@@ -81,6 +88,67 @@
 // This can be useful to implement different types of soft-start for servo's. 
 // A subsequent write() / writeMicroseconds() can be used to resume the output of pulses.
 //
+// readyServos() returns, as a bit mask indexed by servoIndex, which servos have received a new pulse
+// since the previous call. It allows a scheduler (such as ServoGroup) to test all servos of this
+// timer at once, instead of calling acceptsNewValue() for each of them. With a mask, only the bits
+// of these servos are returned and cleared; the bits of other servos remain for other callers.
+//
+// getFrame() returns the number of 20 ms frames the ISR has completed since the timer was started.
+// The counter wraps around after 65536 frames (almost 22 minutes). It is used to timestamp trace
+// records (see TCA_Trace/trace.h), but may also be used by the sketch.
+// getPulseFrame() returns the frame in which the latest pulse of this servo was started. The
+// difference between two calls tells how many frames have passed, even if the main loop was late.
+// getSlotServo() returns the servoIndex of the servo whose pulse slot is running (ahead = 0) or will
+// start next (ahead = 1), or INVALID_SERVO if that slot is not used. It is meant for code that acts
+// within the slots of the servos, such as the feedback sampling of TCA_MobaFeedback/feedback.h.
+// canAttach() tells if attach() would accept the pin: the pin can be driven by this timer (and port),
+// and its Compare Unit is not yet used by another servo. It changes nothing, and is used by ServoPool
+// (see Servo_TCA_Pool.h) to find a timer for a pin.
+//
+// attach<pin>() is the same as attach(pin), for pins that are known while compiling, such as
+// attach<PIN_PB0>(). The compiler checks if TCA0 can drive the pin, and gives an error if not. The
+// PORTMUX and CTRLB values of the pin are constants (see TCA_Pins/pinMap.h), which attach<pin>()
+// writes inline; only the check of the port and the bookkeeping of the servo remain out of line
+// (attachBegin() and attachEnd()). Available if SERVO_PIN_MAP is defined.
+//
+// setMaxSlew() limits the speed (in us per second) with which the pulse width of this servo changes.
+// After a write the ISR moves the pulse width once per frame towards the new value, using a fixed
+// point step, until it is reached; isMoving() tells if that is still the case, and readMicroseconds()
+// returns the pulse width that is currently output. The main loop thus needs no intermediate writes
+// for slow movements, and a late main loop doesn't change their speed. writeMicroseconds(value, speed)
+// sets the limit and writes in one call. A speed of 0 (the default) removes the limit; speeds above
+// MAX_SLEW_SPEED are reduced to it. Writes before attach() and the first write after constantOutput()
+// are not limited, since there is no position to start from.
+// Servos that follow a curve (ServoMoba) should not have a limit.
+//
+// syncFrames() locks the 20 ms frames of this timer to an external event, such as a pin that
+// receives the sync pulse of a camera or of another controller. The sketch routes the event to an
+// event system channel, and passes the number of that channel. The timer restarts its counter on each
+// event; the first slot of the frame starts SYNC_MARGIN before the event. It doesn't wait for the
+// event: it returns true once armed, and false if the processor doesn't support it (such as the
+// megaAVR 0-series and the tinyAVR 0/1-series). isSynced() then tells if the frames have locked; call
+// it often, since it looks for a restart of the counter between two calls. Call syncFrames() before
+// attach(); see the README.
+//
+// The ISR switches its own interrupt off while all attached servos output a constant level (see
+// constantOutput()), and the next write() / writeMicroseconds() / constantOutput() switches it on
+// again; the outputs don't change meanwhile. While the ISR is suspended the frame counters stop, so
+// acceptsNewValue(), readyServos(), getFrame() and getPulseFrame() don't change. needFrames(true)
+// keeps the ISR running for a servo whose frames the main loop relies on, also while its output is
+// constant. isSuspended() tells if the ISR of this timer is suspended.
+//
+// setFollower() lets the ISR of TCA0 also handle the slots of TCA1; it is used by Servo1::followTCA0()
+// (see servo_TCA1.h), and is not meant to be called by the sketch.
+//
+// setCalibration() lets every write of this servo pass through a calibration table, to correct for
+// the nonlinearity of the servo; see TCA_Calibration/calibration.h. A null pointer removes it.
+// readMicroseconds() and read() of a calibrated servo return the value as written, not the calibrated
+// pulse width that is output (while a slew rate limit moves the servo, that is the value it moves to).
+// The calibration is not kept in the servo object, but per servoIndex in servo_TCA0.cpp.
+//
+// getStats() and getTimerStats() tell if the main loop reacts in time on each new pulse; see
+// TCA_Stats/servoStats.h. getLatencyCount() returns one bucket of the latency histogram.
+//
 // A user sketch can check the existance of these new methods, by checking if ACCEPTS_NEW_VALUES and/or
 // CONSTANT_OUTPUT are defined.
 //******************************************************************************************************
@@ -90,18 +158,58 @@ class Servo {
     Servo();                                       // constructor
     uint8_t attach(uint8_t pin);                   // attach channel to a Compare Unit, sets pinMode, returns servoIndex or INVALID_SERVO
     uint8_t attach(uint8_t pin, int min, int max); // as above but also sets min and max values (in us) for writes.
+    #if defined(SERVO_PIN_MAP)
+    template <uint8_t pin> uint8_t attach() {      // New for the servo_TCA library: as attach(pin), checked while compiling
+      static_assert(tca0CompareUnit(pin) != NO_COMPARE_UNIT, "TCA0 can't drive this pin");
+      constexpr uint8_t compareUnit = tca0CompareUnit(pin);
+      if (!attachBegin(pinMapPort(pin), compareUnit)) return INVALID_SERVO;
+      TCA0_ROUTE = (TCA0_ROUTE & ~tca0RouteMask(pin)) | tca0RouteValue(pin);
+      TCA0.SINGLE.CTRLB |= (TCA_SINGLE_CMP0EN_bm << compareUnit);
+      pinMode(pin, OUTPUT);
+      return attachEnd();
+    }
+    template <uint8_t pin> uint8_t attach(int min, int max) {
+      setLimits(min, max);
+      return attach<pin>();
+    }
+    #endif
     void detach();
     void write(uint16_t value);                    // a value < MIN_PULSE_WIDTH is treated as an angle, otherwise as pulse width in microseconds
     void writeMicroseconds(uint16_t value);        // Write pulse width in microseconds
+    void writeMicroseconds(uint16_t value, uint16_t speed); // New for the servo_TCA library: move with speed (us/s), see setMaxSlew()
+    void setMaxSlew(uint16_t speed);               // New for the servo_TCA library: us per second, 0 = no limit
+    bool isMoving();                               // New for the servo_TCA library: true while the ISR moves to the latest value
     int read();                                    // returns current pulse width as an angle between 0 and 180 degrees
     uint16_t readMicroseconds();                   // returns current pulse width in microseconds
     bool attached();                               // return true if this servo is attached, otherwise false
     bool acceptsNewValue();                        // New for the servo_TCA library: to avoid the delays(15), as seen in several examples.
     void waitTillNextPulse();                      // New for the servo_TCA library
     void constantOutput(uint8_t on_off);           // New for the servo_TCA library: sets output signal 5V (1) or 0V (0)
+    void needFrames(bool need);                    // New for the servo_TCA library: keep the ISR running for this servo
+    static bool isSuspended();                     // New for the servo_TCA library: true while the ISR is switched off
+    uint8_t getServoIndex();                       // New for the servo_TCA library: returns the servoIndex
+    static uint8_t readyServos(uint8_t mask = 0xFF); // New for the servo_TCA library: see acceptsNewValue()
+    static uint16_t getFrame();                    // New for the servo_TCA library: frames (of 20 ms) since start
+    static uint8_t getSlotServo(uint8_t ahead);    // New for the servo_TCA library: servo of the running (0) or next (1) slot
+    static bool canAttach(uint8_t pin);            // New for the servo_TCA library: true if attach(pin) would succeed
+    static bool syncFrames(uint8_t eventChannel);  // New for the servo_TCA library: lock the frames to an event channel, or SYNC_OFF
+    static bool isSynced();                        // New for the servo_TCA library: true once the frames are locked (see syncFrames())
+    #if defined(TCA1)
+    static bool setFollower(bool follow);          // New for the servo_TCA library: used by Servo1::followTCA0()
+    #endif
+    uint16_t getPulseFrame();                      // New for the servo_TCA library: frame of the latest pulse
+    void getStats(servoStats_t &stats);            // New for the servo_TCA library: statistics for this servo
+    void resetStats();                             // New for the servo_TCA library
+    static void getTimerStats(servoStats_t &stats); // New for the servo_TCA library: statistics for all servos of this timer
+    static uint16_t getLatencyCount(uint8_t bucket); // New for the servo_TCA library: 0 .. LATENCY_BUCKETS-1
+    static void resetTimerStats();                 // New for the servo_TCA library: all servos and the histogram
+    void setCalibration(ServoCalibration *calibration); // New for the servo_TCA library: 0 = no calibration
 
   private:
     uint8_t servoIndex;                            // index into the channels[] array
     int8_t min;                                    // minimum is this value times 4 added to MIN_PULSE_WIDTH
     int8_t max;                                    // maximum is this value times 4 added to MAX_PULSE_WIDTH
+    void setLimits(int min, int max);              // sets min and max, see attach(pin, min, max)
+    bool attachBegin(uint8_t port, uint8_t compareUnit); // for attach<pin>(): checks the port, stores the Compare Unit
+    uint8_t attachEnd();                           // for attach<pin>(): activates the servo
 };